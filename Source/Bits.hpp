@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include "Config.hpp"
+#include <cstdint>
+
+#if defined(YPMSVC)
+#include <intrin.h>
+#endif
+
+//MSVC 的 __popcnt64 在不支持 POPCNT 的 CPU 上是非法指令，编译器也不会检测，
+//所以只在定义了 YPPOPCNT 或开启了 /arch:AVX（支持 AVX 的 CPU 都有 POPCNT）时使用。
+#if defined(YPMSVC) && defined(_M_X64) && (defined(YPPOPCNT) || defined(__AVX__))
+#define YPBITS_POPCNT
+#endif
+
+namespace Yupei
+{
+    //与 C++20 的 std::countl_zero 相同，x 为 0 时返回 64。
+    inline int countl_zero(std::uint64_t x) noexcept
+    {
+        if (x == 0) return 64;
+#if defined(YPMSVC) && defined(_M_X64)
+        unsigned long index;
+        _BitScanReverse64(&index, x);
+        return 63 - static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(x);
+#else
+        int n = 0;
+        for (auto bit = std::uint64_t{1} << 63; (x & bit) == 0; bit >>= 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    //与 C++20 的 std::countr_zero 相同，x 为 0 时返回 64。
+    inline int countr_zero(std::uint64_t x) noexcept
+    {
+        if (x == 0) return 64;
+#if defined(YPMSVC) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(x);
+#else
+        int n = 0;
+        for (; (x & 1) == 0; x >>= 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    //与 C++20 的 std::popcount 相同。
+    inline int popcount(std::uint64_t x) noexcept
+    {
+#if defined(YPBITS_POPCNT)
+        return static_cast<int>(__popcnt64(x));
+#elif defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        x = x - ((x >> 1) & 0x5555555555555555u);
+        x = (x & 0x3333333333333333u) + ((x >> 2) & 0x3333333333333333u);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Fu;
+        return static_cast<int>((x * 0x0101010101010101u) >> 56);
+#endif
+    }
+
+    //x 中第 k 个（从 0 开始）为 1 的位的下标，要求 k < popcount(x)。
+    inline int select_bit(std::uint64_t x, int k) noexcept
+    {
+        for (; k > 0; --k)
+            x &= x - 1;
+        return countr_zero(x);
+    }
+}
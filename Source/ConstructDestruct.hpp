@@ -3,6 +3,7 @@
 #include "Ranges/Xrange.hpp"
 #include <utility>  //for std::forward
 #include <type_traits>
+#include <cstring>  //for std::memcpy
 
 namespace Yupei
 {
@@ -40,6 +41,57 @@ namespace Yupei
         Internal::DestroyNImp(ptr, count, std::is_trivially_destructible<ObjectT>());
     }
 
+    //可以直接按字节搬到别处、且搬走后不必析构源对象的类型。
+    //默认只包括 trivially copyable 的类型，只持有指针之类的类型可以特化为 std::true_type 来启用 memcpy。
+    template<typename ObjectT>
+    struct is_trivially_relocatable : std::is_trivially_copyable<ObjectT> {};
+
+    template<typename ObjectT>
+    constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<ObjectT>::value;
+
+    //把 [first, first + count) 移动（移动构造可能抛出异常时改为复制）到未初始化的 dest，源对象不析构。
+    //出错时析构已构造的元素再重新抛出。
+    template<typename ObjectT>
+    void uninitialized_move_if_noexcept_n(ObjectT* first, std::size_t count, ObjectT* dest)
+    {
+        std::size_t i {};
+        try
+        {
+            for (; i < count; ++i)
+                Yupei::construct(dest + i, std::move_if_noexcept(first[i]));
+        }
+        catch (...)
+        {
+            Yupei::destroy_n(dest, i);
+            throw;
+        }
+    }
+
+    namespace Internal
+    {
+        template<typename ObjectT>
+        void RelocateNImp(ObjectT* first, std::size_t count, ObjectT* dest, std::true_type) noexcept
+        {
+            if (count != 0)
+                std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), count * sizeof(ObjectT));
+        }
+
+        //移动构造可能抛出异常时改为复制，出错时析构已构造的元素，源保持不变。
+        template<typename ObjectT>
+        void RelocateNImp(ObjectT* first, std::size_t count, ObjectT* dest, std::false_type)
+        {
+            Yupei::uninitialized_move_if_noexcept_n(first, count, dest);
+            Yupei::destroy_n(first, count);
+        }
+    }
+
+    //把 [first, first + count) 搬到未初始化的 dest 并结束源对象的生存期，两段内存不能重叠。
+    template<typename ObjectT>
+    void relocate_n(ObjectT* first, std::size_t count, ObjectT* dest) noexcept(is_trivially_relocatable_v<ObjectT> || std::is_nothrow_move_constructible<ObjectT>::value)
+    {
+        Internal::RelocateNImp(first, count, dest, is_trivially_relocatable<ObjectT>());
+    }
+
     template<typename ObjectT, typename... ParamsT>
     ObjectT* construct_n(ObjectT* ptr, std::size_t count, ParamsT&&... param) noexcept(std::is_nothrow_constructible<ObjectT, ParamsT&&...>::value)
     {
@@ -0,0 +1,630 @@
+﻿#pragma once
+
+#include "../Assert.hpp"
+#include "../Bits.hpp"
+#include "../Config.hpp"
+#include "../Scope.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "Vector.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if (defined(YPMSVC) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))) || defined(__SSE2__)
+#define YPBITVECTOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Yupei
+{
+    namespace Internal
+    {
+        enum class BitOp
+        {
+            And,
+            Or,
+            Xor,
+            AndNot
+        };
+
+        template<BitOp Op>
+        inline std::uint64_t ApplyBitOp(std::uint64_t lhs, std::uint64_t rhs) noexcept
+        {
+            switch (Op)
+            {
+            case BitOp::And:
+                return lhs & rhs;
+            case BitOp::Or:
+                return lhs | rhs;
+            case BitOp::Xor:
+                return lhs ^ rhs;
+            default:
+                return lhs & ~rhs;
+            }
+        }
+
+#ifdef YPBITVECTOR_SSE2
+        template<BitOp Op>
+        inline __m128i ApplyBitOp(__m128i lhs, __m128i rhs) noexcept
+        {
+            switch (Op)
+            {
+            case BitOp::And:
+                return _mm_and_si128(lhs, rhs);
+            case BitOp::Or:
+                return _mm_or_si128(lhs, rhs);
+            case BitOp::Xor:
+                return _mm_xor_si128(lhs, rhs);
+            default:
+                return _mm_andnot_si128(rhs, lhs);
+            }
+        }
+#endif
+
+        //dest[i] = dest[i] Op src[i]。有 SSE2 时每次处理 4 个字，剩下的逐字处理。
+        template<BitOp Op>
+        inline void BitwiseWords(std::uint64_t* dest, const std::uint64_t* src, std::size_t n) noexcept
+        {
+            std::size_t i {};
+#ifdef YPBITVECTOR_SSE2
+            for (; i + 4 <= n; i += 4)
+            {
+                const auto d = reinterpret_cast<__m128i*>(dest + i);
+                const auto s = reinterpret_cast<const __m128i*>(src + i);
+                const auto lo = ApplyBitOp<Op>(_mm_loadu_si128(d), _mm_loadu_si128(s));
+                const auto hi = ApplyBitOp<Op>(_mm_loadu_si128(d + 1), _mm_loadu_si128(s + 1));
+                _mm_storeu_si128(d, lo);
+                _mm_storeu_si128(d + 1, hi);
+            }
+#endif
+            for (; i < n; ++i)
+                dest[i] = ApplyBitOp<Op>(dest[i], src[i]);
+        }
+
+        //用 4 个累加器打断依赖链，让多个 popcnt 并行执行。
+        inline std::size_t PopcountWords(const std::uint64_t* words, std::size_t n) noexcept
+        {
+            std::size_t c0 {}, c1 {}, c2 {}, c3 {};
+            std::size_t i {};
+            for (; i + 4 <= n; i += 4)
+            {
+                c0 += Yupei::popcount(words[i]);
+                c1 += Yupei::popcount(words[i + 1]);
+                c2 += Yupei::popcount(words[i + 2]);
+                c3 += Yupei::popcount(words[i + 3]);
+            }
+            for (; i < n; ++i)
+                c0 += Yupei::popcount(words[i]);
+            return c0 + c1 + c2 + c3;
+        }
+    }
+
+    //每个 bool 只占一位的紧凑位集，按 64 位的字存储，内存从 memory_resource 分配。
+    //最后一个字中超出 size() 的位始终为 0，所以 count 与按字的批量运算不需要特殊处理结尾。
+    //需要 rank/select 时在构造完成后另建一个 bit_rank_select。
+    class bit_vector
+    {
+    public:
+        using word_type = std::uint64_t;
+        using size_type = std::size_t;
+        using allocator_type = polymorphic_allocator<word_type>;
+
+        static constexpr size_type word_bits = 64;
+        static constexpr size_type npos = size_type(-1);
+
+        bit_vector() noexcept
+            :words_ {}, size_ {}, wordCapacity_ {}
+        {}
+
+        explicit bit_vector(memory_resource_ptr resource) noexcept
+            :words_ {}, size_ {}, wordCapacity_ {}, allocator_ { resource }
+        {}
+
+        explicit bit_vector(size_type n, bool value = false, memory_resource_ptr resource = {})
+            :bit_vector(resource)
+        {
+            resize(n, value);
+        }
+
+        bit_vector(const bit_vector& other)
+            :bit_vector(other.allocator_.resource())
+        {
+            if (other.word_count() == 0) return;
+            Reallocate(other.word_count());
+            std::memcpy(words_, other.words_, other.word_count() * sizeof(word_type));
+            size_ = other.size_;
+        }
+
+        bit_vector(bit_vector&& other) noexcept
+            :words_ { other.words_ }, size_ { other.size_ }, wordCapacity_ { other.wordCapacity_ }, allocator_ { other.allocator_ }
+        {
+            other.words_ = {};
+            other.size_ = {};
+            other.wordCapacity_ = {};
+        }
+
+        bit_vector& operator=(const bit_vector& other)
+        {
+            if (this != &other)
+                bit_vector(other).swap(*this);
+            return *this;
+        }
+
+        //要求两边的分配器相等。
+        bit_vector& operator=(bit_vector&& other) noexcept
+        {
+            if (this != &other)
+                bit_vector(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~bit_vector()
+        {
+            if (words_ != nullptr)
+                allocator_.deallocate(words_, wordCapacity_);
+        }
+
+        //要求两边的分配器相等。
+        void swap(bit_vector& other) noexcept
+        {
+            YPASSERT(allocator_.resource() == other.allocator_.resource(), "Allocators of swapped bit_vectors must be equal.");
+            std::swap(words_, other.words_);
+            std::swap(size_, other.size_);
+            std::swap(wordCapacity_, other.wordCapacity_);
+        }
+
+        size_type size() const noexcept
+        {
+            return size_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        size_type capacity() const noexcept
+        {
+            return wordCapacity_ * word_bits;
+        }
+
+        size_type word_count() const noexcept
+        {
+            return WordsFor(size_);
+        }
+
+        const word_type* data() const noexcept
+        {
+            return words_;
+        }
+
+        allocator_type get_allocator() const
+        {
+            return allocator_;
+        }
+
+        bool operator[](size_type i) const noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            return (words_[i / word_bits] >> (i % word_bits)) & 1;
+        }
+
+        bool test(size_type i) const
+        {
+            if (i >= size_) throw std::out_of_range("Out of range!");
+            return (*this)[i];
+        }
+
+        void set(size_type i) noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            words_[i / word_bits] |= Bit(i);
+        }
+
+        void set(size_type i, bool value) noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            auto& word = words_[i / word_bits];
+            word = (word & ~Bit(i)) | (word_type(value) << (i % word_bits));
+        }
+
+        void reset(size_type i) noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            words_[i / word_bits] &= ~Bit(i);
+        }
+
+        void flip(size_type i) noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            words_[i / word_bits] ^= Bit(i);
+        }
+
+        //置位并返回原来的值，图遍历中的 visited 集合可以一步完成判断与标记。
+        bool test_and_set(size_type i) noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            auto& word = words_[i / word_bits];
+            const auto bit = Bit(i);
+            const bool old = (word & bit) != 0;
+            word |= bit;
+            return old;
+        }
+
+        void fill(bool value) noexcept
+        {
+            const auto words = word_count();
+            if (words == 0) return;
+            std::memset(words_, value ? 0xFF : 0, words * sizeof(word_type));
+            ClearTail();
+        }
+
+        void push_back(bool value)
+        {
+            if (size_ == capacity())
+                Reallocate(vector_growth_1_5x::grow(wordCapacity_, wordCapacity_ + 1, sizeof(word_type)));
+            if (size_ % word_bits == 0)
+                words_[size_ / word_bits] = 0;
+            words_[size_ / word_bits] |= word_type(value) << (size_ % word_bits);
+            ++size_;
+        }
+
+        void pop_back() noexcept
+        {
+            YPASSERT(!empty(), "pop_back on empty bit_vector!");
+            --size_;
+            words_[size_ / word_bits] &= ~Bit(size_);
+        }
+
+        void clear() noexcept
+        {
+            size_ = 0;
+        }
+
+        void reserve(size_type bits)
+        {
+            const auto words = WordsFor(bits);
+            if (words > wordCapacity_)
+                Reallocate(words);
+        }
+
+        void resize(size_type n, bool value = false)
+        {
+            const auto oldSize = size_;
+            const auto words = WordsFor(n);
+            if (words > wordCapacity_)
+                Reallocate(vector_growth_1_5x::grow(wordCapacity_, words, sizeof(word_type)));
+            if (n > oldSize)
+            {
+                const auto oldWords = WordsFor(oldSize);
+                if (words > oldWords)
+                    std::memset(words_ + oldWords, value ? 0xFF : 0, (words - oldWords) * sizeof(word_type));
+                if (value && oldSize % word_bits != 0)
+                    words_[oldSize / word_bits] |= ~word_type {} << (oldSize % word_bits);
+            }
+            size_ = n;
+            ClearTail();
+        }
+
+        void shrink_to_fit()
+        {
+            const auto words = word_count();
+            if (words == wordCapacity_) return;
+            if (words == 0)
+            {
+                allocator_.deallocate(words_, wordCapacity_);
+                words_ = {};
+                wordCapacity_ = {};
+            }
+            else
+                Reallocate(words);
+        }
+
+        //为 1 的位数。
+        size_type count() const noexcept
+        {
+            return Internal::PopcountWords(words_, word_count());
+        }
+
+        bool any() const noexcept
+        {
+            const auto words = word_count();
+            for (size_type i {}; i < words; ++i)
+                if (words_[i] != 0) return true;
+            return false;
+        }
+
+        bool none() const noexcept
+        {
+            return !any();
+        }
+
+        //第一个为 1 的位，没有时返回 npos。
+        size_type find_first() const noexcept
+        {
+            if (size_ == 0) return npos;
+            return FindFromWord(0, words_[0]);
+        }
+
+        //i 之后第一个为 1 的位，没有时返回 npos。
+        size_type find_next(size_type i) const noexcept
+        {
+            ++i;
+            if (i >= size_) return npos;
+            return FindFromWord(i / word_bits, words_[i / word_bits] & (~word_type {} << (i % word_bits)));
+        }
+
+        //按字的批量运算，要求两边长度相同。
+        bit_vector& operator&=(const bit_vector& other)
+        {
+            return Apply<Internal::BitOp::And>(other);
+        }
+
+        bit_vector& operator|=(const bit_vector& other)
+        {
+            return Apply<Internal::BitOp::Or>(other);
+        }
+
+        bit_vector& operator^=(const bit_vector& other)
+        {
+            return Apply<Internal::BitOp::Xor>(other);
+        }
+
+        //*this &= ~other。
+        bit_vector& and_not(const bit_vector& other)
+        {
+            return Apply<Internal::BitOp::AndNot>(other);
+        }
+
+        //翻转所有位。
+        void flip() noexcept
+        {
+            const auto words = word_count();
+            for (size_type i {}; i < words; ++i)
+                words_[i] = ~words_[i];
+            ClearTail();
+        }
+
+        friend bool operator==(const bit_vector& lhs, const bit_vector& rhs) noexcept
+        {
+            return lhs.size_ == rhs.size_ && (lhs.size_ == 0 || std::memcmp(lhs.words_, rhs.words_, lhs.word_count() * sizeof(word_type)) == 0);
+        }
+
+        friend bool operator!=(const bit_vector& lhs, const bit_vector& rhs) noexcept
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        static constexpr size_type WordsFor(size_type bits) noexcept
+        {
+            return (bits + word_bits - 1) / word_bits;
+        }
+
+        static constexpr word_type Bit(size_type i) noexcept
+        {
+            return word_type { 1 } << (i % word_bits);
+        }
+
+        void Reallocate(size_type newWordCapacity)
+        {
+            const auto newWords = allocator_.allocate(newWordCapacity);
+            const auto words = word_count();
+            if (words != 0)
+                std::memcpy(newWords, words_, words * sizeof(word_type));
+            if (words_ != nullptr)
+                allocator_.deallocate(words_, wordCapacity_);
+            words_ = newWords;
+            wordCapacity_ = newWordCapacity;
+        }
+
+        //清掉最后一个字中超出 size_ 的位。
+        void ClearTail() noexcept
+        {
+            if (size_ % word_bits != 0)
+                words_[size_ / word_bits] &= ~(~word_type {} << (size_ % word_bits));
+        }
+
+        //从第 wordIndex 个字开始找第一个为 1 的位，word 是这个字中还需要查找的部分。
+        size_type FindFromWord(size_type wordIndex, word_type word) const noexcept
+        {
+            const auto words = word_count();
+            while (word == 0)
+            {
+                if (++wordIndex == words) return npos;
+                word = words_[wordIndex];
+            }
+            return wordIndex * word_bits + Yupei::countr_zero(word);
+        }
+
+        template<Internal::BitOp Op>
+        bit_vector& Apply(const bit_vector& other)
+        {
+            if (size_ != other.size_)
+                throw std::invalid_argument {"Sizes of bit_vectors don't match!"};
+            Internal::BitwiseWords<Op>(words_, other.words_, word_count());
+            return *this;
+        }
+
+        word_type* words_;
+        size_type size_;
+        size_type wordCapacity_;
+        allocator_type allocator_;
+    };
+
+    inline bit_vector operator&(bit_vector lhs, const bit_vector& rhs)
+    {
+        lhs &= rhs;
+        return lhs;
+    }
+
+    inline bit_vector operator|(bit_vector lhs, const bit_vector& rhs)
+    {
+        lhs |= rhs;
+        return lhs;
+    }
+
+    inline bit_vector operator^(bit_vector lhs, const bit_vector& rhs)
+    {
+        lhs ^= rhs;
+        return lhs;
+    }
+
+    inline void swap(bit_vector& lhs, bit_vector& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+    //bit_vector 的 rank/select 索引。每 512 位（8 个字）记录一次之前的 1 的个数，额外占用 12.5% 的空间；
+    //另外每 1024 个 1 采样一次所在的块，select 只需在两个采样之间二分。
+    //建好之后 bit_vector 被修改时索引失效，需要重新构造。
+    class bit_rank_select
+    {
+    public:
+        using size_type = std::size_t;
+
+        static constexpr size_type block_bits = 512;
+        static constexpr size_type select_sample_rate = 1024;
+
+        explicit bit_rank_select(const bit_vector& bits, memory_resource_ptr resource = {})
+            :bits_ { &bits }, allocator_ { resource }
+        {
+            const auto words = bits.word_count();
+            blockCount_ = (words + kWordsPerBlock - 1) / kWordsPerBlock;
+            const auto data = bits.data();
+            //先按块统计，再根据总数分配采样。
+            blockRanks_ = allocator_.allocate(blockCount_ + 1);
+            size_type total {};
+            for (size_type block {}; block < blockCount_; ++block)
+            {
+                blockRanks_[block] = total;
+                const auto first = block * kWordsPerBlock;
+                total += Internal::PopcountWords(data + first, (std::min)(kWordsPerBlock, words - first));
+            }
+            blockRanks_[blockCount_] = total;
+            ones_ = total;
+
+            sampleCount_ = (ones_ + select_sample_rate - 1) / select_sample_rate;
+            if (sampleCount_ != 0)
+            {
+                SCOPE_FAIL{
+                    allocator_.deallocate(blockRanks_, blockCount_ + 1);
+                };
+                samples_ = allocator_.allocate(sampleCount_);
+                size_type block {};
+                for (size_type j {}; j < sampleCount_; ++j)
+                {
+                    const auto k = j * select_sample_rate;
+                    while (blockRanks_[block + 1] <= k)
+                        ++block;
+                    samples_[j] = block;
+                }
+            }
+        }
+
+        bit_rank_select(const bit_rank_select&) = delete;
+        bit_rank_select& operator=(const bit_rank_select&) = delete;
+
+        ~bit_rank_select()
+        {
+            allocator_.deallocate(blockRanks_, blockCount_ + 1);
+            if (samples_ != nullptr)
+                allocator_.deallocate(samples_, sampleCount_);
+        }
+
+        //为 1 的位的总数。
+        size_type ones() const noexcept
+        {
+            return ones_;
+        }
+
+        //[0, i) 中为 1 的位数，i 可以等于 size()。
+        size_type rank1(size_type i) const noexcept
+        {
+            YPASSERT(i <= bits_->size(), "Out of Range!");
+            const auto block = i / block_bits;
+            auto rank = blockRanks_[block];
+            const auto data = bits_->data();
+            const auto word = i / bit_vector::word_bits;
+            rank += Internal::PopcountWords(data + block * kWordsPerBlock, word - block * kWordsPerBlock);
+            if (i % bit_vector::word_bits != 0)
+                rank += Yupei::popcount(data[word] & ~(~std::uint64_t {} << (i % bit_vector::word_bits)));
+            return rank;
+        }
+
+        //[0, i) 中为 0 的位数。
+        size_type rank0(size_type i) const noexcept
+        {
+            return i - rank1(i);
+        }
+
+        //第 k 个（从 0 开始）为 1 的位的下标。
+        size_type select1(size_type k) const
+        {
+            if (k >= ones_) throw std::out_of_range("Out of range!");
+            const auto sample = k / select_sample_rate;
+            auto lo = samples_[sample];
+            auto hi = sample + 1 < sampleCount_ ? samples_[sample + 1] + 1 : blockCount_;
+            //找最后一个 blockRanks_[block] <= k 的块。
+            while (hi - lo > 1)
+            {
+                const auto mid = lo + (hi - lo) / 2;
+                if (blockRanks_[mid] <= k)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            auto remaining = k - blockRanks_[lo];
+            const auto data = bits_->data();
+            auto word = lo * kWordsPerBlock;
+            for (;; ++word)
+            {
+                const auto c = static_cast<size_type>(Yupei::popcount(data[word]));
+                if (remaining < c) break;
+                remaining -= c;
+            }
+            return word * bit_vector::word_bits + Yupei::select_bit(data[word], static_cast<int>(remaining));
+        }
+
+        //第 k 个（从 0 开始）为 0 的位的下标。没有采样，在块的 rank 上二分。
+        size_type select0(size_type k) const
+        {
+            const auto size = bits_->size();
+            if (k >= size - ones_) throw std::out_of_range("Out of range!");
+            size_type lo {}, hi = blockCount_;
+            while (hi - lo > 1)
+            {
+                const auto mid = lo + (hi - lo) / 2;
+                if (mid * block_bits - blockRanks_[mid] <= k)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            auto remaining = k - (lo * block_bits - blockRanks_[lo]);
+            const auto data = bits_->data();
+            auto word = lo * kWordsPerBlock;
+            for (;; ++word)
+            {
+                //最后一个字中超出 size 的位是 0，但不能算作 0 位；k 的范围已经保证不会数到那里。
+                const auto c = static_cast<size_type>(bit_vector::word_bits - Yupei::popcount(data[word]));
+                if (remaining < c) break;
+                remaining -= c;
+            }
+            return word * bit_vector::word_bits + Yupei::select_bit(~data[word], static_cast<int>(remaining));
+        }
+
+    private:
+        static constexpr size_type kWordsPerBlock = block_bits / bit_vector::word_bits;
+
+        const bit_vector* bits_;
+        polymorphic_allocator<size_type> allocator_;
+        size_type* blockRanks_ = {};
+        size_type blockCount_ = {};
+        size_type* samples_ = {};
+        size_type sampleCount_ = {};
+        size_type ones_ = {};
+    };
+}
@@ -0,0 +1,370 @@
+﻿#pragma once
+
+#include "../Hash/Hash.hpp"
+#include "../Hash/HashHelpers.hpp"
+#include "../Iterator.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../Prefetch.hpp"
+#include "../Assert.hpp"
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace Yupei
+{
+    //按 cache line 分块的 Bloom filter（split block Bloom filter）。
+    //每个键只落在一个 64 字节的块里，块分成 8 个 64 位的字，每个字各置一位，即 k = 8。
+    //键只经 HashFun 哈希一次，混合后高 32 位选块，低 32 位分别乘以 8 个奇数常量取高 6 位，得到每个字中的位置。
+    //8 个字的操作彼此独立、没有分支，编译器可以直接向量化；查询不命中时只读一条 cache line。
+    template<typename KeyT, typename HashFun = hash<>>
+    class blocked_bloom_filter : HashFun
+    {
+    public:
+        using key_type = KeyT;
+        using size_type = std::size_t;
+        using hasher = HashFun;
+
+        static constexpr size_type kWordsPerBlock = 8;
+        static constexpr size_type kBlockBytes = kWordsPerBlock * sizeof(std::uint64_t);
+
+    private:
+        struct Block
+        {
+            std::uint64_t Words_[kWordsPerBlock];
+        };
+
+        //batch 接口每组同时在途的键数。
+        static constexpr size_type kBatchGroupSize = 16;
+        static constexpr std::uint32_t kMagic = 0x46425059; //"YPBF"
+        static constexpr std::uint32_t kVersion = 1;
+        static constexpr size_type kHeaderBytes = 16;
+        //Allocate 额外多要一个块用于对齐。
+        static constexpr size_type kMaxBlockCount = static_cast<size_type>(-1) / kBlockBytes - 1;
+
+        struct UninitializedTag {};
+
+        //只分配内存，不清零，由调用者写入所有块。
+        blocked_bloom_filter(UninitializedTag, size_type blockCount, const hasher& hash, memory_resource_ptr pmr)
+            :hasher{hash},
+            allocator_{pmr}
+        {
+            Allocate(blockCount);
+        }
+
+    public:
+        //blockCount 至少为 1。
+        explicit blocked_bloom_filter(size_type blockCount, hasher hash = {}, memory_resource_ptr pmr = {})
+            :blocked_bloom_filter{UninitializedTag{}, std::max<size_type>(blockCount, 1), hash, pmr}
+        {
+            clear();
+        }
+
+        blocked_bloom_filter(const blocked_bloom_filter& other)
+            :blocked_bloom_filter{UninitializedTag{}, other.blockCount_, other.hash_function(), other.allocator_}
+        {
+            std::memcpy(blocks_, other.blocks_, blockCount_ * kBlockBytes);
+        }
+
+        blocked_bloom_filter(blocked_bloom_filter&& other) noexcept
+            :hasher{other.hash_function()},
+            allocator_{other.allocator_},
+            storage_{other.storage_},
+            blocks_{other.blocks_},
+            blockCount_{other.blockCount_}
+        {
+            other.storage_ = {};
+            other.blocks_ = {};
+            other.blockCount_ = {};
+        }
+
+        blocked_bloom_filter& operator=(const blocked_bloom_filter& other)
+        {
+            blocked_bloom_filter(other).swap(*this);
+            return *this;
+        }
+
+        blocked_bloom_filter& operator=(blocked_bloom_filter&& other) noexcept
+        {
+            blocked_bloom_filter(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~blocked_bloom_filter()
+        {
+            Deallocate();
+        }
+
+        //要求两边的分配器相等。
+        void swap(blocked_bloom_filter& other) noexcept
+        {
+            using std::swap;
+            swap(storage_, other.storage_);
+            swap(blocks_, other.blocks_);
+            swap(blockCount_, other.blockCount_);
+        }
+
+        hasher hash_function() const
+        {
+            return static_cast<hasher>(*this);
+        }
+
+        size_type block_count() const noexcept
+        {
+            return blockCount_;
+        }
+
+        size_type size_in_bytes() const noexcept
+        {
+            return blockCount_ * kBlockBytes;
+        }
+
+        void clear() noexcept
+        {
+            std::fill(reinterpret_cast<std::uint64_t*>(blocks_), reinterpret_cast<std::uint64_t*>(blocks_ + blockCount_), std::uint64_t{});
+        }
+
+        void insert(const key_type& key)
+        {
+            InsertHashed(Internal::MixHash(static_cast<std::uint64_t>(hash_function()(key))));
+        }
+
+        //可能误报，不会漏报。
+        bool contains(const key_type& key) const
+        {
+            return ContainsHashed(Internal::MixHash(static_cast<std::uint64_t>(hash_function()(key))));
+        }
+
+        //先为一组键算完哈希并预取各自的块，再逐个写入。
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void insert(InputItT first, InputItT last)
+        {
+            std::uint64_t hashCodes[kBatchGroupSize];
+            while (first != last)
+            {
+                size_type n = 0;
+                for (; n < kBatchGroupSize && first != last; ++n, ++first)
+                {
+                    hashCodes[n] = Internal::MixHash(static_cast<std::uint64_t>(hash_function()(*first)));
+                    prefetch(blocks_ + BlockIndex(hashCodes[n]));
+                }
+                for (size_type i = 0; i < n; ++i)
+                    InsertHashed(hashCodes[i]);
+            }
+        }
+
+        //按顺序为 [first, last) 中的每个键向 out 写入 contains 的结果。
+        template<typename ForwardItT, typename OutputItT, typename = std::enable_if_t<is_forward_iterator<ForwardItT>::value>>
+        OutputItT contains_batch(ForwardItT first, ForwardItT last, OutputItT out) const
+        {
+            std::uint64_t hashCodes[kBatchGroupSize];
+            while (first != last)
+            {
+                size_type n = 0;
+                for (; n < kBatchGroupSize && first != last; ++n, ++first)
+                {
+                    hashCodes[n] = Internal::MixHash(static_cast<std::uint64_t>(hash_function()(*first)));
+                    prefetch(blocks_ + BlockIndex(hashCodes[n]));
+                }
+                for (size_type i = 0; i < n; ++i)
+                {
+                    *out = ContainsHashed(hashCodes[i]);
+                    ++out;
+                }
+            }
+            return out;
+        }
+
+        //按位或上 other，两边的块数必须相同。
+        void union_with(const blocked_bloom_filter& other)
+        {
+            if (other.blockCount_ != blockCount_)
+                throw std::invalid_argument {"Block counts of the two filters are different!"};
+            const auto lhs = reinterpret_cast<std::uint64_t*>(blocks_);
+            const auto rhs = reinterpret_cast<const std::uint64_t*>(other.blocks_);
+            for (size_type i = 0; i < blockCount_ * kWordsPerBlock; ++i)
+                lhs[i] |= rhs[i];
+        }
+
+        //块内键数服从泊松分布，逐项累加每种负载下 8 个字同时命中的概率。
+        static double estimate_false_positive_rate(size_type keyCount, size_type blockCount) noexcept
+        {
+            if (blockCount == 0) return 1.;
+            const auto lambda = static_cast<double>(keyCount) / static_cast<double>(blockCount);
+            const auto last = static_cast<size_type>(lambda + 10. * std::sqrt(lambda) + 10.);
+            //从众数开始向两边累加，避免 e^-lambda 在 lambda 很大时下溢。
+            const auto mode = static_cast<size_type>(lambda);
+            const auto logMode = -lambda + static_cast<double>(mode) * std::log(lambda > 0. ? lambda : 1.) - std::lgamma(static_cast<double>(mode) + 1.);
+            auto rate = 0.;
+            auto probability = std::exp(logMode);
+            for (auto i = mode; i <= last; ++i)
+            {
+                rate += probability * BlockFalsePositiveRate(i);
+                probability *= lambda / static_cast<double>(i + 1);
+            }
+            probability = std::exp(logMode);
+            for (auto i = mode; i > 0; --i)
+            {
+                probability *= static_cast<double>(i) / lambda;
+                rate += probability * BlockFalsePositiveRate(i - 1);
+            }
+            return rate;
+        }
+
+        //放入 keyCount 个键后误报率不超过 falsePositiveRate 所需的最少块数。
+        static size_type blocks_for(size_type keyCount, double falsePositiveRate)
+        {
+            if (!(falsePositiveRate > 0. && falsePositiveRate < 1.))
+                throw std::invalid_argument {"False positive rate must be in (0, 1)!"};
+            if (keyCount == 0) return 1;
+            size_type high = std::max<size_type>(keyCount / 64, 1);
+            while (estimate_false_positive_rate(keyCount, high) > falsePositiveRate)
+                high *= 2;
+            size_type low = high / 2;
+            //不变式：high 满足要求，low 不满足（或为 0）。
+            while (high - low > 1)
+            {
+                const auto mid = low + (high - low) / 2;
+                if (estimate_false_positive_rate(keyCount, mid) > falsePositiveRate)
+                    low = mid;
+                else
+                    high = mid;
+            }
+            return high;
+        }
+
+        size_type serialized_size() const noexcept
+        {
+            return kHeaderBytes + size_in_bytes();
+        }
+
+        //格式：magic、version（各 4 字节）、块数（8 字节），然后是所有字，全部按小端序写出。
+        template<typename OutputItT>
+        OutputItT serialize(OutputItT out) const
+        {
+            out = WriteLittleEndian(out, kMagic, 4);
+            out = WriteLittleEndian(out, kVersion, 4);
+            out = WriteLittleEndian(out, static_cast<std::uint64_t>(blockCount_), 8);
+            const auto words = reinterpret_cast<const std::uint64_t*>(blocks_);
+            for (size_type i = 0; i < blockCount_ * kWordsPerBlock; ++i)
+                out = WriteLittleEndian(out, words[i], 8);
+            return out;
+        }
+
+        //数据不完整或格式不对时抛出 std::invalid_argument。
+        template<typename InputItT>
+        static blocked_bloom_filter deserialize(InputItT first, InputItT last, hasher hash = {}, memory_resource_ptr pmr = {})
+        {
+            if (ReadLittleEndian(first, last, 4) != kMagic || ReadLittleEndian(first, last, 4) != kVersion)
+                throw std::invalid_argument {"Not a serialized blocked_bloom_filter!"};
+            const auto blockCount = ReadLittleEndian(first, last, 8);
+            if (blockCount == 0 || blockCount > static_cast<std::uint64_t>(kMaxBlockCount))
+                throw std::invalid_argument {"Invalid block count!"};
+            //每个字都会被下面的循环覆盖，不必先清零。
+            blocked_bloom_filter filter {UninitializedTag{}, static_cast<size_type>(blockCount), hash, pmr};
+            const auto words = reinterpret_cast<std::uint64_t*>(filter.blocks_);
+            for (size_type i = 0; i < filter.blockCount_ * kWordsPerBlock; ++i)
+                words[i] = ReadLittleEndian(first, last, 8);
+            if (first != last)
+                throw std::invalid_argument {"Trailing bytes after the filter!"};
+            return filter;
+        }
+
+    private:
+        memory_resource_ptr allocator_;
+        //new_delete_resource 不保证对齐，多分配一个块的空间，手动对齐到 64 字节。
+        void* storage_ = {};
+        Block* blocks_ = {};
+        size_type blockCount_ = {};
+
+        void Allocate(size_type blockCount)
+        {
+            if (blockCount > kMaxBlockCount)
+                throw std::bad_array_new_length();
+            storage_ = allocator_->allocate((blockCount + 1) * kBlockBytes, alignof(std::max_align_t));
+            const auto address = reinterpret_cast<std::uintptr_t>(storage_);
+            blocks_ = reinterpret_cast<Block*>((address + kBlockBytes - 1) & ~static_cast<std::uintptr_t>(kBlockBytes - 1));
+            blockCount_ = blockCount;
+        }
+
+        void Deallocate() noexcept
+        {
+            if (storage_)
+                allocator_->deallocate(storage_, (blockCount_ + 1) * kBlockBytes, alignof(std::max_align_t));
+        }
+
+        //用乘法把高 32 位映射到 [0, blockCount_)，不需要除法。
+        size_type BlockIndex(std::uint64_t hashCode) const noexcept
+        {
+            return static_cast<size_type>(((hashCode >> 32) * static_cast<std::uint64_t>(blockCount_)) >> 32);
+        }
+
+        //第 i 个字中要置的位：h1 * kSalts[i] 的高 6 位。
+        //不用 h1 + i * h2 的双重哈希：同一块里的键 h2 的高位几乎相同，8 个位置会退化成一个。
+        static void MakeMask(std::uint64_t hashCode, std::uint64_t (&mask)[kWordsPerBlock]) noexcept
+        {
+            static constexpr std::uint32_t kSalts[kWordsPerBlock] = {
+                0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+            };
+            const auto h1 = static_cast<std::uint32_t>(hashCode);
+            for (size_type i = 0; i < kWordsPerBlock; ++i)
+                mask[i] = std::uint64_t{1} << ((h1 * kSalts[i]) >> 26);
+        }
+
+        void InsertHashed(std::uint64_t hashCode) noexcept
+        {
+            YPASSERT(blockCount_ != 0, "Insert into a moved-from filter!");
+            std::uint64_t mask[kWordsPerBlock];
+            MakeMask(hashCode, mask);
+            auto& block = blocks_[BlockIndex(hashCode)];
+            for (size_type i = 0; i < kWordsPerBlock; ++i)
+                block.Words_[i] |= mask[i];
+        }
+
+        bool ContainsHashed(std::uint64_t hashCode) const noexcept
+        {
+            if (blockCount_ == 0) return false;
+            std::uint64_t mask[kWordsPerBlock];
+            MakeMask(hashCode, mask);
+            const auto& block = blocks_[BlockIndex(hashCode)];
+            std::uint64_t missing = 0;
+            for (size_type i = 0; i < kWordsPerBlock; ++i)
+                missing |= mask[i] & ~block.Words_[i];
+            return missing == 0;
+        }
+
+        //块里已有 keyCount 个键时，一个新键的 8 位都已被置上的概率。
+        static double BlockFalsePositiveRate(size_type keyCount) noexcept
+        {
+            const auto bitSet = 1. - std::pow(1. - 1. / 64., static_cast<double>(keyCount));
+            return std::pow(bitSet, static_cast<double>(kWordsPerBlock));
+        }
+
+        template<typename OutputItT>
+        static OutputItT WriteLittleEndian(OutputItT out, std::uint64_t value, size_type bytes)
+        {
+            for (size_type i = 0; i < bytes; ++i)
+            {
+                *out = static_cast<unsigned char>(value >> (8 * i));
+                ++out;
+            }
+            return out;
+        }
+
+        template<typename InputItT>
+        static std::uint64_t ReadLittleEndian(InputItT& first, InputItT last, size_type bytes)
+        {
+            std::uint64_t value = 0;
+            for (size_type i = 0; i < bytes; ++i, ++first)
+            {
+                if (first == last)
+                    throw std::invalid_argument {"Serialized filter is truncated!"};
+                value |= static_cast<std::uint64_t>(static_cast<unsigned char>(*first)) << (8 * i);
+            }
+            return value;
+        }
+    };
+}
@@ -0,0 +1,282 @@
+﻿#pragma once
+
+#include "Dictionary.hpp"
+#include "../Hash/Hash.hpp"
+#include "../Hash/HashHelpers.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../Mutex.hpp"
+#include "../Scope.hpp"
+#include <functional>
+#include <utility>
+
+namespace Yupei
+{
+    //线程安全的字典：键按哈希分到若干条带（stripe），每个条带是一个 dictionary 加一把读写锁。
+    //读操作只拿所在条带的共享锁，不同条带之间互不影响；哈希只在锁外算一次，条带内部用 *_hashed 接口。
+    //不提供迭代器（锁一放开迭代器就失效了），改为在锁内回调：visit / for_each / upsert。
+    template<typename KeyT, typename ValueT, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>>
+    class concurrent_dictionary : KeyEqualT, HashFun
+    {
+    public:
+        using dictionary_type = dictionary<KeyT, ValueT, HashFun, KeyEqualT>;
+        using key_type = KeyT;
+        using mapped_type = ValueT;
+        using value_type = std::pair<key_type, mapped_type>;
+        using size_type = std::size_t;
+        using key_equal = KeyEqualT;
+        using hasher = HashFun;
+
+        static constexpr size_type kDefaultStripeCount = 64;
+
+        concurrent_dictionary()
+            :concurrent_dictionary{kDefaultStripeCount}
+        {}
+
+        //stripeCount 会向上取整到 2 的幂。
+        explicit concurrent_dictionary(size_type stripeCount, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :key_equal{keyEqual},
+            hasher{hash},
+            allocator_{pmr},
+            stripeCount_{RoundUpToPowerOf2(stripeCount)}
+        {
+            stripes_ = allocator_.allocate(stripeCount_);
+            size_type constructed = {};
+            SCOPE_FAIL{
+                for (size_type i = 0; i < constructed; ++i)
+                    Yupei::destroy_at(stripes_ + i);
+                allocator_.deallocate(stripes_, stripeCount_);
+            };
+            for (; constructed < stripeCount_; ++constructed)
+                Yupei::construct(stripes_ + constructed, hash, keyEqual, pmr);
+        }
+
+        concurrent_dictionary(const concurrent_dictionary&) = delete;
+        concurrent_dictionary& operator=(const concurrent_dictionary&) = delete;
+
+        ~concurrent_dictionary()
+        {
+            for (size_type i = 0; i < stripeCount_; ++i)
+                Yupei::destroy_at(stripes_ + i);
+            allocator_.deallocate(stripes_, stripeCount_);
+        }
+
+        hasher hash_function() const
+        {
+            return static_cast<hasher>(*this);
+        }
+
+        key_equal key_eq() const
+        {
+            return static_cast<key_equal>(*this);
+        }
+
+        size_type stripe_count() const noexcept
+        {
+            return stripeCount_;
+        }
+
+        //各条带依次加锁求和，并发修改时只是一个近似值。
+        size_type size() const
+        {
+            size_type result = {};
+            for (size_type i = 0; i < stripeCount_; ++i)
+            {
+                shared_lock<shared_mutex> lock{stripes_[i].Mutex_};
+                result += stripes_[i].Dictionary_.size();
+            }
+            return result;
+        }
+
+        //把 key 对应的值复制到 value，返回是否找到。
+        bool find(const key_type& key, mapped_type& value) const
+        {
+            return visit(key, [&](const mapped_type& v) {
+                value = v;
+            });
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        bool find(const K& key, mapped_type& value) const
+        {
+            return visit(key, [&](const mapped_type& v) {
+                value = v;
+            });
+        }
+
+        bool contains(const key_type& key) const
+        {
+            return visit(key, [](const mapped_type&) {});
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        bool contains(const K& key) const
+        {
+            return visit(key, [](const mapped_type&) {});
+        }
+
+        //在共享锁内以 fn(const mapped_type&) 访问 key 对应的值，返回是否找到。
+        template<typename Fn>
+        bool visit(const key_type& key, Fn fn) const
+        {
+            return Visit(key, fn);
+        }
+
+        template<typename K, typename Fn, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        bool visit(const K& key, Fn fn) const
+        {
+            return Visit(key, fn);
+        }
+
+        //以下返回值表示是否插入了新元素。
+        template<typename... Args>
+        bool try_emplace(const key_type& k, Args&&... args)
+        {
+            const auto hashCode = hash_function()(k);
+            auto& stripe = StripeOf(hashCode);
+            unique_lock<shared_mutex> lock{stripe.Mutex_};
+            return stripe.Dictionary_.try_emplace_hashed(k, hashCode, std::forward<Args>(args)...).second;
+        }
+
+        template<typename... Args>
+        bool try_emplace(key_type&& k, Args&&... args)
+        {
+            const auto hashCode = hash_function()(k);
+            auto& stripe = StripeOf(hashCode);
+            unique_lock<shared_mutex> lock{stripe.Mutex_};
+            return stripe.Dictionary_.try_emplace_hashed(std::move(k), hashCode, std::forward<Args>(args)...).second;
+        }
+
+        bool insert(const value_type& value)
+        {
+            return try_emplace(value.first, value.second);
+        }
+
+        bool insert(value_type&& value)
+        {
+            return try_emplace(std::move(value.first), std::move(value.second));
+        }
+
+        template<typename M>
+        bool insert_or_assign(const key_type& k, M&& obj)
+        {
+            const auto hashCode = hash_function()(k);
+            auto& stripe = StripeOf(hashCode);
+            unique_lock<shared_mutex> lock{stripe.Mutex_};
+            const auto it = stripe.Dictionary_.find_hashed(k, hashCode);
+            if (it != stripe.Dictionary_.end())
+            {
+                it->second = std::forward<M>(obj);
+                return false;
+            }
+            return stripe.Dictionary_.try_emplace_hashed(k, hashCode, std::forward<M>(obj)).second;
+        }
+
+        //原子地读-改-写：key 不存在时先值初始化一个 mapped_type，然后在独占锁内调用 fn(mapped_type&)。
+        //返回是否插入了新元素。fn 内不能再访问同一个 concurrent_dictionary。
+        template<typename Fn>
+        bool upsert(const key_type& key, Fn fn)
+        {
+            const auto hashCode = hash_function()(key);
+            auto& stripe = StripeOf(hashCode);
+            unique_lock<shared_mutex> lock{stripe.Mutex_};
+            const auto result = stripe.Dictionary_.try_emplace_hashed(key, hashCode);
+            fn(result.first->second);
+            return result.second;
+        }
+
+        bool erase(const key_type& key)
+        {
+            return Erase(key);
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        bool erase(const K& key)
+        {
+            return Erase(key);
+        }
+
+        //逐个条带在共享锁内调用 fn(const value_type&)，不是整体的快照。
+        template<typename Fn>
+        void for_each(Fn fn) const
+        {
+            for (size_type i = 0; i < stripeCount_; ++i)
+            {
+                shared_lock<shared_mutex> lock{stripes_[i].Mutex_};
+                for (const auto& kv : stripes_[i].Dictionary_)
+                    fn(kv);
+            }
+        }
+
+        void reserve(size_type n)
+        {
+            const auto perStripe = n / stripeCount_ + 1;
+            for (size_type i = 0; i < stripeCount_; ++i)
+            {
+                unique_lock<shared_mutex> lock{stripes_[i].Mutex_};
+                stripes_[i].Dictionary_.reserve(perStripe);
+            }
+        }
+
+        void clear()
+        {
+            for (size_type i = 0; i < stripeCount_; ++i)
+            {
+                unique_lock<shared_mutex> lock{stripes_[i].Mutex_};
+                stripes_[i].Dictionary_.clear();
+            }
+        }
+
+    private:
+        //memory_resource 不保证超过 max_align 的对齐，所以用填充而不是 alignas 来隔开相邻条带的锁。
+        struct Stripe
+        {
+            Stripe(const hasher& hash, const key_equal& keyEqual, memory_resource_ptr pmr)
+                :Dictionary_{0, hash, keyEqual, pmr}
+            {}
+
+            mutable shared_mutex Mutex_;
+            dictionary_type Dictionary_;
+            char Padding_[64];
+        };
+
+        polymorphic_allocator<Stripe> allocator_;
+        size_type stripeCount_;
+        Stripe* stripes_;
+
+        static size_type RoundUpToPowerOf2(size_type n) noexcept
+        {
+            size_type result = 1;
+            while (result < n)
+                result <<= 1;
+            return result;
+        }
+
+        //条带用混合后的哈希选，与条带内 dictionary 取模用的位不相关。
+        Stripe& StripeOf(size_type hashCode) const noexcept
+        {
+            return stripes_[static_cast<size_type>(Internal::MixHash(hashCode)) & (stripeCount_ - 1)];
+        }
+
+        template<typename K, typename Fn>
+        bool Visit(const K& key, Fn& fn) const
+        {
+            const auto hashCode = hash_function()(key);
+            const auto& stripe = StripeOf(hashCode);
+            shared_lock<shared_mutex> lock{stripe.Mutex_};
+            const auto it = stripe.Dictionary_.find_hashed(key, hashCode);
+            if (it == stripe.Dictionary_.end()) return false;
+            fn(it->second);
+            return true;
+        }
+
+        template<typename K>
+        bool Erase(const K& key)
+        {
+            const auto hashCode = hash_function()(key);
+            auto& stripe = StripeOf(hashCode);
+            unique_lock<shared_mutex> lock{stripe.Mutex_};
+            return stripe.Dictionary_.erase_hashed(key, hashCode);
+        }
+    };
+}
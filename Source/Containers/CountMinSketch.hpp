@@ -0,0 +1,205 @@
+﻿#pragma once
+
+#include "../Hash/Hash.hpp"
+#include "../Hash/HashHelpers.hpp"
+#include "../Iterator.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Yupei
+{
+    //Count-Min sketch 频率估计，depth 行、每行 width 个计数器。
+    //键经 HashFun 哈希一次并混合成 64 位，第 i 行的位置由 h1 + i * h2 的双重哈希给出。
+    //使用保守更新：只增加等于当前最小值的计数器，估计值仍是上界，但误差明显更小。
+    //计数器饱和而不是回绕。每个线程可以各用一个 sketch，最后再 merge 到一起。
+    template<typename KeyT, typename HashFun = hash<>, typename CounterT = std::uint32_t>
+    class count_min_sketch : HashFun
+    {
+        static_assert(std::is_unsigned<CounterT>::value, "CounterT must be an unsigned integer type.");
+
+    public:
+        using key_type = KeyT;
+        using size_type = std::size_t;
+        using hasher = HashFun;
+        using counter_type = CounterT;
+
+        explicit count_min_sketch(size_type width, size_type depth, hasher hash = {}, memory_resource_ptr pmr = {})
+            :hasher{hash},
+            allocator_{pmr},
+            width_{width},
+            depth_{depth}
+        {
+            if (width == 0 || depth == 0)
+                throw std::invalid_argument {"Width and depth of count_min_sketch must be positive!"};
+            counters_ = allocator_.allocate(width_ * depth_);
+            clear();
+        }
+
+        count_min_sketch(const count_min_sketch& other)
+            :hasher{other.hash_function()},
+            allocator_{other.allocator_},
+            width_{other.width_},
+            depth_{other.depth_},
+            total_{other.total_}
+        {
+            counters_ = allocator_.allocate(width_ * depth_);
+            std::copy(other.counters_, other.counters_ + width_ * depth_, counters_);
+        }
+
+        count_min_sketch(count_min_sketch&& other) noexcept
+            :hasher{other.hash_function()},
+            allocator_{other.allocator_},
+            counters_{other.counters_},
+            width_{other.width_},
+            depth_{other.depth_},
+            total_{other.total_}
+        {
+            other.counters_ = {};
+            other.width_ = {};
+            other.depth_ = {};
+            other.total_ = {};
+        }
+
+        count_min_sketch& operator=(const count_min_sketch& other)
+        {
+            count_min_sketch(other).swap(*this);
+            return *this;
+        }
+
+        count_min_sketch& operator=(count_min_sketch&& other) noexcept
+        {
+            count_min_sketch(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~count_min_sketch()
+        {
+            if (counters_)
+                allocator_.deallocate(counters_, width_ * depth_);
+        }
+
+        //要求两边的分配器相等。
+        void swap(count_min_sketch& other) noexcept
+        {
+            using std::swap;
+            swap(counters_, other.counters_);
+            swap(width_, other.width_);
+            swap(depth_, other.depth_);
+            swap(total_, other.total_);
+        }
+
+        //估计值超出真实值的部分以概率 1 - delta 不超过 epsilon * total()，
+        //所需的宽度为 ceil(e / epsilon)，深度为 ceil(ln(1 / delta))。
+        static size_type width_for(double epsilon)
+        {
+            if (!(epsilon > 0.))
+                throw std::invalid_argument {"Epsilon must be positive!"};
+            return static_cast<size_type>(std::ceil(std::exp(1.) / epsilon));
+        }
+
+        static size_type depth_for(double delta)
+        {
+            if (!(delta > 0. && delta < 1.))
+                throw std::invalid_argument {"Delta must be in (0, 1)!"};
+            return std::max<size_type>(static_cast<size_type>(std::ceil(std::log(1. / delta))), 1);
+        }
+
+        hasher hash_function() const
+        {
+            return static_cast<hasher>(*this);
+        }
+
+        size_type width() const noexcept
+        {
+            return width_;
+        }
+
+        size_type depth() const noexcept
+        {
+            return depth_;
+        }
+
+        //所有 add 的 count 之和。
+        std::uint64_t total() const noexcept
+        {
+            return total_;
+        }
+
+        void add(const key_type& key, counter_type count = 1)
+        {
+            const auto hashCode = Internal::MixHash(static_cast<std::uint64_t>(hash_function()(key)));
+            const auto target = SaturatingAdd(EstimateHashed(hashCode), count);
+            for (size_type i = 0; i < depth_; ++i)
+            {
+                auto& counter = counters_[i * width_ + Position(hashCode, i)];
+                counter = std::max(counter, target);
+            }
+            total_ += count;
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void add(InputItT first, InputItT last)
+        {
+            for (; first != last; ++first)
+                add(*first);
+        }
+
+        //不会低估。
+        counter_type estimate(const key_type& key) const
+        {
+            return EstimateHashed(Internal::MixHash(static_cast<std::uint64_t>(hash_function()(key))));
+        }
+
+        //逐个计数器相加。两边的宽度与深度必须相同。
+        void merge(const count_min_sketch& other)
+        {
+            if (other.width_ != width_ || other.depth_ != depth_)
+                throw std::invalid_argument {"Dimensions of the two sketches are different!"};
+            for (size_type i = 0; i < width_ * depth_; ++i)
+                counters_[i] = SaturatingAdd(counters_[i], other.counters_[i]);
+            total_ += other.total_;
+        }
+
+        void clear() noexcept
+        {
+            std::fill(counters_, counters_ + width_ * depth_, counter_type{});
+            total_ = {};
+        }
+
+    private:
+        polymorphic_allocator<counter_type> allocator_;
+        counter_type* counters_ = {};
+        size_type width_;
+        size_type depth_;
+        std::uint64_t total_ = {};
+
+        static counter_type SaturatingAdd(counter_type lhs, counter_type rhs) noexcept
+        {
+            const auto max = std::numeric_limits<counter_type>::max();
+            return lhs > max - rhs ? max : static_cast<counter_type>(lhs + rhs);
+        }
+
+        //用乘法把 32 位的 g_i 映射到 [0, width_)，不需要除法。
+        size_type Position(std::uint64_t hashCode, size_type row) const noexcept
+        {
+            const auto h1 = static_cast<std::uint32_t>(hashCode);
+            const auto h2 = static_cast<std::uint32_t>(hashCode >> 32);
+            const auto g = static_cast<std::uint32_t>(h1 + static_cast<std::uint32_t>(row) * h2);
+            return static_cast<size_type>((static_cast<std::uint64_t>(g) * width_) >> 32);
+        }
+
+        counter_type EstimateHashed(std::uint64_t hashCode) const noexcept
+        {
+            auto result = std::numeric_limits<counter_type>::max();
+            for (size_type i = 0; i < depth_; ++i)
+                result = std::min(result, counters_[i * width_ + Position(hashCode, i)]);
+            return result;
+        }
+    };
+}
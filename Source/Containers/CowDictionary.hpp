@@ -0,0 +1,156 @@
+﻿#pragma once
+
+#include "Dictionary.hpp"
+#include "../Hash/Hash.hpp"
+#include <memory>
+#include <functional>
+#include <utility>
+#include <initializer_list>
+
+namespace Yupei
+{
+    //写时复制的字典：读者通过 snapshot() 拿到一个不可变的版本，O(1)，不复制任何东西；
+    //写者在当前版本仍被快照持有时，先结构化复制一份私有的版本再修改。
+    //已发布的快照可以在任意线程上并发读取；snapshot() 与修改操作只能由写者调用。
+    template<typename KeyT, typename ValueT, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>>
+    class cow_dictionary
+    {
+    public:
+        using dictionary_type = dictionary<KeyT, ValueT, HashFun, KeyEqualT>;
+        using key_type = typename dictionary_type::key_type;
+        using mapped_type = typename dictionary_type::mapped_type;
+        using value_type = typename dictionary_type::value_type;
+        using size_type = typename dictionary_type::size_type;
+        using hasher = typename dictionary_type::hasher;
+        using key_equal = typename dictionary_type::key_equal;
+        using iterator = typename dictionary_type::iterator;
+        using const_iterator = typename dictionary_type::const_iterator;
+        using snapshot_type = std::shared_ptr<const dictionary_type>;
+
+        cow_dictionary()
+            :current_{std::make_shared<dictionary_type>()}
+        {}
+
+        explicit cow_dictionary(dictionary_type dict)
+            :current_{std::make_shared<dictionary_type>(std::move(dict))}
+        {}
+
+        cow_dictionary(std::initializer_list<value_type> init)
+            :current_{std::make_shared<dictionary_type>(init)}
+        {}
+
+        //复制只共享当前版本，两边谁先写谁复制。
+        cow_dictionary(const cow_dictionary&) = default;
+        cow_dictionary& operator=(const cow_dictionary&) = default;
+
+        //被移动后的对象只能赋值或析构。
+        cow_dictionary(cow_dictionary&&) noexcept = default;
+        cow_dictionary& operator=(cow_dictionary&&) noexcept = default;
+
+        void swap(cow_dictionary& other) noexcept
+        {
+            current_.swap(other.current_);
+        }
+
+        //返回当前版本。之后的修改不会影响它。
+        snapshot_type snapshot() const noexcept
+        {
+            return current_;
+        }
+
+        const dictionary_type& read() const noexcept
+        {
+            return *current_;
+        }
+
+        //返回可修改的私有版本，必要时先在同一个 memory_resource 上复制。
+        //返回的引用在下一次 snapshot() 或复制 cow_dictionary 之后不能再用来修改。
+        dictionary_type& write()
+        {
+            if (current_.use_count() != 1)
+                current_ = std::make_shared<dictionary_type>(*current_, current_->get_allocator().resource());
+            return *current_;
+        }
+
+        //当前版本是否还被快照或其他 cow_dictionary 共享，即下一次写是否需要复制。
+        bool shared() const noexcept
+        {
+            return current_.use_count() != 1;
+        }
+
+        size_type size() const noexcept
+        {
+            return read().size();
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return read().begin();
+        }
+
+        const_iterator end() const noexcept
+        {
+            return read().end();
+        }
+
+        const_iterator find(const key_type& key) const
+        {
+            return read().find(key);
+        }
+
+        const mapped_type& at(const key_type& key) const
+        {
+            return read().at(key);
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return write().insert(value);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value)
+        {
+            return write().insert(std::move(value));
+        }
+
+        template<typename M>
+        std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        {
+            return write().insert_or_assign(k, std::forward<M>(obj));
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        {
+            return write().try_emplace(k, std::forward<Args>(args)...);
+        }
+
+        mapped_type& operator[](const key_type& key)
+        {
+            return write()[key];
+        }
+
+        bool erase(const key_type& key)
+        {
+            if (read().find(key) == read().end()) return false;
+            return write().erase(key);
+        }
+
+        //被共享时直接换一个空版本，不必先复制再清空。新版本沿用原来的内存资源与最大负载因子。
+        void clear()
+        {
+            if (shared())
+            {
+                const auto& old = read();
+                auto fresh = std::make_shared<dictionary_type>(old.bucket_count(), old.hash_function(), old.key_eq(), old.get_allocator().resource());
+                fresh->max_load_factor(old.max_load_factor());
+                current_ = std::move(fresh);
+            }
+            else
+                current_->clear();
+        }
+
+    private:
+        std::shared_ptr<dictionary_type> current_;
+    };
+}
@@ -7,11 +7,18 @@
 #include "../Hash/HashHelpers.hpp"
 #include "../ConstructDestruct.hpp"
 #include "../Algorithm/ForEach.hpp"
+#include "../Prefetch.hpp"
+#include "../Scope.hpp"
+#include "HashTable.hpp"
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <cmath>
 #include <utility>
 #include <functional>
 #include <algorithm>
 #include <tuple>
+#include <array>
 
 namespace Yupei
 {
@@ -56,7 +63,7 @@ namespace Yupei
             value_type& operator*() const noexcept
             {
                 YPASSERT(index_ != size_t(-1), "Deref a null iterator!");
-                return dict_->entries_[index_].KeyValue_;
+                return dict_->entries_[index_].Value_;
             }
 
             pointer operator->() const noexcept
@@ -116,7 +123,7 @@ namespace Yupei
 
             reference operator*() const noexcept
             {
-                return dict_->entries_[index_].KeyValue_;
+                return dict_->entries_[index_].Value_;
             }
 
             pointer operator->() const noexcept
@@ -172,7 +179,7 @@ namespace Yupei
 
             reference operator*() noexcept
             {
-                return dict_->entries_[index_].KeyValue_;
+                return dict_->entries_[index_].Value_;
             }
 
             pointer operator->() noexcept
@@ -232,7 +239,7 @@ namespace Yupei
 
             reference operator*() noexcept
             {
-                return dict_->entries_[index_].KeyValue_;
+                return dict_->entries_[index_].Value_;
             }
 
             pointer operator->() noexcept
@@ -255,11 +262,109 @@ namespace Yupei
             DictionaryT* dict_;
             size_type_t<DictionaryT> index_;
         };
+
+        //extract 取出的元素连同插入时保存的哈希值，再插入时不必重新计算哈希。
+        template<typename KeyT, typename ValueT>
+        class DictionaryNodeHandle
+        {
+            template<typename, typename, typename, typename>
+            friend class Yupei::dictionary;
+
+            using value_type = std::pair<KeyT, ValueT>;
+            static constexpr std::size_t kNothing = static_cast<std::size_t>(-1);
+
+            template<typename... Args>
+            explicit DictionaryNodeHandle(std::size_t hashCode, Args&&... args)
+            {
+                Yupei::construct(GetPointer(), std::forward<Args>(args)...);
+                hashCode_ = hashCode;
+            }
+
+        public:
+            using key_type = KeyT;
+            using mapped_type = ValueT;
+
+            constexpr DictionaryNodeHandle() noexcept
+            {}
+
+            DictionaryNodeHandle(DictionaryNodeHandle&& other) noexcept(std::is_nothrow_move_constructible<value_type>::value)
+            {
+                if (!other.empty())
+                {
+                    Yupei::construct(GetPointer(), std::move(*other.GetPointer()));
+                    hashCode_ = other.hashCode_;
+                    other.Reset();
+                }
+            }
+
+            DictionaryNodeHandle& operator=(DictionaryNodeHandle&& other) noexcept(std::is_nothrow_move_constructible<value_type>::value)
+            {
+                if (this != &other)
+                {
+                    Reset();
+                    if (!other.empty())
+                    {
+                        Yupei::construct(GetPointer(), std::move(*other.GetPointer()));
+                        hashCode_ = other.hashCode_;
+                        other.Reset();
+                    }
+                }
+                return *this;
+            }
+
+            ~DictionaryNodeHandle()
+            {
+                Reset();
+            }
+
+            bool empty() const noexcept
+            {
+                return hashCode_ == kNothing;
+            }
+
+            explicit operator bool() const noexcept
+            {
+                return !empty();
+            }
+
+            //与 std 的 node handle 不同，key 是只读的：改了 key，保存的哈希值就不对了。
+            const key_type& key() const noexcept
+            {
+                YPASSERT(!empty(), "Access an empty node!");
+                return GetPointer()->first;
+            }
+
+            mapped_type& mapped() const noexcept
+            {
+                YPASSERT(!empty(), "Access an empty node!");
+                return GetPointer()->second;
+            }
+
+        private:
+            std::aligned_storage_t<sizeof(value_type), alignof(value_type)> storage_;
+            std::size_t hashCode_ = kNothing;
+
+            value_type* GetPointer() const noexcept
+            {
+                return const_cast<value_type*>(reinterpret_cast<const value_type*>(&storage_));
+            }
+
+            void Reset() noexcept
+            {
+                if (!empty())
+                {
+                    Yupei::destroy_at(GetPointer());
+                    hashCode_ = kNothing;
+                }
+            }
+        };
     }
 
     template<typename KeyT, typename ValueT, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>>
-	class dictionary : KeyEqualT, HashFun
+	class dictionary : Internal::HashTable<std::pair<KeyT, ValueT>, Internal::PairKey, HashFun, KeyEqualT>
 	{
+		using Base = Internal::HashTable<std::pair<KeyT, ValueT>, Internal::PairKey, HashFun, KeyEqualT>;
+
 	public:
 		using key_type = KeyT;
 		using mapped_type = ValueT;
@@ -272,6 +377,27 @@ namespace Yupei
 		using const_iterator = Internal::DictionaryConstIterator<dictionary>;
 		using local_iterator = Internal::DictionaryLocalIterator<dictionary>;
 		using const_local_iterator = Internal::DictionaryConstLocalIterator<dictionary>;
+		using node_type = Internal::DictionaryNodeHandle<KeyT, ValueT>;
+
+		struct insert_return_type
+		{
+			iterator position;
+			bool inserted;
+			node_type node;
+		};
+
+		using Base::hash_function;
+		using Base::key_eq;
+		using Base::size;
+		using Base::bucket_count;
+		using Base::load_factor;
+		using Base::max_load_factor;
+		using Base::rehash;
+		using Base::reserve;
+		using Base::shrink_to_fit;
+		using Base::clear;
+		using Base::stats;
+		using Base::reset_counters;
 
 	private:
 		template<typename>
@@ -286,21 +412,28 @@ namespace Yupei
 		template<typename>
 		friend class Internal::DictionaryConstLocalIterator;
 
-		static constexpr size_type kNothing = static_cast<size_type>(-1);
-		using SizeAllocator = polymorphic_allocator<size_type>;
-
-		struct Entry
-		{
-			size_type HashCode_ = kNothing;
-			size_type NextEntryIndex_;
-			value_type KeyValue_;
-		};
-		using EntryAllocator = polymorphic_allocator<Entry>;
-		using EntryPtrTuple = std::tuple<Entry*>;
-
-#ifdef _DEBUG
-		Entry* dEntries;
-#endif // _DEBUG
+		using typename Base::Entry;
+		using typename Base::BucketPtr;
+		using typename Base::BucketDeleter;
+		using Base::kNothing;
+		using Base::freeList_;
+		using Base::freeCount_;
+		using Base::count_;
+		using Base::bucketCount_;
+		using Base::entryCapacity_;
+		using Base::allocator_;
+		using Base::entries_;
+		using Base::buckets_;
+		using Base::GetSizeTypeAllocator;
+		using Base::NextEntry;
+		using Base::Initialize;
+		using Base::ConstrainHash;
+		using Base::EmplaceEntry;
+		using Base::UnlinkEntry;
+		using Base::ReleaseEntry;
+		using Base::FindEntryByKey;
+		using Base::FindBatch;
+		using Base::EraseByKey;
 
 	public:
 		dictionary()
@@ -308,49 +441,37 @@ namespace Yupei
 		{}
 
 		explicit dictionary(size_type bucketCount, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
-			:key_equal { keyEqual },
-			hasher { hash },
-			allocator_ { pmr }
-		{
-			Initialize(bucketCount);
-		}
+			:Base { bucketCount, hash, keyEqual, pmr }
+		{}
 
+		//构造时 max_load_factor() 为 1，forward iterator 的元素个数就是所需的桶数。
 		template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
 		dictionary(InputItT first, InputItT last, size_type bucket = {}, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
-			:key_equal { keyEqual },
-			hasher { hash },
-			allocator_ { pmr }
+			:Base { is_forward_iterator<InputItT>::value ? std::max(bucket, static_cast<size_type>(std::distance(first, last))) : bucket,
+				hash, keyEqual, pmr }
 		{
-			auto newBucket = bucket;
-			if (std::is_base_of<std::random_access_iterator_tag, iterator_category_t<InputItT>>::value)
-				newBucket = std::max(bucket, static_cast<size_type>(last - first));
-			Initialize(newBucket);
 			insert(first, last);
 		}
 
+		//结构化复制：原样复制桶数组与 entry 数组（包括空闲链表），不重新计算哈希。
 		dictionary(const dictionary& other)
-			:key_equal { other.key_eq() },
-			hasher { other.hash_function() }
-		{
-			Initialize(other.bucketCount_);
-			insert(other.cbegin(), other.cend());
-		}
+			:Base { other, other.allocator_.resource() }
+		{}
+
+		//复制到 pmr 上。
+		dictionary(const dictionary& other, memory_resource_ptr pmr)
+			:Base { other, pmr }
+		{}
 
 		dictionary(dictionary&& other) noexcept
-			:key_equal { other.key_eq() },
-			hasher { other.hash_function() },
-			freeList_ { other.freeList_ },
-			freeCount_ { other.freeCount_ },
-			count_ { other.count_ },
-			bucketCount_ { other.bucketCount_ },
-			entries_ { std::move(other.entries_) },
-			buckets_ { std::move(other.buckets_) }
-		{
-			other.freeList_ = kNothing;
-			other.freeCount_ = {};
-			other.count_ = {};
-			other.bucketCount_ = {};
-		}
+			:Base { std::move(other) }
+		{}
+
+		//pmr 与 other 的分配器不同时逐个移动元素。
+		dictionary(dictionary&& other, memory_resource_ptr pmr)
+			:Base { std::move(other), pmr }
+		{}
+
 
 		dictionary(std::initializer_list<value_type> init, size_type bucketCount = {}, hasher hash = {},
 			key_equal keyEqual = {}, memory_resource_ptr mrp = {})
@@ -370,78 +491,41 @@ namespace Yupei
 		{
 		}
 
+        //赋值不改变本字典的分配器。
         dictionary& operator=(const dictionary& other)
         {
-            dictionary(other).swap(*this);
+            if (this != &other)
+                dictionary(other, allocator_.resource()).swap(*this);
             return *this;
         }
 
-        dictionary& operator=(dictionary&& other) noexcept
+        dictionary& operator=(dictionary&& other)
         {
-            dictionary(std::move(other)).swap(*this);
+            if (this != &other)
+                dictionary(std::move(other), allocator_.resource()).swap(*this);
             return *this;
         }
 
-        ~dictionary()
-        {
-            clear();
-        }
-
+        //要求两边的分配器相等。
         void swap(dictionary& other) noexcept
         {
-            using std::swap;
-            swap(freeList_, other.freeList_);
-            swap(freeCount_, other.freeCount_);
-            swap(count_, other.count_);
-            swap(bucketCount_, other.bucketCount_);
-            swap(entries_, other.entries_);
-            swap(buckets_, other.buckets_);
+            YPASSERT(allocator_ == other.allocator_, "Allocators of swapped dictionaries must be equal.");
+            this->SwapTable(other);
         }
 
         allocator_type get_allocator() const noexcept
         {
-            return static_cast<allocator_type>(*this);
-        }
-
-        size_type bucket_count() const noexcept
-        {
-            return bucketCount_;
-        }
-
-        float load_factor() const noexcept
-        {
-            return static_cast<float>(size()) /
-                static_cast<float>(bucket_count());
-        }
-
-        hasher hash_function() const
-        {
-            return static_cast<hasher>(*this);
-        }
-
-        key_equal key_eq() const
-        {
-            return static_cast<key_equal>(*this);
-        }
-
-        size_type size() const noexcept
-        {
-            return count_ - freeCount_;
-        }
-
-        float max_load_factor() const noexcept
-        {
-            return 1.f;
+            return allocator_;
         }
 
         iterator begin() noexcept
         {            
-            return {this, FindFirstNonEmptyEntry()};
+            return {this, NextEntry(0)};
         }
 
         const_iterator begin() const noexcept
         {
-            return {this, FindFirstNonEmptyEntry()};
+            return {this, NextEntry(0)};
         }
 
         //WARNING: This is not O(1).
@@ -499,75 +583,132 @@ namespace Yupei
         {
             YPASSERT(pos.index_ != kNothing, "Erase an end iterator!");
             const auto ret = std::next(pos);
-            const auto index = pos.index_;
-            auto& entry = entries_[index];
-            const auto targetBucket = ConstrainHash(entry.HashCode_);
-            auto last = kNothing;
-            for (size_type i = buckets_[targetBucket]; i != index; last = i, i = entries_[i].NextEntryIndex_)
-                ;
-            if (last == kNothing)
-                buckets_[targetBucket] = entry.NextEntryIndex_;
-            else
-                entries_[last].NextEntryIndex_ = entry.NextEntryIndex_;
-            entry.HashCode_ = kNothing;
-            entry.NextEntryIndex_ = freeList_;
-            freeList_ = index;
-            ++freeCount_;
-            destroy_at(std::addressof(entry.KeyValue_));
+            UnlinkEntry(pos.index_);
+            ReleaseEntry(pos.index_);
             return {this, ret.index_};
         }
 
         bool erase(const key_type& key)
         {
-            const auto hashCode = hash_function()(key);
-            const auto targetBucket = ConstrainHash(hashCode);
-            auto last = kNothing;
-            if (buckets_)
-            {
-                for (size_type i = buckets_[targetBucket]; i != kNothing; last = i, i = entries_[i].NextEntryIndex_)
-                {
-                    auto& entry = entries_[i];
-                    if (entry.HashCode_ == hashCode && key_eq()(key, entry.KeyValue_.first))
-                    {
-                        if (last == kNothing)
-                            buckets_[targetBucket] = entry.NextEntryIndex_;
-                        else
-                            entries_[last].NextEntryIndex_ = entry.NextEntryIndex_;
-
-                        entry.HashCode_ = kNothing;
-                        entry.NextEntryIndex_ = freeList_;
-                        freeList_ = i;
-                        ++freeCount_;
-                        destroy_at(std::addressof(entry.KeyValue_));
-                        return true;
-                    }
-                }
-            }
-            return false;
+            return EraseByKey(key);
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value &&
+            !std::is_convertible<K, iterator>::value && !std::is_convertible<K, const_iterator>::value, int> = 0>
+        bool erase(K&& key)
+        {
+            return EraseByKey(key);
         }
 
         mapped_type& at(const key_type& key)
         {
-            const auto i = FindEntryByKey(key);
-            if (i == kNothing) throw std::out_of_range("Key doesn't exist!");
-            return entries_[i].KeyValue_.second;
+            return At(key);
+        }
+
+        const mapped_type& at(const key_type& key) const
+        {
+            return At(key);
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        mapped_type& at(const K& key)
+        {
+            return At(key);
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        const mapped_type& at(const K& key) const
+        {
+            return At(key);
         }
 
         iterator find(const key_type& key)
         {
-            return {this, FindEntryByKey(key)};
+            return MakeIterator(FindEntryByKey(key));
         }
 
         const_iterator find(const key_type& key) const
         {
-            return {this, FindEntryByKey(key)};
+            return MakeIterator(FindEntryByKey(key));
         }
 
-        const mapped_type& at(const key_type& key) const
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        iterator find(const K& key)
         {
-            const auto i = FindEntryByKey(key);
-            if (i == kNothing) throw std::out_of_range("Key doesn't exist!");
-            return entries_[i].KeyValue_.second;
+            return MakeIterator(FindEntryByKey(key));
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        const_iterator find(const K& key) const
+        {
+            return MakeIterator(FindEntryByKey(key));
+        }
+
+        //以下 *_hashed 接口使用调用者预先算好的 hashCode，它必须等于 hash_function()(key)。
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsLookupKey<K, key_type, HashT, key_equal>::value, int> = 0>
+        iterator find_hashed(const K& key, size_type hashCode)
+        {
+            return MakeIterator(FindEntryByKey(key, hashCode));
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsLookupKey<K, key_type, HashT, key_equal>::value, int> = 0>
+        const_iterator find_hashed(const K& key, size_type hashCode) const
+        {
+            return MakeIterator(FindEntryByKey(key, hashCode));
+        }
+
+        template<typename K, typename... Args, typename HashT = hasher, std::enable_if_t<Internal::IsLookupKey<K, key_type, HashT, key_equal>::value, int> = 0>
+        std::pair<iterator, bool> try_emplace_hashed(K&& k, size_type hashCode, Args&&... args)
+        {
+            return InsertHashed(true, hashCode, std::forward<K>(k), std::forward<Args>(args)...);
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsLookupKey<K, key_type, HashT, key_equal>::value, int> = 0>
+        bool erase_hashed(const K& key, size_type hashCode)
+        {
+            return EraseByKey(key, hashCode);
+        }
+
+        //返回 pos 所指元素在插入时计算并保存的哈希值。
+        size_type stored_hash(const_iterator pos) const noexcept
+        {
+            YPASSERT(pos.index_ < count_, "Get the hash of an end iterator!");
+            return entries_[pos.index_].HashCode_;
+        }
+
+        //批量查找：按顺序为 [first, last) 中的每个键向 out 写入一个 iterator，未找到时为 end()。
+        //每组键先统一计算哈希并预取桶，再预取 entry，最后才沿链比较，以掩盖访存延迟。
+        template<typename ForwardItT, typename OutputItT, typename HashT = hasher,
+            std::enable_if_t<is_forward_iterator<ForwardItT>::value && Internal::IsBatchLookupKey<ForwardItT, key_type, HashT, key_equal>::value, int> = 0>
+        OutputItT find_batch(ForwardItT first, ForwardItT last, OutputItT out)
+        {
+            FindBatch(first, last, [&](size_type i) {
+                *out = MakeIterator(i);
+                ++out;
+            });
+            return out;
+        }
+
+        template<typename ForwardItT, typename OutputItT, typename HashT = hasher,
+            std::enable_if_t<is_forward_iterator<ForwardItT>::value && Internal::IsBatchLookupKey<ForwardItT, key_type, HashT, key_equal>::value, int> = 0>
+        OutputItT find_batch(ForwardItT first, ForwardItT last, OutputItT out) const
+        {
+            FindBatch(first, last, [&](size_type i) {
+                *out = MakeIterator(i);
+                ++out;
+            });
+            return out;
+        }
+
+        template<typename ForwardItT, typename OutputItT, typename HashT = hasher,
+            std::enable_if_t<is_forward_iterator<ForwardItT>::value && Internal::IsBatchLookupKey<ForwardItT, key_type, HashT, key_equal>::value, int> = 0>
+        OutputItT contains_batch(ForwardItT first, ForwardItT last, OutputItT out) const
+        {
+            FindBatch(first, last, [&](size_type i) {
+                *out = i != kNothing;
+                ++out;
+            });
+            return out;
         }
 
         mapped_type& operator[](const key_type& key)
@@ -580,6 +721,12 @@ namespace Yupei
             return try_emplace(std::move(key)).first->second;
         }
 
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        mapped_type& operator[](K&& key)
+        {
+            return try_emplace(std::forward<K>(key)).first->second;
+        }
+
         std::pair<iterator, bool> insert(const value_type& value)
         {
             return Insert(true, value.first, value.second);
@@ -593,9 +740,7 @@ namespace Yupei
 		template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
 		void insert(InputItT start, InputItT last)
 		{
-			std::for_each(start, last, [this](const auto& v) {
-				insert(v);
-			});
+			InsertRange(start, last, std::conjunction<is_forward_iterator<InputItT>, std::is_same<iterator_value_type_t<InputItT>, value_type>>{});
 		}
 
         template<typename M>
@@ -610,6 +755,12 @@ namespace Yupei
             return Insert(false, std::move(k), std::forward<M>(obj));
         }
 
+        template<typename K, typename M, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        std::pair<iterator, bool> insert_or_assign(K&& k, M&& obj)
+        {
+            return Insert(false, std::forward<K>(k), std::forward<M>(obj));
+        }
+
         template<typename... Args>
         std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
         {
@@ -622,222 +773,184 @@ namespace Yupei
             return Insert(true, std::move(k), std::forward<Args>(args)...);
         }
 
-        void clear() noexcept
+        //异质版本：只有在真正插入时才会用 k 构造 key_type。
+        template<typename K, typename... Args, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value &&
+            !std::is_convertible<K, iterator>::value && !std::is_convertible<K, const_iterator>::value, int> = 0>
+        std::pair<iterator, bool> try_emplace(K&& k, Args&&... args)
         {
-            const auto entries = entries_.get();
-            std::for_each(entries, entries + count_, [](Entry& entry) {
-                destroy_at(std::addressof(entry.KeyValue_));
-                entry.HashCode_ = kNothing;
-            });
-            count_ = {};
-            freeList_ = kNothing;
-            freeCount_ = {};
-            bucketCount_ = {};
+            return Insert(true, std::forward<K>(k), std::forward<Args>(args)...);
         }
 
-    private:
-        polymorphic_allocator<size_type> GetSizeTypeAllocator() const noexcept
+
+        //取出元素，连同保存的哈希值一起放进 node_type，槽位回到空闲链表。
+        node_type extract(const_iterator pos)
         {
-            return {allocator_};
+            YPASSERT(pos.index_ < count_, "Extract an end iterator!");
+            const auto index = pos.index_;
+            auto& entry = entries_[index];
+            node_type node {entry.HashCode_, std::move(entry.Value_)};
+            UnlinkEntry(index);
+            ReleaseEntry(index);
+            return node;
         }
 
-        size_type FindFirstNonEmptyEntry() const noexcept
+        node_type extract(const key_type& key)
         {
-            const auto entries = entries_.get();
-            const auto last = entries + count_;
-            const auto i = std::find_if(entries, last, [](const Entry& entry) {
-                return entry.HashCode_ != kNothing;
-            });
-            return i == last ? kNothing : i - entries;
+            return Extract(key);
         }
 
-        class BucketDeleter
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value &&
+            !std::is_convertible<K, iterator>::value && !std::is_convertible<K, const_iterator>::value, int> = 0>
+        node_type extract(K&& key)
         {
-        public:
-            BucketDeleter(const allocator_type& alloc) noexcept
-                :allocator_{alloc}
-            {}
+            return Extract(key);
+        }
 
-            DEFAULTCOPY(BucketDeleter)
+        //使用 node 里保存的哈希值插入。key 已存在时 node 原样退回到返回值里。
+        insert_return_type insert(node_type&& node)
+        {
+            if (node.empty()) return {end(), false, {}};
+            if (!buckets_) Initialize({});
+            const auto hashCode = node.hashCode_;
+            const auto i = FindEntryByKey(node.key(), hashCode);
+            if (i != kNothing) return {{this, i}, false, std::move(node)};
+            const auto index = EmplaceEntry(hashCode, ConstrainHash(hashCode), std::move(*node.GetPointer()));
+            node.Reset();
+            return {{this, index}, true, {}};
+        }
 
-            void operator()(size_type* p) noexcept
+        //把 source 中本字典没有的键移过来，已有的键留在 source 中。
+        //直接使用 source 保存的哈希值，因此两边的哈希函数必须等价。
+        void merge(dictionary& source)
+        {
+            if (&source == this) return;
+            if (!buckets_) Initialize({});
+            reserve(size() + source.size());
+            for (size_type i = 0; i < source.count_; ++i)
             {
-                allocator_.deallocate(p, 1);
+                auto& entry = source.entries_[i];
+                const auto hashCode = entry.HashCode_;
+                if (hashCode == kNothing || FindEntryByKey(entry.Value_.first, hashCode) != kNothing)
+                    continue;
+                EmplaceEntry(hashCode, ConstrainHash(hashCode), std::move(entry.Value_));
+                source.UnlinkEntry(i);
+                source.ReleaseEntry(i);
             }
+        }
 
-        private:
-            SizeAllocator allocator_;
-        };
-
-        class EntryDeleter
+        void merge(dictionary&& source)
         {
-        public:
-            EntryDeleter(const allocator_type& alloc) noexcept
-                : allocator_{alloc}
-            {}
+            merge(source);
+        }
 
-            DEFAULTCOPY(EntryDeleter)
+    private:
+        //未找到时 FindEntryByKey 返回 kNothing，而 end() 的下标是 count_。
+        iterator MakeIterator(size_type index) noexcept
+        {
+            return {this, index == kNothing ? count_ : index};
+        }
 
-            void operator()(Entry* p) noexcept
-            {
-                allocator_.deallocate(p, 1);
-            }
+        const_iterator MakeIterator(size_type index) const noexcept
+        {
+            return {this, index == kNothing ? count_ : index};
+        }
 
-        private:
-            EntryAllocator allocator_;
-        };
-     
-        size_type freeList_;
-        size_type freeCount_ = {};
-        //最高水位线。
-        size_type count_ = {};
-        size_type bucketCount_ = {};
-        polymorphic_allocator<Entry> allocator_;
-        const EntryDeleter entryDeleter_ {allocator_};
-        const BucketDeleter bucketDeleter_ {allocator_};
-        using EntryPtr = std::unique_ptr<Entry[], EntryDeleter>;
-        using BucketPtr = std::unique_ptr<size_type[], BucketDeleter>;
-        //这里编译不过是因为 LWG#2520。
-        /*EntryPtr entries_ {nullptr, entryDeleter_};
-        BucketPtr buckets_ {nullptr, bucketDeleter_};*/
-        //暂时的 workaround。
-        EntryPtr entries_ { (Entry*)0, entryDeleter_ };
-        BucketPtr buckets_ { (size_type*)0, bucketDeleter_ };
-        
 
-        void Initialize(size_type capacity)
+        template<typename InputItT>
+        void InsertRange(InputItT first, InputItT last, std::false_type)
         {
-            const auto newSize = Internal::HashHelpers::GetPrime(capacity);
-            buckets_.reset(GetSizeTypeAllocator().allocate(newSize));
-            entries_.reset(allocator_.allocate(newSize));
-            const auto buckets = buckets_.get();
-            const auto entries = entries_.get();
-            
-            std::fill(buckets, buckets + newSize, kNothing);                    
-            std::for_each(entries, entries + newSize, [](Entry& entry) {
-                entry.HashCode_ = kNothing;
+            std::for_each(first, last, [this](const auto& v) {
+                insert(v);
             });
-
-            freeList_ = kNothing;
-            bucketCount_ = newSize;
-#ifdef _DEBUG
-            dEntries = entries_.get();
-#endif // _DEBUG
         }
 
-        size_type ConstrainHash(size_type original) const noexcept
+        //批量插入：只分配一次；先在一个紧凑的循环里算完所有哈希，再逐个串入桶链。
+        template<typename ForwardItT>
+        void InsertRange(ForwardItT first, ForwardItT last, std::true_type)
         {
-            return original % bucketCount_;
+            const auto n = static_cast<size_type>(std::distance(first, last));
+            if (n == 0) return;
+            reserve(size() + n);
+
+            const BucketPtr hashCodes {GetSizeTypeAllocator().allocate(n), BucketDeleter{allocator_, n}};
+            const auto hashes = hashCodes.get();
+            auto it = first;
+            for (size_type i = 0; i < n; ++i, ++it)
+                hashes[i] = hash_function()((*it).first);
+
+            for (size_type i = 0; i < n; ++i, ++first)
+            {
+                const value_type& value = *first;
+                InsertHashed(true, hashes[i], value.first, value.second);
+            }
         }
 
         template<typename K, typename... Args>
         std::pair<iterator, bool> Insert(bool addOnly, K&& key, Args&&... args)
-        {          
+        {
+            const auto hashCode = hash_function()(key);
+            return InsertHashed(addOnly, hashCode, std::forward<K>(key), std::forward<Args>(args)...);
+        }
+
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> InsertHashed(bool addOnly, size_type hashCode, K&& key, Args&&... args)
+        {
+            YPASSERT(hash_function()(key) == hashCode, "Hash code doesn't match the key!");
             if (!buckets_) Initialize({});
-            auto hashCode = hash_function()(key);
             auto targetBucket = ConstrainHash(hashCode);
             for (auto i = buckets_[targetBucket]; i != kNothing; i = entries_[i].NextEntryIndex_)
-                if (entries_[i].HashCode_ == hashCode && key_eq()(entries_[i].KeyValue_.first, key))
+                if (entries_[i].HashCode_ == hashCode && key_eq()(entries_[i].Value_.first, key))
                 {
                     if (!addOnly)
-                        Yupei::construct(std::addressof(entries_[i].KeyValue_.second), std::forward<Args>(args)...);
+                        AssignMapped(entries_[i].Value_.second, std::forward<Args>(args)...);
                     return {{this, i}, {}};
                 }
                                          
-            const auto index = GetAvaliableEntry(hashCode, targetBucket);
-            ConstructEntry(entries_[index], std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+            const auto index = EmplaceEntry(hashCode, targetBucket, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
                 std::forward_as_tuple(std::forward<Args>(args)...));
-            auto& entry = entries_[index];
-            entry.NextEntryIndex_ = buckets_[targetBucket];
-            entry.HashCode_ = hashCode;
-            buckets_[targetBucket] = index;
             return {{this, index}, true};
         }
 
-        template<typename... Args>
-        void ConstructEntry(Entry& entry, Args&&... args)
+        //insert_or_assign 只有一个参数，键已存在时赋值给原来的值。
+        template<typename M, std::enable_if_t<std::is_assignable<mapped_type&, M&&>::value, int> = 0>
+        static void AssignMapped(mapped_type& value, M&& obj)
         {
-            YPASSERT(entry.HashCode_ == kNothing, "Construct on existing value.");
-            Yupei::construct(std::addressof(entry.KeyValue_), std::forward<Args>(args)...);
+            value = std::forward<M>(obj);
         }
 
-        size_type GetAvaliableEntry(size_type hashCode, size_type& targetBucket) noexcept
+        //try_emplace 的键已存在时不会走到这里。
+        template<typename... Args>
+        static void AssignMapped(mapped_type&, Args&&...) noexcept
         {
-            size_type index;
-            if (freeCount_ != 0)
-            {
-                index = freeList_;
-                --freeCount_;
-                freeList_ = entries_[freeList_].NextEntryIndex_;
-            }
-            else
-            {
-                if (bucketCount_ == count_)
-                {
-                    Resize();
-                    targetBucket = ConstrainHash(hashCode);
-                }
-                index = count_;
-                ++count_;
-            }
-            return index;
+            YPASSERT(false, "Only insert_or_assign assigns to an existing value!");
         }
 
-        void Resize()
-        {
-            const auto newSize = Internal::HashHelpers::ExpandPrime(bucketCount_);
-            BucketPtr newBuckets {GetSizeTypeAllocator().allocate(newSize), bucketDeleter_};
-            EntryPtr newEntries {allocator_.allocate(newSize), entryDeleter_};
-            const auto nb = newBuckets.get();
-            const auto ne = newEntries.get();
-            const auto oldEntries = entries_.get();
-            std::fill(nb, nb + newSize, kNothing);
 
-            for (std::size_t i = 0; i < count_; ++i)
-            {
-                auto& entry1 = oldEntries[i];
-                auto& entry2 = ne[i];
-                if (entry1.HashCode_ != kNothing)
-                    construct(std::addressof(entry2.KeyValue_), std::move(entry1.KeyValue_));
-                entry2.HashCode_ = entry1.HashCode_;
-                destroy_at(std::addressof(entry1));
-            }
-
-            std::for_each(ne + count_, ne + newSize, [](Entry& entry2) {
-                entry2.HashCode_ = kNothing;
-            });
-
-            bucketCount_ = newSize;
-
-            for (std::size_t i = 0; i < count_; ++i)
-            {
-                auto& entry = ne[i];
-                const auto hashCode = entry.HashCode_;
-                if (hashCode != kNothing)
-                {
-                    const auto targetBucket = ConstrainHash(hashCode);
-                    entry.NextEntryIndex_ = newBuckets[targetBucket];
-                    newBuckets[targetBucket] = i;
-                }
-            }
+        template<typename K>
+        mapped_type& At(const K& key)
+        {
+            const auto i = FindEntryByKey(key);
+            if (i == kNothing) throw std::out_of_range("Key doesn't exist!");
+            return entries_[i].Value_.second;
+        }
 
-			buckets_.reset(newBuckets.release());
-            entries_.reset(newEntries.release());
-            
-#ifdef _DEBUG
-            dEntries = entries_.get();
-#endif // _DEBUG
+        template<typename K>
+        const mapped_type& At(const K& key) const
+        {
+            const auto i = FindEntryByKey(key);
+            if (i == kNothing) throw std::out_of_range("Key doesn't exist!");
+            return entries_[i].Value_.second;
         }
 
-        size_type FindEntryByKey(const key_type& key) const
+        template<typename K>
+        node_type Extract(const K& key)
         {
-            const auto hashCode = hash_function()(key);
-            const auto targetBucket = ConstrainHash(hashCode);
-            for (auto i = buckets_[targetBucket]; i != kNothing; i = entries_[i].NextEntryIndex_)
-                if (entries_[i].HashCode_ == hashCode && key_eq()(entries_[i].KeyValue_.first, key))
-                    return i;
-            return kNothing;
+            if (!buckets_) return {};
+            const auto i = FindEntryByKey(key);
+            if (i == kNothing) return {};
+            return extract(const_iterator {this, i});
         }
+
     };
 
     namespace Internal
@@ -848,7 +961,7 @@ namespace Yupei
             using Entry = typename DictionaryT::Entry;
             YPASSERT(dict_ != nullptr, "Iterator is null!");
             const auto entries = dict_->entries_.get();
-            const auto i = std::find_if(entries + index_, entries + dict_->count_, [](const Entry& entry) {
+            const auto i = std::find_if(entries + index_ + 1, entries + dict_->count_, [](const Entry& entry) {
                 return entry.HashCode_ != -1;
             });
             index_ = i - entries;
@@ -861,7 +974,7 @@ namespace Yupei
             using Entry = typename DictionaryT::Entry;
             YPASSERT(dict_ != nullptr, "Iterator is null!");
             const auto entries = dict_->entries_.get();
-            const auto i = std::find_if(entries + index_, entries + dict_->count_, [](const Entry& entry) {
+            const auto i = std::find_if(entries + index_ + 1, entries + dict_->count_, [](const Entry& entry) {
                 return entry.HashCode_ != -1;
             });
             index_ = i - entries;
@@ -872,7 +985,7 @@ namespace Yupei
         auto DictionaryLocalIterator<DictionaryT>::operator++() noexcept -> DictionaryLocalIterator&
         {
             YPASSERT(dict_ != nullptr, "Iterator is null!");
-            YPASSERT(index_ == -1, "Increase an end iterator!");
+            YPASSERT(index_ != -1, "Increase an end iterator!");
             index_ = dict_->entries_[index_].NextEntryIndex_;
             return *this;
         }
@@ -881,7 +994,7 @@ namespace Yupei
         auto DictionaryConstLocalIterator<DictionaryT>::operator++() noexcept -> DictionaryConstLocalIterator&
         {
             YPASSERT(dict_ != nullptr, "Iterator is null!");
-            YPASSERT(index_ == -1, "Increase an end iterator!");
+            YPASSERT(index_ != -1, "Increase an end iterator!");
             index_ = dict_->entries_[index_].NextEntryIndex_;
             return *this;
         }
@@ -0,0 +1,541 @@
+﻿#pragma once
+
+#include "Dictionary.hpp"
+#include "Vector.hpp"
+#include "../Hash/Hash.hpp"
+#include "../Hash/HashHelpers.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../Scope.hpp"
+#include "../Assert.hpp"
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <numeric>
+#include <iterator>
+#include <type_traits>
+
+namespace Yupei
+{
+    //只读的字典。构造时对全部键计算一个最小完美哈希（CHD: hash, displace and compress），
+    //元素按槽位紧凑地存放在一个数组里，没有链也没有空桶。
+    //查找 = 一次哈希 + 一次位移表读取 + 一次槽位读取 + 一次键比较。
+    //完整哈希值相同的键无论换哪个种子都会冲突，除第一个外都放到数组末尾的溢出区，槽位上的键不匹配时再顺序查找溢出区。
+    //http://cmph.sourceforge.net/papers/esa09.pdf
+    template<typename KeyT, typename ValueT, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>>
+    class frozen_dictionary : KeyEqualT, HashFun
+    {
+    public:
+        using key_type = KeyT;
+        using mapped_type = ValueT;
+        using value_type = std::pair<key_type, mapped_type>;
+        using size_type = std::size_t;
+        using allocator_type = polymorphic_allocator<value_type>;
+        using key_equal = KeyEqualT;
+        using hasher = HashFun;
+        using const_iterator = const value_type*;
+        using iterator = const_iterator;
+        using dictionary_type = dictionary<KeyT, ValueT, HashFun, KeyEqualT>;
+
+    private:
+        static constexpr size_type kNothing = static_cast<size_type>(-1);
+        //每个位移桶平均容纳的键数，即 CHD 论文中的 lambda。
+        static constexpr size_type kAverageBucketSize = 4;
+        //每个位移桶最多尝试的 d0 个数，超过后换一个种子重新构造。
+        static constexpr size_type kMaxD0 = 64;
+        static constexpr std::uint64_t kMaxSeeds = 16;
+
+        struct Displacement
+        {
+            size_type D0_;
+            size_type D1_;
+        };
+
+    public:
+        explicit frozen_dictionary(memory_resource_ptr pmr = {})
+            :allocator_{pmr}
+        {}
+
+        explicit frozen_dictionary(const dictionary_type& dict, memory_resource_ptr pmr = {})
+            :key_equal{dict.key_eq()},
+            hasher{dict.hash_function()},
+            allocator_{pmr}
+        {
+            Build(dict);
+        }
+
+        explicit frozen_dictionary(dictionary_type&& dict, memory_resource_ptr pmr = {})
+            :key_equal{dict.key_eq()},
+            hasher{dict.hash_function()},
+            allocator_{pmr}
+        {
+            Build(std::move(dict));
+        }
+
+        //重复的键只保留第一个，与 dictionary::insert 一致。
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        frozen_dictionary(InputItT first, InputItT last, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :frozen_dictionary(dictionary_type(first, last, {}, hash, keyEqual, pmr), pmr)
+        {}
+
+        frozen_dictionary(std::initializer_list<value_type> init, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :frozen_dictionary(init.begin(), init.end(), hash, keyEqual, pmr)
+        {}
+
+        frozen_dictionary(const frozen_dictionary& other)
+            :frozen_dictionary(other, other.allocator_.resource())
+        {}
+
+        //复制到 pmr 上，不需要重新构造完美哈希。
+        frozen_dictionary(const frozen_dictionary& other, memory_resource_ptr pmr)
+            :key_equal{other.key_eq()},
+            hasher{other.hash_function()},
+            allocator_{pmr},
+            size_{other.size_},
+            perfectCount_{other.perfectCount_},
+            bucketCount_{other.bucketCount_},
+            seed_{other.seed_}
+        {
+            CloneArrays(other);
+        }
+
+        frozen_dictionary(frozen_dictionary&& other) noexcept
+            :key_equal{other.key_eq()},
+            hasher{other.hash_function()},
+            allocator_{other.allocator_},
+            size_{other.size_},
+            perfectCount_{other.perfectCount_},
+            bucketCount_{other.bucketCount_},
+            seed_{other.seed_},
+            entries_{other.entries_},
+            displacements_{other.displacements_}
+        {
+            other.size_ = {};
+            other.perfectCount_ = {};
+            other.bucketCount_ = {};
+            other.entries_ = {};
+            other.displacements_ = {};
+        }
+
+        //pmr 与 other 的分配器相等时直接接管数组，否则逐个移动元素，other 随后被清空。
+        frozen_dictionary(frozen_dictionary&& other, memory_resource_ptr pmr)
+            :key_equal{other.key_eq()},
+            hasher{other.hash_function()},
+            allocator_{pmr},
+            size_{other.size_},
+            perfectCount_{other.perfectCount_},
+            bucketCount_{other.bucketCount_},
+            seed_{other.seed_}
+        {
+            if (allocator_ == other.allocator_)
+            {
+                entries_ = other.entries_;
+                displacements_ = other.displacements_;
+                other.size_ = {};
+                other.perfectCount_ = {};
+                other.bucketCount_ = {};
+                other.entries_ = {};
+                other.displacements_ = {};
+            }
+            else
+            {
+                CloneArrays(std::move(other));
+                other.Release();
+            }
+        }
+
+        //赋值不改变本字典的分配器。
+        frozen_dictionary& operator=(const frozen_dictionary& other)
+        {
+            if (this != &other)
+                frozen_dictionary(other, allocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        frozen_dictionary& operator=(frozen_dictionary&& other)
+        {
+            if (this != &other)
+                frozen_dictionary(std::move(other), allocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        ~frozen_dictionary()
+        {
+            Release();
+        }
+
+        //要求两边的分配器相等。哈希函数与 key_equal 随数组一起交换，种子只对原来的哈希函数有效。
+        void swap(frozen_dictionary& other) noexcept
+        {
+            YPASSERT(allocator_ == other.allocator_, "Allocators of swapped frozen_dictionaries must be equal.");
+            using std::swap;
+            swap(static_cast<hasher&>(*this), static_cast<hasher&>(other));
+            swap(static_cast<key_equal&>(*this), static_cast<key_equal&>(other));
+            swap(size_, other.size_);
+            swap(perfectCount_, other.perfectCount_);
+            swap(bucketCount_, other.bucketCount_);
+            swap(seed_, other.seed_);
+            swap(entries_, other.entries_);
+            swap(displacements_, other.displacements_);
+        }
+
+        allocator_type get_allocator() const noexcept
+        {
+            return allocator_;
+        }
+
+        hasher hash_function() const
+        {
+            return static_cast<hasher>(*this);
+        }
+
+        key_equal key_eq() const
+        {
+            return static_cast<key_equal>(*this);
+        }
+
+        size_type size() const noexcept
+        {
+            return size_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return entries_;
+        }
+
+        const_iterator end() const noexcept
+        {
+            return entries_ + size_;
+        }
+
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+
+        const_iterator find(const key_type& key) const
+        {
+            return MakeIterator(FindSlot(key));
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        const_iterator find(const K& key) const
+        {
+            return MakeIterator(FindSlot(key));
+        }
+
+        bool contains(const key_type& key) const
+        {
+            return FindSlot(key) != kNothing;
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        bool contains(const K& key) const
+        {
+            return FindSlot(key) != kNothing;
+        }
+
+        const mapped_type& at(const key_type& key) const
+        {
+            return At(key);
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        const mapped_type& at(const K& key) const
+        {
+            return At(key);
+        }
+
+    private:
+        polymorphic_allocator<Displacement> GetDisplacementAllocator() const noexcept
+        {
+            return polymorphic_allocator<Displacement>{allocator_.resource()};
+        }
+
+        const_iterator MakeIterator(size_type slot) const noexcept
+        {
+            return slot == kNothing ? end() : entries_ + slot;
+        }
+
+        template<typename K>
+        const mapped_type& At(const K& key) const
+        {
+            const auto slot = FindSlot(key);
+            if (slot == kNothing) throw std::out_of_range("Key doesn't exist!");
+            return entries_[slot].second;
+        }
+
+        template<typename K>
+        size_type FindSlot(const K& key) const
+        {
+            if (size_ == 0) return kNothing;
+            const auto hashCode = hash_function()(key);
+            const auto& displacement = displacements_[hashCode % bucketCount_];
+            const auto slot = SlotOf(hashCode, displacement.D0_, displacement.D1_);
+            if (key_eq()(entries_[slot].first, key))
+                return slot;
+            for (auto i = perfectCount_; i < size_; ++i)
+                if (key_eq()(entries_[i].first, key))
+                    return i;
+            return kNothing;
+        }
+
+        //槽位 = (f1 + d0 * f2 + d1) mod n，f1 与 f2 由混合后的哈希值导出，n 为完美哈希部分的键数。
+        size_type SlotOf(size_type hashCode, size_type d0, size_type d1) const noexcept
+        {
+            const auto n = static_cast<std::uint64_t>(perfectCount_);
+            //种子先乘黄金比例常数再异或，否则相邻的小哈希值在不同种子下只是互相置换。
+            const auto mixed = Internal::MixHash(static_cast<std::uint64_t>(hashCode) ^ (seed_ * 0x9e3779b97f4a7c15ull));
+            const auto f1 = mixed % n;
+            const auto f2 = (mixed >> 32) % n;
+            return static_cast<size_type>((f1 + d0 * f2 + d1) % n);
+        }
+
+        template<typename DictionaryT>
+        void Build(DictionaryT&& dict)
+        {
+            using SourceReference = std::conditional_t<std::is_lvalue_reference<DictionaryT>::value, const value_type&, value_type&&>;
+            const auto n = dict.size();
+            if (n == 0) return;
+
+            const auto resource = allocator_.resource();
+
+            //复用 dictionary 中保存的哈希值，不再重新计算。
+            vector<size_type> hashes(n, resource);
+            vector<const value_type*> sources(n, resource);
+            size_type i = {};
+            for (auto it = dict.begin(); it != dict.end(); ++it, ++i)
+            {
+                hashes[i] = dict.stored_hash(it);
+                sources[i] = std::addressof(*it);
+            }
+
+            //按哈希值排序找出完整哈希值相同的键，每组只有第一个参与完美哈希，其余的依次放进溢出区。
+            vector<size_type> slots(n, resource);
+            vector<unsigned char> overflow(n, 0, resource);
+            {
+                vector<size_type> byHash(n, resource);
+                std::iota(byHash.data(), byHash.data() + n, size_type{});
+                std::sort(byHash.data(), byHash.data() + n, [&](size_type lhs, size_type rhs) {
+                    return hashes[lhs] < hashes[rhs];
+                });
+                for (i = 1; i < n; ++i)
+                    if (hashes[byHash[i]] == hashes[byHash[i - 1]])
+                        overflow[byHash[i]] = 1;
+            }
+            const auto overflowCount = static_cast<size_type>(std::count(overflow.data(), overflow.data() + n, static_cast<unsigned char>(1)));
+            const auto m = n - overflowCount;
+            bucketCount_ = (m + kAverageBucketSize - 1) / kAverageBucketSize;
+            {
+                auto next = m;
+                for (i = 0; i < n; ++i)
+                    if (overflow[i])
+                        slots[i] = next++;
+            }
+
+            //按位移桶做计数排序，members 中同一个桶的键连续存放。
+            vector<size_type> bucketStarts(bucketCount_ + 1, 0, resource);
+            for (i = 0; i < n; ++i)
+                if (!overflow[i])
+                    ++bucketStarts[hashes[i] % bucketCount_ + 1];
+            std::partial_sum(bucketStarts.data(), bucketStarts.data() + bucketCount_ + 1, bucketStarts.data());
+            vector<size_type> members(m, resource);
+            {
+                vector<size_type> cursors(bucketCount_, resource);
+                std::copy(bucketStarts.data(), bucketStarts.data() + bucketCount_, cursors.data());
+                for (i = 0; i < n; ++i)
+                    if (!overflow[i])
+                        members[cursors[hashes[i] % bucketCount_]++] = i;
+            }
+
+            //先放大的桶，此时空槽多，容易找到位移。
+            vector<size_type> bucketOrder(bucketCount_, resource);
+            std::iota(bucketOrder.data(), bucketOrder.data() + bucketCount_, size_type{});
+            std::stable_sort(bucketOrder.data(), bucketOrder.data() + bucketCount_, [&](size_type lhs, size_type rhs) {
+                return bucketStarts[lhs + 1] - bucketStarts[lhs] > bucketStarts[rhs + 1] - bucketStarts[rhs];
+            });
+
+            size_ = n;
+            perfectCount_ = m;
+            displacements_ = GetDisplacementAllocator().allocate(bucketCount_);
+            SCOPE_FAIL{
+                GetDisplacementAllocator().deallocate(displacements_, bucketCount_);
+                displacements_ = {};
+                size_ = {};
+                perfectCount_ = {};
+                bucketCount_ = {};
+            };
+
+            vector<unsigned char> occupied(m, 0, resource);
+            for (seed_ = {};; ++seed_)
+            {
+                if (TryPlace(hashes, bucketStarts, members, bucketOrder, slots, occupied))
+                    break;
+                if (seed_ + 1 == kMaxSeeds)
+                    throw std::invalid_argument("Failed to build a perfect hash for the keys!");
+                std::fill(occupied.data(), occupied.data() + m, static_cast<unsigned char>(0));
+            }
+
+            entries_ = allocator_.allocate(n);
+            SCOPE_FAIL{
+                allocator_.deallocate(entries_, n);
+                entries_ = {};
+            };
+            for (i = 0; i < n; ++i)
+            {
+                SCOPE_FAIL{
+                    for (size_type j = 0; j < i; ++j)
+                        Yupei::destroy_at(entries_ + slots[j]);
+                };
+                //dict 是右值时可以把元素搬走。
+                Yupei::construct(entries_ + slots[i], static_cast<SourceReference>(const_cast<value_type&>(*sources[i])));
+            }
+        }
+
+        bool TryPlace(const vector<size_type>& hashes, const vector<size_type>& bucketStarts, const vector<size_type>& members,
+            const vector<size_type>& bucketOrder, vector<size_type>& slots, vector<unsigned char>& occupied)
+        {
+            const auto n = perfectCount_;
+            //单键的桶放在最后，直接取下一个空槽即可，不需要搜索。
+            size_type freeCursor = {};
+            for (size_type k = 0; k < bucketCount_; ++k)
+            {
+                const auto bucket = bucketOrder[k];
+                const auto first = bucketStarts[bucket];
+                const auto last = bucketStarts[bucket + 1];
+                auto& displacement = displacements_[bucket];
+                displacement = {};
+                if (first == last) continue;
+
+                if (last - first == 1)
+                {
+                    while (occupied[freeCursor]) ++freeCursor;
+                    const auto key = members[first];
+                    const auto base = SlotOf(hashes[key], 0, 0);
+                    displacement.D1_ = (freeCursor + n - base) % n;
+                    slots[key] = freeCursor;
+                    occupied[freeCursor] = 1;
+                    continue;
+                }
+
+                if (!PlaceBucket(hashes, members, first, last, displacement, slots, occupied))
+                    return false;
+            }
+            return true;
+        }
+
+        bool PlaceBucket(const vector<size_type>& hashes, const vector<size_type>& members, size_type first, size_type last,
+            Displacement& displacement, vector<size_type>& slots, vector<unsigned char>& occupied)
+        {
+            const auto n = perfectCount_;
+            for (size_type d0 = 0; d0 < kMaxD0; ++d0)
+            {
+                //d1 只是整体平移，若 d1 = 0 时桶内已经互相冲突，换哪个 d1 都没用。
+                for (auto j = first; j < last; ++j)
+                    slots[members[j]] = SlotOf(hashes[members[j]], d0, 0);
+                if (HasInnerCollision(members, first, last, slots))
+                    continue;
+
+                for (size_type d1 = 0; d1 < n; ++d1)
+                {
+                    const auto fits = std::none_of(members.data() + first, members.data() + last, [&](size_type key) {
+                        return occupied[(slots[key] + d1) % n] != 0;
+                    });
+                    if (fits)
+                    {
+                        for (auto j = first; j < last; ++j)
+                        {
+                            auto& slot = slots[members[j]];
+                            slot = (slot + d1) % n;
+                            occupied[slot] = 1;
+                        }
+                        displacement.D0_ = d0;
+                        displacement.D1_ = d1;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        static bool HasInnerCollision(const vector<size_type>& members, size_type first, size_type last, const vector<size_type>& slots) noexcept
+        {
+            for (auto j = first; j < last; ++j)
+                for (auto k = j + 1; k < last; ++k)
+                    if (slots[members[j]] == slots[members[k]])
+                        return true;
+            return false;
+        }
+
+        //大小与种子已经从 other 复制过来。other 为右值时移动元素。
+        template<typename FrozenDictionaryT>
+        void CloneArrays(FrozenDictionaryT&& other)
+        {
+            using SourceIt = std::conditional_t<std::is_lvalue_reference<FrozenDictionaryT>::value, const value_type*, std::move_iterator<value_type*>>;
+            if (size_ == 0) return;
+            displacements_ = GetDisplacementAllocator().allocate(bucketCount_);
+            SCOPE_FAIL{
+                GetDisplacementAllocator().deallocate(displacements_, bucketCount_);
+            };
+            std::copy(other.displacements_, other.displacements_ + bucketCount_, displacements_);
+            entries_ = allocator_.allocate(size_);
+            SCOPE_FAIL{
+                allocator_.deallocate(entries_, size_);
+            };
+            std::uninitialized_copy(SourceIt(other.entries_), SourceIt(other.entries_ + size_), entries_);
+        }
+
+        void Release() noexcept
+        {
+            Yupei::destroy_n(entries_, size_);
+            if (entries_)
+                allocator_.deallocate(entries_, size_);
+            if (displacements_)
+                GetDisplacementAllocator().deallocate(displacements_, bucketCount_);
+            entries_ = {};
+            displacements_ = {};
+            size_ = {};
+            perfectCount_ = {};
+            bucketCount_ = {};
+        }
+
+        polymorphic_allocator<value_type> allocator_;
+        size_type size_ = {};
+        //[0, perfectCount_) 由完美哈希定位，[perfectCount_, size_) 是溢出区。
+        size_type perfectCount_ = {};
+        size_type bucketCount_ = {};
+        std::uint64_t seed_ = {};
+        value_type* entries_ = {};
+        Displacement* displacements_ = {};
+    };
+
+    template<typename KeyT, typename ValueT, typename HashFun, typename KeyEqualT>
+    decltype(auto) begin(const frozen_dictionary<KeyT, ValueT, HashFun, KeyEqualT>& dict) noexcept
+    {
+        return dict.begin();
+    }
+
+    template<typename KeyT, typename ValueT, typename HashFun, typename KeyEqualT>
+    decltype(auto) end(const frozen_dictionary<KeyT, ValueT, HashFun, KeyEqualT>& dict) noexcept
+    {
+        return dict.end();
+    }
+
+    template<typename KeyT, typename ValueT, typename HashFun, typename KeyEqualT>
+    decltype(auto) size(const frozen_dictionary<KeyT, ValueT, HashFun, KeyEqualT>& dict) noexcept
+    {
+        return dict.size();
+    }
+}
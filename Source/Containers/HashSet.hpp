@@ -0,0 +1,484 @@
+﻿#pragma once
+
+#include "HashTable.hpp"
+#include "../Hash/Hash.hpp"
+#include "../Iterator.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../Assert.hpp"
+#include "../Scope.hpp"
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+namespace Yupei
+{
+    template<typename KeyT, typename HashFun, typename KeyEqualT>
+    class hash_set;
+
+    namespace Internal
+    {
+        //集合中的元素不可修改，只有 const 迭代器。
+        template<typename HashSetT>
+        class HashSetIterator
+        {
+            template<typename, typename, typename>
+            friend class Yupei::hash_set;
+
+            HashSetIterator(const HashSetT* set, size_type_t<HashSetT> index) noexcept
+                :set_{set}, index_{index}
+            {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = typename HashSetT::value_type;
+            using iterator_category = std::forward_iterator_tag;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            constexpr HashSetIterator() noexcept
+                :set_{}, index_{}
+            {}
+
+            HashSetIterator& operator++() noexcept
+            {
+                YPASSERT(set_ != nullptr, "Iterator is null!");
+                index_ = set_->NextEntry(index_ + 1);
+                return *this;
+            }
+
+            HashSetIterator operator++(int) noexcept
+            {
+                auto tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            reference operator*() const noexcept
+            {
+                YPASSERT(index_ < set_->count_, "Deref an end iterator!");
+                return set_->entries_[index_].Value_;
+            }
+
+            pointer operator->() const noexcept
+            {
+                return std::addressof(this->operator*());
+            }
+
+            bool operator==(const HashSetIterator& other) const noexcept
+            {
+                YPASSERT(set_ == other.set_, "Two iterators are not compatible!");
+                return index_ == other.index_;
+            }
+
+            bool operator!=(const HashSetIterator& other) const noexcept
+            {
+                return !(*this == other);
+            }
+
+        private:
+            const HashSetT* set_;
+            size_type_t<HashSetT> index_;
+        };
+    }
+
+    //只有键的哈希集合。与 dictionary 共用 Internal::HashTable（entry 数组 + 桶数组 + 空闲链表 + 保存的哈希值），
+    //只是 entry 里没有 mapped 值，也就没有 std::pair 带来的填充。
+    //集合运算直接使用保存的哈希值，因此两边的哈希函数必须等价；结果总是放在本集合里，使用本集合的分配器。
+    template<typename KeyT, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>>
+    class hash_set : Internal::HashTable<KeyT, Internal::IdentityKey, HashFun, KeyEqualT>
+    {
+        using Base = Internal::HashTable<KeyT, Internal::IdentityKey, HashFun, KeyEqualT>;
+
+    public:
+        using key_type = KeyT;
+        using value_type = KeyT;
+        using size_type = std::size_t;
+        using key_equal = KeyEqualT;
+        using hasher = HashFun;
+        using iterator = Internal::HashSetIterator<hash_set>;
+        using const_iterator = iterator;
+
+        using Base::hash_function;
+        using Base::key_eq;
+        using Base::size;
+        using Base::empty;
+        using Base::bucket_count;
+        using Base::reserve;
+        using Base::clear;
+        using Base::stats;
+
+    private:
+        template<typename>
+        friend class Internal::HashSetIterator;
+
+        using Base::kNothing;
+        using Base::count_;
+        using Base::allocator_;
+        using Base::entries_;
+        using Base::GetSizeTypeAllocator;
+        using Base::NextEntry;
+        using Base::AddEntry;
+        using Base::RemoveEntry;
+        using Base::FindEntryByKey;
+        using Base::EraseByKey;
+
+    public:
+        hash_set()
+            :hash_set(size_type{})
+        {}
+
+        explicit hash_set(memory_resource_ptr pmr)
+            :hash_set(size_type{}, {}, {}, pmr)
+        {}
+
+        explicit hash_set(size_type bucketCount, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :Base { bucketCount, hash, keyEqual, pmr }
+        {}
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        hash_set(InputItT first, InputItT last, size_type bucketCount = {}, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :hash_set(bucketCount, hash, keyEqual, pmr)
+        {
+            insert_range(first, last);
+        }
+
+        hash_set(std::initializer_list<value_type> init, memory_resource_ptr pmr = {})
+            :hash_set(init.begin(), init.end(), size_type{}, {}, {}, pmr)
+        {}
+
+        //与 dictionary 一样按结构复制，不重新计算哈希。
+        hash_set(const hash_set& other)
+            :hash_set(other, other.allocator_.resource())
+        {}
+
+        //复制到 pmr 上。
+        hash_set(const hash_set& other, memory_resource_ptr pmr)
+            :Base { other, pmr }
+        {}
+
+        hash_set(hash_set&& other) noexcept
+            :Base { std::move(other) }
+        {}
+
+        //赋值不改变本集合的分配器。
+        hash_set& operator=(const hash_set& other)
+        {
+            if (this != &other)
+                hash_set(other, allocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        //分配器不同时不能接管 other 的数组，只能逐个移动元素。
+        hash_set& operator=(hash_set&& other)
+        {
+            if (this == &other) return *this;
+            if (allocator_ == other.allocator_)
+                hash_set(std::move(other)).swap(*this);
+            else
+            {
+                hash_set result(other.size(), hash_function(), key_eq(), allocator_.resource());
+                result.InsertFrom(std::move(other));
+                swap(result);
+            }
+            return *this;
+        }
+
+        //与 dictionary 一样，要求两边的分配器相等。
+        void swap(hash_set& other) noexcept
+        {
+            YPASSERT(allocator_ == other.allocator_, "Allocators of swapped hash_sets must be equal.");
+            this->SwapTable(other);
+        }
+
+
+        //WARNING: This is not O(1).
+        const_iterator begin() const noexcept
+        {
+            return {this, NextEntry(0)};
+        }
+
+        const_iterator end() const noexcept
+        {
+            return {this, count_};
+        }
+
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+
+        const_iterator find(const key_type& key) const
+        {
+            return MakeIterator(FindEntryByKey(key, hash_function()(key)));
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        const_iterator find(const K& key) const
+        {
+            return MakeIterator(FindEntryByKey(key, hash_function()(key)));
+        }
+
+        bool contains(const key_type& key) const
+        {
+            return FindEntryByKey(key, hash_function()(key)) != kNothing;
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value, int> = 0>
+        bool contains(const K& key) const
+        {
+            return FindEntryByKey(key, hash_function()(key)) != kNothing;
+        }
+
+        size_type count(const key_type& key) const
+        {
+            return contains(key) ? 1 : 0;
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return InsertHashed(hash_function()(value), value);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value)
+        {
+            return InsertHashed(hash_function()(value), std::move(value));
+        }
+
+        //异质版本：只有在真正插入时才会用 key 构造 value_type。
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value &&
+            !std::is_convertible<K, const_iterator>::value, int> = 0>
+        std::pair<iterator, bool> insert(K&& key)
+        {
+            return InsertHashed(hash_function()(key), std::forward<K>(key));
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void insert(InputItT first, InputItT last)
+        {
+            insert_range(first, last);
+        }
+
+        void insert(std::initializer_list<value_type> init)
+        {
+            insert_range(init.begin(), init.end());
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args)
+        {
+            return insert(value_type(std::forward<Args>(args)...));
+        }
+
+        //批量插入：forward iterator 时只分配一次，并先在一个紧凑的循环里算完所有哈希。
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void insert_range(InputItT first, InputItT last)
+        {
+            InsertRange(first, last, is_forward_iterator<InputItT>{});
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            YPASSERT(pos.index_ < count_, "Erase an end iterator!");
+            const auto next = NextEntry(pos.index_ + 1);
+            RemoveEntry(pos.index_);
+            return {this, next};
+        }
+
+        bool erase(const key_type& key)
+        {
+            return EraseByKey(key, hash_function()(key));
+        }
+
+        template<typename K, typename HashT = hasher, std::enable_if_t<Internal::IsTransparentLookup<HashT, key_equal>::value &&
+            !std::is_convertible<K, const_iterator>::value, int> = 0>
+        bool erase(K&& key)
+        {
+            return EraseByKey(key, hash_function()(key));
+        }
+
+        //*this ∪= other。总是把 other 的元素插入本集合，用的是本集合的分配器与哈希函数。
+        void union_with(const hash_set& other)
+        {
+            if (&other == this) return;
+            InsertFrom(other);
+        }
+
+        void union_with(hash_set&& other)
+        {
+            if (&other == this) return;
+            InsertFrom(std::move(other));
+        }
+
+
+        //*this ∩= other。
+        void intersect_with(const hash_set& other)
+        {
+            if (&other == this) return;
+            if (size() <= other.size())
+            {
+                for (size_type i = 0; i < count_; ++i)
+                {
+                    const auto& entry = entries_[i];
+                    if (entry.HashCode_ != kNothing && other.FindEntryByKey(entry.Value_, entry.HashCode_) == kNothing)
+                        RemoveEntry(i);
+                }
+            }
+            else
+            {
+                hash_set result(other.size(), hash_function(), key_eq(), allocator_.resource());
+                for (size_type i = 0; i < other.count_; ++i)
+                {
+                    const auto& entry = other.entries_[i];
+                    if (entry.HashCode_ == kNothing) continue;
+                    const auto j = FindEntryByKey(entry.Value_, entry.HashCode_);
+                    if (j != kNothing)
+                        result.AddEntry(entry.HashCode_, std::move(entries_[j].Value_));
+                }
+                swap(result);
+            }
+        }
+
+        //*this -= other。
+        void except_with(const hash_set& other)
+        {
+            if (&other == this)
+            {
+                clear();
+                return;
+            }
+            if (other.size() < size())
+            {
+                for (size_type i = 0; i < other.count_; ++i)
+                {
+                    const auto& entry = other.entries_[i];
+                    if (entry.HashCode_ != kNothing)
+                        EraseByKey(entry.Value_, entry.HashCode_);
+                }
+            }
+            else
+            {
+                for (size_type i = 0; i < count_; ++i)
+                {
+                    const auto& entry = entries_[i];
+                    if (entry.HashCode_ != kNothing && other.FindEntryByKey(entry.Value_, entry.HashCode_) != kNothing)
+                        RemoveEntry(i);
+                }
+            }
+        }
+
+        bool is_subset_of(const hash_set& other) const
+        {
+            if (size() > other.size()) return false;
+            for (size_type i = 0; i < count_; ++i)
+            {
+                const auto& entry = entries_[i];
+                if (entry.HashCode_ != kNothing && other.FindEntryByKey(entry.Value_, entry.HashCode_) == kNothing)
+                    return false;
+            }
+            return true;
+        }
+
+        friend bool operator==(const hash_set& lhs, const hash_set& rhs)
+        {
+            return lhs.size() == rhs.size() && lhs.is_subset_of(rhs);
+        }
+
+        friend bool operator!=(const hash_set& lhs, const hash_set& rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        const_iterator MakeIterator(size_type index) const noexcept
+        {
+            return {this, index == kNothing ? count_ : index};
+        }
+
+        template<typename InputItT>
+        void InsertRange(InputItT first, InputItT last, std::false_type)
+        {
+            for (; first != last; ++first)
+                insert(*first);
+        }
+
+        template<typename ForwardItT>
+        void InsertRange(ForwardItT first, ForwardItT last, std::true_type)
+        {
+            const auto n = static_cast<size_type>(std::distance(first, last));
+            if (n == 0) return;
+            reserve(size() + n);
+
+            const auto hashes = GetSizeTypeAllocator().allocate(n);
+            SCOPE_EXIT{
+                GetSizeTypeAllocator().deallocate(hashes, n);
+            };
+            auto it = first;
+            for (size_type i = 0; i < n; ++i, ++it)
+                hashes[i] = hash_function()(*it);
+            for (size_type i = 0; i < n; ++i, ++first)
+                InsertHashed(hashes[i], *first);
+        }
+
+        //把 source 中的元素按保存的哈希值插入。
+        template<typename HashSetT>
+        void InsertFrom(HashSetT&& source)
+        {
+            using KeyRef = std::conditional_t<std::is_lvalue_reference<HashSetT>::value, const value_type&, value_type&&>;
+            reserve(size() + source.size());
+            for (size_type i = 0; i < source.count_; ++i)
+            {
+                auto& entry = source.entries_[i];
+                if (entry.HashCode_ != kNothing)
+                    InsertHashed(entry.HashCode_, static_cast<KeyRef>(entry.Value_));
+            }
+        }
+
+        template<typename K>
+        std::pair<iterator, bool> InsertHashed(size_type hashCode, K&& key)
+        {
+            YPASSERT(hash_function()(key) == hashCode, "Hash code doesn't match the key!");
+            const auto i = FindEntryByKey(key, hashCode);
+            if (i != kNothing) return {{this, i}, false};
+            return {{this, AddEntry(hashCode, std::forward<K>(key))}, true};
+        }
+    };
+
+    template<typename KeyT, typename HashFun, typename KeyEqualT>
+    hash_set<KeyT, HashFun, KeyEqualT> set_union(const hash_set<KeyT, HashFun, KeyEqualT>& lhs, const hash_set<KeyT, HashFun, KeyEqualT>& rhs)
+    {
+        const auto& larger = lhs.size() >= rhs.size() ? lhs : rhs;
+        hash_set<KeyT, HashFun, KeyEqualT> result {larger};
+        result.union_with(&larger == &lhs ? rhs : lhs);
+        return result;
+    }
+
+    template<typename KeyT, typename HashFun, typename KeyEqualT>
+    hash_set<KeyT, HashFun, KeyEqualT> set_intersection(const hash_set<KeyT, HashFun, KeyEqualT>& lhs, const hash_set<KeyT, HashFun, KeyEqualT>& rhs)
+    {
+        const auto& smaller = lhs.size() <= rhs.size() ? lhs : rhs;
+        hash_set<KeyT, HashFun, KeyEqualT> result {smaller};
+        result.intersect_with(&smaller == &lhs ? rhs : lhs);
+        return result;
+    }
+
+    template<typename KeyT, typename HashFun, typename KeyEqualT>
+    hash_set<KeyT, HashFun, KeyEqualT> set_difference(const hash_set<KeyT, HashFun, KeyEqualT>& lhs, const hash_set<KeyT, HashFun, KeyEqualT>& rhs)
+    {
+        hash_set<KeyT, HashFun, KeyEqualT> result {lhs};
+        result.except_with(rhs);
+        return result;
+    }
+
+    template<typename KeyT, typename HashFun, typename KeyEqualT>
+    void swap(hash_set<KeyT, HashFun, KeyEqualT>& lhs, hash_set<KeyT, HashFun, KeyEqualT>& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+}
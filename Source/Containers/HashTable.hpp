@@ -0,0 +1,813 @@
+﻿#pragma once
+
+#include "../Hash/HashHelpers.hpp"
+#include "../Iterator.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../Extensions.hpp"
+#include "../Meta.hpp"
+#include "../Assert.hpp"
+#include "../Prefetch.hpp"
+#include "../Scope.hpp"
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <array>
+#include <memory>
+
+namespace Yupei
+{
+    //stats() 的结果。chain_length_histogram[i] 是链长为 i 的桶数，最后一格统计所有更长的链。
+    //哈希足够均匀时 average_probe_length 约为 1 + load_factor / 2，明显偏大说明哈希函数质量差；
+    //empty_buckets 很多而 size 很小则说明表过大。
+    //lookup_count 与 probe_count 只有定义了 YPDICTIONARY_COUNTERS 时才会统计，否则为 0。
+    struct dictionary_stats
+    {
+        static constexpr std::size_t kHistogramSize = 8;
+
+        std::size_t size;
+        std::size_t bucket_count;
+        std::size_t entry_capacity;
+        float load_factor;
+        std::size_t empty_buckets;
+        std::size_t max_chain_length;
+        //非空桶的平均链长。
+        double average_chain_length;
+        //查找每个已有元素所需比较次数的平均值。
+        double average_probe_length;
+        std::array<std::size_t, kHistogramSize> chain_length_histogram;
+        //空闲链表上的槽位，即 erase 留下的空洞。
+        std::size_t free_count;
+        std::size_t tombstone_bytes;
+        std::size_t bytes_allocated;
+        std::size_t lookup_count;
+        std::size_t probe_count;
+    };
+
+    namespace Internal
+    {
+        template<typename T>
+        using TransparentOp = typename T::is_transparent;
+
+        //与 C++20 无序容器一致：仅当 hasher 与 key_equal 都是 transparent 时才启用异质查找。
+        template<typename HashFun, typename KeyEqualT>
+        struct IsTransparentLookup : std::conjunction<is_detected<TransparentOp, HashFun>, is_detected<TransparentOp, KeyEqualT>> {};
+
+        template<typename K, typename KeyT, typename HashFun, typename KeyEqualT>
+        struct IsLookupKey : std::disjunction<IsTransparentLookup<HashFun, KeyEqualT>,
+            std::is_same<std::decay_t<K>, KeyT>> {};
+
+        template<typename ForwardItT, typename KeyT, typename HashFun, typename KeyEqualT>
+        struct IsBatchLookupKey : IsLookupKey<iterator_value_type_t<ForwardItT>, KeyT, HashFun, KeyEqualT> {};
+
+        //遍历所有桶链，填写 stats 中与链长有关的部分。EntryT 需要有 NextEntryIndex_。
+        template<typename EntryT>
+        void CollectChainStats(dictionary_stats& stats, const std::size_t* buckets, std::size_t bucketCount, const EntryT* entries) noexcept
+        {
+            constexpr auto kNothing = static_cast<std::size_t>(-1);
+            std::size_t probes = {};
+            stats.chain_length_histogram = {};
+            stats.empty_buckets = {};
+            stats.max_chain_length = {};
+            for (std::size_t b = 0; b < bucketCount; ++b)
+            {
+                std::size_t length = {};
+                for (auto i = buckets[b]; i != kNothing; i = entries[i].NextEntryIndex_)
+                    ++length;
+                ++stats.chain_length_histogram[std::min(length, dictionary_stats::kHistogramSize - 1)];
+                if (length == 0) ++stats.empty_buckets;
+                stats.max_chain_length = std::max(stats.max_chain_length, length);
+                //链上第 k 个元素需要比较 k 次。
+                probes += length * (length + 1) / 2;
+            }
+            const auto usedBuckets = bucketCount - stats.empty_buckets;
+            stats.average_chain_length = usedBuckets == 0 ? 0. : static_cast<double>(stats.size) / static_cast<double>(usedBuckets);
+            stats.average_probe_length = stats.size == 0 ? 0. : static_cast<double>(probes) / static_cast<double>(stats.size);
+            stats.load_factor = bucketCount == 0 ? 0.f : static_cast<float>(stats.size) / static_cast<float>(bucketCount);
+        }
+
+        //dictionary 的键是 pair 的 first。
+        struct PairKey
+        {
+            template<typename PairT>
+            static const auto& Get(const PairT& value) noexcept
+            {
+                return value.first;
+            }
+        };
+
+        //hash_set 的元素本身就是键。
+        struct IdentityKey
+        {
+            template<typename T>
+            static const T& Get(const T& value) noexcept
+            {
+                return value;
+            }
+        };
+
+        //dictionary 与 hash_set 共用的表：entry 数组 + 桶数组 + 空闲链表，entry 中保存完整的哈希值。
+        //这里只负责存储以及按键查找、插入、删除，元素类型由 ValueT 决定，KeyOfT::Get(value) 取出其中的键。
+        template<typename ValueT, typename KeyOfT, typename HashFun, typename KeyEqualT>
+        class HashTable : KeyEqualT, HashFun
+        {
+        public:
+            using size_type = std::size_t;
+            using key_equal = KeyEqualT;
+            using hasher = HashFun;
+
+            hasher hash_function() const
+            {
+                return static_cast<hasher>(*this);
+            }
+
+            key_equal key_eq() const
+            {
+                return static_cast<key_equal>(*this);
+            }
+
+            size_type size() const noexcept
+            {
+                return count_ - freeCount_;
+            }
+
+            bool empty() const noexcept
+            {
+                return size() == 0;
+            }
+
+            size_type bucket_count() const noexcept
+            {
+                return bucketCount_;
+            }
+
+            float load_factor() const noexcept
+            {
+                return static_cast<float>(size()) /
+                    static_cast<float>(bucket_count());
+            }
+
+            float max_load_factor() const noexcept
+            {
+                return maxLoadFactor_;
+            }
+
+            void max_load_factor(float ml)
+            {
+                YPASSERT(ml > 0.f, "Max load factor must be positive!");
+                maxLoadFactor_ = ml;
+                rehash(bucketCount_);
+            }
+
+            //重新分配桶与 entry，使 bucket_count() >= max(n, size() / max_load_factor())。
+            //会同时压缩掉已删除元素留下的空洞，所有迭代器失效。
+            void rehash(size_type n)
+            {
+                const auto newBucketCount = Internal::HashHelpers::GetPrime(std::max(n, BucketCountFor(size())));
+                const auto newEntryCapacity = std::max(EntryCapacityFor(newBucketCount), size());
+                if (!buckets_ || freeCount_ != 0 || newBucketCount != bucketCount_ || newEntryCapacity != entryCapacity_)
+                    Reallocate(newBucketCount, newEntryCapacity);
+            }
+
+            //保证插入 n 个元素之前不会再重新分配。只会增长。
+            void reserve(size_type n)
+            {
+                if (n > entryCapacity_)
+                    rehash(BucketCountFor(n));
+            }
+
+            void shrink_to_fit()
+            {
+                rehash(0);
+            }
+
+            //保留桶数组与容量，与标准库的 clear 一致。
+            void clear() noexcept
+            {
+                DestroyEntries();
+                const auto buckets = buckets_.get();
+                if (buckets)
+                    std::fill(buckets, buckets + bucketCount_, kNothing);
+                count_ = {};
+                freeList_ = kNothing;
+                freeCount_ = {};
+            }
+
+            //遍历整个桶数组，O(bucket_count() + size())。
+            dictionary_stats stats() const noexcept
+            {
+                dictionary_stats result {};
+                result.size = size();
+                result.bucket_count = bucketCount_;
+                result.entry_capacity = entryCapacity_;
+                result.free_count = freeCount_;
+                result.tombstone_bytes = freeCount_ * sizeof(Entry);
+                result.bytes_allocated = bucketCount_ * sizeof(size_type) + entryCapacity_ * sizeof(Entry);
+                Internal::CollectChainStats(result, buckets_.get(), buckets_ ? bucketCount_ : 0, entries_.get());
+#ifdef YPDICTIONARY_COUNTERS
+                result.lookup_count = lookupCount_;
+                result.probe_count = probeCount_;
+#endif // YPDICTIONARY_COUNTERS
+                return result;
+            }
+
+            void reset_counters() noexcept
+            {
+#ifdef YPDICTIONARY_COUNTERS
+                lookupCount_ = {};
+                probeCount_ = {};
+#endif // YPDICTIONARY_COUNTERS
+            }
+
+        protected:
+            static constexpr size_type kNothing = static_cast<size_type>(-1);
+            //FindBatch 每组同时在途的键数。
+            static constexpr size_type kBatchGroupSize = 16;
+
+            struct Entry
+            {
+                size_type HashCode_ = kNothing;
+                size_type NextEntryIndex_;
+                ValueT Value_;
+            };
+            using EntryAllocator = polymorphic_allocator<Entry>;
+            using SizeAllocator = polymorphic_allocator<size_type>;
+
+            //deleter 需要记住数组长度，memory_resource 释放时要用到分配时的大小。
+            class BucketDeleter
+            {
+            public:
+                BucketDeleter(const EntryAllocator& alloc, size_type count = {}) noexcept
+                    :allocator_{alloc}, count_{count}
+                {}
+
+                DEFAULTCOPY(BucketDeleter)
+
+                void operator()(size_type* p) noexcept
+                {
+                    allocator_.deallocate(p, count_);
+                }
+
+                void SetCount(size_type count) noexcept
+                {
+                    count_ = count;
+                }
+
+                size_type GetCount() const noexcept
+                {
+                    return count_;
+                }
+
+            private:
+                SizeAllocator allocator_;
+                size_type count_;
+            };
+
+            class EntryDeleter
+            {
+            public:
+                EntryDeleter(const EntryAllocator& alloc, size_type count = {}) noexcept
+                    : allocator_{alloc}, count_{count}
+                {}
+
+                DEFAULTCOPY(EntryDeleter)
+
+                void operator()(Entry* p) noexcept
+                {
+                    allocator_.deallocate(p, count_);
+                }
+
+                void SetCount(size_type count) noexcept
+                {
+                    count_ = count;
+                }
+
+                size_type GetCount() const noexcept
+                {
+                    return count_;
+                }
+
+            private:
+                EntryAllocator allocator_;
+                size_type count_;
+            };
+
+            using EntryPtr = std::unique_ptr<Entry[], EntryDeleter>;
+            using BucketPtr = std::unique_ptr<size_type[], BucketDeleter>;
+
+#ifdef _DEBUG
+            Entry* dEntries;
+#endif // _DEBUG
+
+            HashTable(size_type bucketCount, const hasher& hash, const key_equal& keyEqual, memory_resource_ptr pmr)
+                :key_equal { keyEqual },
+                hasher { hash },
+                allocator_ { pmr }
+            {
+                Initialize(bucketCount);
+            }
+
+            //结构化复制到 pmr 上：原样复制桶数组与 entry 数组（包括空闲链表），不重新计算哈希。
+            HashTable(const HashTable& other, memory_resource_ptr pmr)
+                :key_equal { other.key_eq() },
+                hasher { other.hash_function() },
+                maxLoadFactor_ { other.maxLoadFactor_ },
+                allocator_ { pmr }
+            {
+                CloneFrom(other);
+            }
+
+            //pmr 与 other 的分配器相等时直接接管数组，否则像复制一样按结构逐个移动元素，other 随后被清空。
+            HashTable(HashTable&& other, memory_resource_ptr pmr)
+                :key_equal { other.key_eq() },
+                hasher { other.hash_function() },
+                freeList_ { kNothing },
+                maxLoadFactor_ { other.maxLoadFactor_ },
+                allocator_ { pmr }
+            {
+                if (allocator_ == other.allocator_)
+                    SwapTable(other);
+                else
+                {
+                    CloneFrom(std::move(other));
+                    other.clear();
+                }
+            }
+
+            HashTable(HashTable&& other) noexcept
+                :key_equal { other.key_eq() },
+                hasher { other.hash_function() },
+                freeList_ { other.freeList_ },
+                freeCount_ { other.freeCount_ },
+                count_ { other.count_ },
+                bucketCount_ { other.bucketCount_ },
+                entryCapacity_ { other.entryCapacity_ },
+                maxLoadFactor_ { other.maxLoadFactor_ },
+                allocator_ { other.allocator_ },
+                entries_ { std::move(other.entries_) },
+                buckets_ { std::move(other.buckets_) }
+            {
+#ifdef _DEBUG
+                dEntries = entries_.get();
+#endif // _DEBUG
+                other.freeList_ = kNothing;
+                other.freeCount_ = {};
+                other.count_ = {};
+                other.bucketCount_ = {};
+                other.entryCapacity_ = {};
+            }
+
+            HashTable(const HashTable&) = delete;
+            HashTable& operator=(const HashTable&) = delete;
+
+            ~HashTable()
+            {
+                DestroyEntries();
+            }
+
+            //memory_resource_ptr 不能赋值，deleter 也就不能 swap，只交换指针和长度。
+            //与标准容器一样，要求两边的分配器相等。
+            void SwapTable(HashTable& other) noexcept
+            {
+                using std::swap;
+                swap(static_cast<hasher&>(*this), static_cast<hasher&>(other));
+                swap(static_cast<key_equal&>(*this), static_cast<key_equal&>(other));
+                swap(freeList_, other.freeList_);
+                swap(freeCount_, other.freeCount_);
+                swap(count_, other.count_);
+                swap(bucketCount_, other.bucketCount_);
+                swap(entryCapacity_, other.entryCapacity_);
+                swap(maxLoadFactor_, other.maxLoadFactor_);
+                SwapArray(entries_, other.entries_);
+                SwapArray(buckets_, other.buckets_);
+#ifdef _DEBUG
+                swap(dEntries, other.dEntries);
+#endif // _DEBUG
+            }
+
+            size_type freeList_;
+            size_type freeCount_ = {};
+            //最高水位线。
+            size_type count_ = {};
+            size_type bucketCount_ = {};
+            //entries_ 的长度，不超过 bucketCount_ * maxLoadFactor_。
+            size_type entryCapacity_ = {};
+            float maxLoadFactor_ = 1.f;
+#ifdef YPDICTIONARY_COUNTERS
+            //查找次数与沿链比较过的 entry 总数。
+            mutable size_type lookupCount_ = {};
+            mutable size_type probeCount_ = {};
+#endif // YPDICTIONARY_COUNTERS
+            EntryAllocator allocator_;
+            const EntryDeleter entryDeleter_ {allocator_};
+            const BucketDeleter bucketDeleter_ {allocator_};
+            //这里编译不过是因为 LWG#2520。
+            /*EntryPtr entries_ {nullptr, entryDeleter_};
+            BucketPtr buckets_ {nullptr, bucketDeleter_};*/
+            //暂时的 workaround。
+            EntryPtr entries_ { (Entry*)0, entryDeleter_ };
+            BucketPtr buckets_ { (size_type*)0, bucketDeleter_ };
+
+            static const auto& KeyOf(const Entry& entry) noexcept
+            {
+                return KeyOfT::Get(entry.Value_);
+            }
+
+            SizeAllocator GetSizeTypeAllocator() const noexcept
+            {
+                return SizeAllocator {allocator_.resource()};
+            }
+
+            //从 index 开始的第一个有元素的下标，没有时返回 count_。
+            size_type NextEntry(size_type index) const noexcept
+            {
+                const auto entries = entries_.get();
+                while (index < count_ && entries[index].HashCode_ == kNothing)
+                    ++index;
+                return index;
+            }
+
+            void Initialize(size_type bucketCount)
+            {
+                const auto newBucketCount = Internal::HashHelpers::GetPrime(bucketCount);
+                const auto newEntryCapacity = EntryCapacityFor(newBucketCount);
+                ResetBuckets(GetSizeTypeAllocator().allocate(newBucketCount), newBucketCount);
+                ResetEntries(allocator_.allocate(newEntryCapacity), newEntryCapacity);
+                const auto buckets = buckets_.get();
+                const auto entries = entries_.get();
+
+                std::fill(buckets, buckets + newBucketCount, kNothing);
+                std::for_each(entries, entries + newEntryCapacity, [](Entry& entry) {
+                    entry.HashCode_ = kNothing;
+                });
+
+                freeList_ = kNothing;
+                bucketCount_ = newBucketCount;
+                entryCapacity_ = newEntryCapacity;
+            }
+
+            template<typename ArrayPtrT>
+            static void SwapArray(ArrayPtrT& lhs, ArrayPtrT& rhs) noexcept
+            {
+                const auto lhsCount = lhs.get_deleter().GetCount();
+                const auto rhsCount = rhs.get_deleter().GetCount();
+                const auto lhsPtr = lhs.release();
+                lhs.reset(rhs.release());
+                lhs.get_deleter().SetCount(rhsCount);
+                rhs.reset(lhsPtr);
+                rhs.get_deleter().SetCount(lhsCount);
+            }
+
+            void ResetBuckets(size_type* buckets, size_type bucketCount) noexcept
+            {
+                buckets_.reset(buckets);
+                buckets_.get_deleter().SetCount(bucketCount);
+            }
+
+            void ResetEntries(Entry* entries, size_type entryCapacity) noexcept
+            {
+                entries_.reset(entries);
+                entries_.get_deleter().SetCount(entryCapacity);
+#ifdef _DEBUG
+                dEntries = entries;
+#endif // _DEBUG
+            }
+
+            //在 maxLoadFactor_ 下容纳 n 个元素所需的最少桶数。
+            size_type BucketCountFor(size_type n) const noexcept
+            {
+                return static_cast<size_type>(std::ceil(static_cast<double>(n) / maxLoadFactor_));
+            }
+
+            size_type EntryCapacityFor(size_type bucketCount) const noexcept
+            {
+                const auto capacity = static_cast<size_type>(static_cast<double>(bucketCount) * maxLoadFactor_);
+                return capacity == 0 ? 1 : capacity;
+            }
+
+            void DestroyEntries() noexcept
+            {
+                const auto entries = entries_.get();
+                std::for_each(entries, entries + count_, [](Entry& entry) {
+                    if (entry.HashCode_ != kNothing)
+                    {
+                        Yupei::destroy_at(std::addressof(entry.Value_));
+                        entry.HashCode_ = kNothing;
+                    }
+                });
+            }
+
+            //other 为右值时移动元素，否则复制。调用前 *this 还没有分配数组。
+            template<typename HashTableT>
+            void CloneFrom(HashTableT&& other)
+            {
+                if (!other.buckets_)
+                {
+                    Initialize({});
+                    return;
+                }
+                ResetBuckets(GetSizeTypeAllocator().allocate(other.bucketCount_), other.bucketCount_);
+                ResetEntries(allocator_.allocate(other.entryCapacity_), other.entryCapacity_);
+                freeList_ = kNothing;
+                bucketCount_ = other.bucketCount_;
+                entryCapacity_ = other.entryCapacity_;
+                SCOPE_FAIL{
+                    DestroyEntries();
+                };
+                std::copy(other.buckets_.get(), other.buckets_.get() + bucketCount_, buckets_.get());
+                CloneEntries(std::forward<HashTableT>(other), std::conjunction<std::is_trivially_copy_constructible<ValueT>, std::is_trivially_destructible<ValueT>>{});
+                std::for_each(entries_.get() + count_, entries_.get() + entryCapacity_, [](Entry& entry) {
+                    entry.HashCode_ = kNothing;
+                });
+                freeList_ = other.freeList_;
+                freeCount_ = other.freeCount_;
+            }
+
+            //元素可以按字节复制时，整个 entry 数组一次 memcpy 过来。
+            void CloneEntries(const HashTable& other, std::true_type) noexcept
+            {
+                std::memcpy(static_cast<void*>(entries_.get()), other.entries_.get(), other.count_ * sizeof(Entry));
+                count_ = other.count_;
+            }
+
+            //逐个复制或移动，count_ 随之推进，出异常时 DestroyEntries 只会析构已构造好的元素。
+            template<typename HashTableT>
+            void CloneEntries(HashTableT&& other, std::false_type)
+            {
+                using ValueRef = std::conditional_t<std::is_lvalue_reference<HashTableT>::value, const ValueT&, ValueT&&>;
+                const auto entries = entries_.get();
+                const auto source = other.entries_.get();
+                for (size_type i = 0; i < other.count_; ++i)
+                {
+                    auto& entry = entries[i];
+                    entry.HashCode_ = kNothing;
+                    entry.NextEntryIndex_ = source[i].NextEntryIndex_;
+                    count_ = i + 1;
+                    if (source[i].HashCode_ != kNothing)
+                    {
+                        Yupei::construct(std::addressof(entry.Value_), static_cast<ValueRef>(source[i].Value_));
+                        entry.HashCode_ = source[i].HashCode_;
+                    }
+                }
+            }
+
+            size_type ConstrainHash(size_type original) const noexcept
+            {
+                return original % bucketCount_;
+            }
+
+            //调用者保证键不存在。
+            template<typename... Args>
+            size_type EmplaceEntry(size_type hashCode, size_type targetBucket, Args&&... args)
+            {
+                const auto index = GetAvaliableEntry(hashCode, targetBucket);
+                auto& entry = entries_[index];
+                ConstructEntry(entry, std::forward<Args>(args)...);
+                entry.NextEntryIndex_ = buckets_[targetBucket];
+                entry.HashCode_ = hashCode;
+                buckets_[targetBucket] = index;
+                return index;
+            }
+
+            //同上，桶由 hashCode 算出，被移动后的表会先重新初始化。
+            template<typename... Args>
+            size_type AddEntry(size_type hashCode, Args&&... args)
+            {
+                if (!buckets_) Initialize({});
+                return EmplaceEntry(hashCode, ConstrainHash(hashCode), std::forward<Args>(args)...);
+            }
+
+            //把 index 从所在的桶链上摘下来，不析构元素。
+            void UnlinkEntry(size_type index) noexcept
+            {
+                const auto& entry = entries_[index];
+                const auto targetBucket = ConstrainHash(entry.HashCode_);
+                auto last = kNothing;
+                for (size_type i = buckets_[targetBucket]; i != index; last = i, i = entries_[i].NextEntryIndex_)
+                    ;
+                if (last == kNothing)
+                    buckets_[targetBucket] = entry.NextEntryIndex_;
+                else
+                    entries_[last].NextEntryIndex_ = entry.NextEntryIndex_;
+            }
+
+            //析构已摘下的元素并把槽位放进空闲链表。
+            void ReleaseEntry(size_type index) noexcept
+            {
+                auto& entry = entries_[index];
+                entry.HashCode_ = kNothing;
+                entry.NextEntryIndex_ = freeList_;
+                freeList_ = index;
+                ++freeCount_;
+                Yupei::destroy_at(std::addressof(entry.Value_));
+            }
+
+            void RemoveEntry(size_type index) noexcept
+            {
+                UnlinkEntry(index);
+                ReleaseEntry(index);
+            }
+
+            template<typename... Args>
+            void ConstructEntry(Entry& entry, Args&&... args)
+            {
+                YPASSERT(entry.HashCode_ == kNothing, "Construct on existing value.");
+                Yupei::construct(std::addressof(entry.Value_), std::forward<Args>(args)...);
+            }
+
+            size_type GetAvaliableEntry(size_type hashCode, size_type& targetBucket)
+            {
+                size_type index;
+                if (freeCount_ != 0)
+                {
+                    index = freeList_;
+                    --freeCount_;
+                    freeList_ = entries_[freeList_].NextEntryIndex_;
+                }
+                else
+                {
+                    if (count_ == entryCapacity_)
+                    {
+                        Grow();
+                        targetBucket = ConstrainHash(hashCode);
+                    }
+                    index = count_;
+                    ++count_;
+                }
+                return index;
+            }
+
+            void Grow()
+            {
+                const auto newBucketCount = Internal::HashHelpers::GetPrime(
+                    std::max(Internal::HashHelpers::ExpandPrime(bucketCount_), BucketCountFor(count_ + 1)));
+                Reallocate(newBucketCount, std::max(EntryCapacityFor(newBucketCount), count_ + 1));
+            }
+
+            //把存活的元素依次搬到新 entry 数组的前部并重新串链，空闲链表随之清空。
+            //移动构造可能抛出异常时改为复制；全部搬完之后才析构旧元素，中途失败时原表不变。
+            void Reallocate(size_type newBucketCount, size_type newEntryCapacity)
+            {
+                YPASSERT(newEntryCapacity >= size(), "New capacity is too small!");
+                BucketPtr newBuckets {GetSizeTypeAllocator().allocate(newBucketCount), BucketDeleter{allocator_, newBucketCount}};
+                EntryPtr newEntries {allocator_.allocate(newEntryCapacity), EntryDeleter{allocator_, newEntryCapacity}};
+                const auto nb = newBuckets.get();
+                const auto ne = newEntries.get();
+                const auto oldEntries = entries_.get();
+                std::fill(nb, nb + newBucketCount, kNothing);
+
+                size_type newCount = {};
+                SCOPE_FAIL{
+                    for (size_type i = 0; i < newCount; ++i)
+                        Yupei::destroy_at(std::addressof(ne[i].Value_));
+                };
+                for (size_type i = 0; i < count_; ++i)
+                {
+                    auto& entry1 = oldEntries[i];
+                    const auto hashCode = entry1.HashCode_;
+                    if (hashCode != kNothing)
+                    {
+                        auto& entry2 = ne[newCount];
+                        Yupei::construct(std::addressof(entry2.Value_), std::move_if_noexcept(entry1.Value_));
+                        const auto targetBucket = hashCode % newBucketCount;
+                        entry2.HashCode_ = hashCode;
+                        entry2.NextEntryIndex_ = nb[targetBucket];
+                        nb[targetBucket] = newCount;
+                        ++newCount;
+                    }
+                }
+
+                std::for_each(ne + newCount, ne + newEntryCapacity, [](Entry& entry2) {
+                    entry2.HashCode_ = kNothing;
+                });
+
+                DestroyEntries();
+                ResetBuckets(newBuckets.release(), newBucketCount);
+                ResetEntries(newEntries.release(), newEntryCapacity);
+                count_ = newCount;
+                freeList_ = kNothing;
+                freeCount_ = {};
+                bucketCount_ = newBucketCount;
+                entryCapacity_ = newEntryCapacity;
+            }
+
+            void CountLookup() const noexcept
+            {
+#ifdef YPDICTIONARY_COUNTERS
+                ++lookupCount_;
+#endif // YPDICTIONARY_COUNTERS
+            }
+
+            void CountProbe() const noexcept
+            {
+#ifdef YPDICTIONARY_COUNTERS
+                ++probeCount_;
+#endif // YPDICTIONARY_COUNTERS
+            }
+
+            template<typename K>
+            size_type FindEntryByKey(const K& key) const
+            {
+                return FindEntryByKey(key, hash_function()(key));
+            }
+
+            //被移动后的表没有桶数组，查找总是失败。
+            template<typename K>
+            size_type FindEntryByKey(const K& key, size_type hashCode) const
+            {
+                YPASSERT(hash_function()(key) == hashCode, "Hash code doesn't match the key!");
+                CountLookup();
+                if (!buckets_) return kNothing;
+                const auto targetBucket = ConstrainHash(hashCode);
+                for (auto i = buckets_[targetBucket]; i != kNothing; i = entries_[i].NextEntryIndex_)
+                {
+                    CountProbe();
+                    if (entries_[i].HashCode_ == hashCode && key_eq()(KeyOf(entries_[i]), key))
+                        return i;
+                }
+                return kNothing;
+            }
+
+            //每组键先统一计算哈希并预取桶，再预取 entry，最后才沿链比较，以掩盖访存延迟。
+            //按顺序对每个键调用 fn(entry 下标)，未找到时为 kNothing。
+            template<typename ForwardItT, typename Fn>
+            void FindBatch(ForwardItT first, ForwardItT last, Fn fn) const
+            {
+                if (!buckets_)
+                {
+                    for (; first != last; ++first)
+                        fn(kNothing);
+                    return;
+                }
+                size_type hashCodes[kBatchGroupSize];
+                size_type targets[kBatchGroupSize];
+                const auto buckets = buckets_.get();
+                const auto entries = entries_.get();
+                while (first != last)
+                {
+                    auto groupFirst = first;
+                    size_type n = 0;
+                    for (; n < kBatchGroupSize && first != last; ++n, ++first)
+                    {
+                        hashCodes[n] = hash_function()(*first);
+                        targets[n] = ConstrainHash(hashCodes[n]);
+                        prefetch(buckets + targets[n]);
+                    }
+
+                    //targets 从此存放各链的首个 entry 下标。
+                    for (size_type j = 0; j < n; ++j)
+                    {
+                        targets[j] = buckets[targets[j]];
+                        if (targets[j] != kNothing)
+                            prefetch(entries + targets[j]);
+                    }
+
+                    for (size_type j = 0; j < n; ++j, ++groupFirst)
+                    {
+                        const auto& key = *groupFirst;
+                        auto i = targets[j];
+                        CountLookup();
+                        for (; i != kNothing; i = entries[i].NextEntryIndex_)
+                        {
+                            CountProbe();
+                            if (entries[i].HashCode_ == hashCodes[j] && key_eq()(KeyOf(entries[i]), key))
+                                break;
+                        }
+                        fn(i);
+                    }
+                }
+            }
+
+            template<typename K>
+            bool EraseByKey(const K& key)
+            {
+                return EraseByKey(key, hash_function()(key));
+            }
+
+            template<typename K>
+            bool EraseByKey(const K& key, size_type hashCode)
+            {
+                YPASSERT(hash_function()(key) == hashCode, "Hash code doesn't match the key!");
+                if (!buckets_) return false;
+                const auto targetBucket = ConstrainHash(hashCode);
+                auto last = kNothing;
+                for (size_type i = buckets_[targetBucket]; i != kNothing; last = i, i = entries_[i].NextEntryIndex_)
+                {
+                    auto& entry = entries_[i];
+                    if (entry.HashCode_ == hashCode && key_eq()(KeyOf(entry), key))
+                    {
+                        if (last == kNothing)
+                            buckets_[targetBucket] = entry.NextEntryIndex_;
+                        else
+                            entries_[last].NextEntryIndex_ = entry.NextEntryIndex_;
+                        ReleaseEntry(i);
+                        return true;
+                    }
+                }
+                return false;
+            }
+        };
+    }
+}
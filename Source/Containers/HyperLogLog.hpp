@@ -0,0 +1,328 @@
+﻿#pragma once
+
+#include "../Hash/Hash.hpp"
+#include "../Hash/HashHelpers.hpp"
+#include "../Iterator.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../Bits.hpp"
+#include "../Assert.hpp"
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace Yupei
+{
+    //HyperLogLog 基数估计。键经 HashFun 哈希一次并混合成 64 位，高 precision 位选寄存器，其余位前导零个数加一为 rank。
+    //元素较少时使用稀疏表示：按寄存器下标排序的 (下标, rank) 数组，占用超过稠密寄存器的一半时转为稠密表示。
+    //两种表示的估计结果完全相同，标准误差约为 1.04 / sqrt(2^precision)。
+    template<typename KeyT, typename HashFun = hash<>>
+    class hyperloglog : HashFun
+    {
+    public:
+        using key_type = KeyT;
+        using size_type = std::size_t;
+        using hasher = HashFun;
+
+        static constexpr size_type kMinPrecision = 4;
+        static constexpr size_type kMaxPrecision = 18;
+        static constexpr size_type kDefaultPrecision = 14;
+
+        explicit hyperloglog(size_type precision = kDefaultPrecision, hasher hash = {}, memory_resource_ptr pmr = {})
+            :hasher{hash},
+            resource_{pmr},
+            precision_{precision}
+        {
+            if (precision < kMinPrecision || precision > kMaxPrecision)
+                throw std::invalid_argument {"Precision of hyperloglog must be in [4, 18]!"};
+        }
+
+        hyperloglog(const hyperloglog& other)
+            :hasher{other.hash_function()},
+            resource_{other.resource_},
+            precision_{other.precision_}
+        {
+            if (other.registers_)
+            {
+                registers_ = AllocateRegisters();
+                std::memcpy(registers_, other.registers_, register_count());
+            }
+            else if (other.sparseSize_ != 0)
+            {
+                sparse_ = AllocateSparse(other.sparseSize_);
+                sparseCapacity_ = other.sparseSize_;
+                sparseSize_ = other.sparseSize_;
+                std::copy(other.sparse_, other.sparse_ + sparseSize_, sparse_);
+            }
+        }
+
+        hyperloglog(hyperloglog&& other) noexcept
+            :hasher{other.hash_function()},
+            resource_{other.resource_},
+            precision_{other.precision_},
+            registers_{other.registers_},
+            sparse_{other.sparse_},
+            sparseSize_{other.sparseSize_},
+            sparseCapacity_{other.sparseCapacity_}
+        {
+            other.registers_ = {};
+            other.sparse_ = {};
+            other.sparseSize_ = {};
+            other.sparseCapacity_ = {};
+        }
+
+        hyperloglog& operator=(const hyperloglog& other)
+        {
+            hyperloglog(other).swap(*this);
+            return *this;
+        }
+
+        hyperloglog& operator=(hyperloglog&& other) noexcept
+        {
+            hyperloglog(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~hyperloglog()
+        {
+            Deallocate();
+        }
+
+        //要求两边的分配器相等。
+        void swap(hyperloglog& other) noexcept
+        {
+            using std::swap;
+            swap(precision_, other.precision_);
+            swap(registers_, other.registers_);
+            swap(sparse_, other.sparse_);
+            swap(sparseSize_, other.sparseSize_);
+            swap(sparseCapacity_, other.sparseCapacity_);
+        }
+
+        hasher hash_function() const
+        {
+            return static_cast<hasher>(*this);
+        }
+
+        size_type precision() const noexcept
+        {
+            return precision_;
+        }
+
+        size_type register_count() const noexcept
+        {
+            return size_type{1} << precision_;
+        }
+
+        bool is_sparse() const noexcept
+        {
+            return registers_ == nullptr;
+        }
+
+        static double relative_error(size_type precision) noexcept
+        {
+            return 1.04 / std::sqrt(static_cast<double>(size_type{1} << precision));
+        }
+
+        void insert(const key_type& key)
+        {
+            InsertHashed(Internal::MixHash(static_cast<std::uint64_t>(hash_function()(key))));
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void insert(InputItT first, InputItT last)
+        {
+            for (; first != last; ++first)
+                insert(*first);
+        }
+
+        double estimate() const noexcept
+        {
+            const auto m = static_cast<double>(register_count());
+            auto sum = 0.;
+            size_type zeros = 0;
+            if (registers_)
+            {
+                for (size_type i = 0; i < register_count(); ++i)
+                {
+                    sum += std::ldexp(1., -static_cast<int>(registers_[i]));
+                    if (registers_[i] == 0) ++zeros;
+                }
+            }
+            else
+            {
+                //稀疏表里没有的寄存器都是 0。
+                zeros = register_count() - sparseSize_;
+                sum = static_cast<double>(zeros);
+                for (size_type i = 0; i < sparseSize_; ++i)
+                    sum += std::ldexp(1., -static_cast<int>(SparseRank(sparse_[i])));
+            }
+            const auto rawEstimate = Alpha() * m * m / sum;
+            //小基数时改用线性计数。
+            if (rawEstimate <= 2.5 * m && zeros != 0)
+                return m * std::log(m / static_cast<double>(zeros));
+            return rawEstimate;
+        }
+
+        //合并后的结果与把两边的元素插入同一个 hyperloglog 完全相同。两边的精度必须相同。
+        void merge(const hyperloglog& other)
+        {
+            if (other.precision_ != precision_)
+                throw std::invalid_argument {"Precisions of the two hyperloglogs are different!"};
+            if (&other == this) return;
+            if (other.registers_)
+            {
+                if (!registers_) ToDense();
+                MergeRegisters(registers_, other.registers_, register_count());
+            }
+            else
+            {
+                for (size_type i = 0; i < other.sparseSize_; ++i)
+                    Update(SparseIndex(other.sparse_[i]), SparseRank(other.sparse_[i]));
+            }
+        }
+
+        void clear() noexcept
+        {
+            Deallocate();
+            registers_ = {};
+            sparse_ = {};
+            sparseSize_ = {};
+            sparseCapacity_ = {};
+        }
+
+    private:
+        memory_resource_ptr resource_;
+        size_type precision_;
+        //稠密表示，为空时使用稀疏表示。
+        std::uint8_t* registers_ = {};
+        //稀疏表示，每项为 (下标 << 8) | rank，按下标升序排列。
+        std::uint32_t* sparse_ = {};
+        size_type sparseSize_ = {};
+        size_type sparseCapacity_ = {};
+
+        static std::uint32_t SparseIndex(std::uint32_t entry) noexcept
+        {
+            return entry >> 8;
+        }
+
+        static std::uint8_t SparseRank(std::uint32_t entry) noexcept
+        {
+            return static_cast<std::uint8_t>(entry & 0xff);
+        }
+
+        //按字节取最大值，循环体没有分支，编译器会向量化为 SIMD 指令。
+        static void MergeRegisters(std::uint8_t* target, const std::uint8_t* source, size_type n) noexcept
+        {
+            for (size_type i = 0; i < n; ++i)
+                target[i] = std::max(target[i], source[i]);
+        }
+
+        double Alpha() const noexcept
+        {
+            switch (precision_)
+            {
+            case 4:
+                return 0.673;
+            case 5:
+                return 0.697;
+            case 6:
+                return 0.709;
+            default:
+                return 0.7213 / (1. + 1.079 / static_cast<double>(register_count()));
+            }
+        }
+
+        //稀疏表的字节数超过稠密寄存器的一半时转为稠密表示。
+        size_type MaxSparseSize() const noexcept
+        {
+            return register_count() / 2 / sizeof(std::uint32_t);
+        }
+
+        std::uint8_t* AllocateRegisters()
+        {
+            return static_cast<std::uint8_t*>(resource_->allocate(register_count(), alignof(std::uint8_t)));
+        }
+
+        std::uint32_t* AllocateSparse(size_type n)
+        {
+            return static_cast<std::uint32_t*>(resource_->allocate(n * sizeof(std::uint32_t), alignof(std::uint32_t)));
+        }
+
+        void DeallocateSparse() noexcept
+        {
+            if (sparse_)
+                resource_->deallocate(sparse_, sparseCapacity_ * sizeof(std::uint32_t), alignof(std::uint32_t));
+        }
+
+        void Deallocate() noexcept
+        {
+            if (registers_)
+                resource_->deallocate(registers_, register_count(), alignof(std::uint8_t));
+            DeallocateSparse();
+        }
+
+        void InsertHashed(std::uint64_t hashCode)
+        {
+            const auto index = static_cast<std::uint32_t>(hashCode >> (64 - precision_));
+            //低位补一个 1，保证 rank 不超过 64 - precision_ + 1。
+            const auto rest = (hashCode << precision_) | (std::uint64_t{1} << (precision_ - 1));
+            Update(index, static_cast<std::uint8_t>(countl_zero(rest) + 1));
+        }
+
+        void Update(std::uint32_t index, std::uint8_t rank)
+        {
+            if (registers_)
+            {
+                registers_[index] = std::max(registers_[index], rank);
+                return;
+            }
+            const auto last = sparse_ + sparseSize_;
+            const auto pos = std::lower_bound(sparse_, last, index << 8);
+            if (pos != last && SparseIndex(*pos) == index)
+            {
+                if (SparseRank(*pos) < rank)
+                    *pos = (index << 8) | rank;
+                return;
+            }
+            if (sparseSize_ == MaxSparseSize())
+            {
+                ToDense();
+                registers_[index] = std::max(registers_[index], rank);
+                return;
+            }
+            const auto offset = static_cast<size_type>(pos - sparse_);
+            if (sparseSize_ == sparseCapacity_)
+                GrowSparse();
+            std::copy_backward(sparse_ + offset, sparse_ + sparseSize_, sparse_ + sparseSize_ + 1);
+            sparse_[offset] = (index << 8) | rank;
+            ++sparseSize_;
+        }
+
+        void GrowSparse()
+        {
+            const auto newCapacity = std::min(std::max<size_type>(sparseCapacity_ * 2, 16), MaxSparseSize());
+            const auto newSparse = AllocateSparse(newCapacity);
+            std::copy(sparse_, sparse_ + sparseSize_, newSparse);
+            DeallocateSparse();
+            sparse_ = newSparse;
+            sparseCapacity_ = newCapacity;
+        }
+
+        void ToDense()
+        {
+            YPASSERT(registers_ == nullptr, "Already dense!");
+            const auto registers = AllocateRegisters();
+            std::fill(registers, registers + register_count(), std::uint8_t{});
+            for (size_type i = 0; i < sparseSize_; ++i)
+                registers[SparseIndex(sparse_[i])] = SparseRank(sparse_[i]);
+            DeallocateSparse();
+            registers_ = registers;
+            sparse_ = {};
+            sparseSize_ = {};
+            sparseCapacity_ = {};
+        }
+    };
+}
@@ -0,0 +1,582 @@
+﻿#pragma once
+
+#include "Dictionary.hpp"
+#include "../Hash/HashHelpers.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../Scope.hpp"
+#include "../Assert.hpp"
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Yupei
+{
+    template<typename KeyT, typename ValueT, typename EmptyKeyT>
+    class integer_dictionary;
+
+    namespace Internal
+    {
+        //key / value 分开存放，解引用得到的是一对引用。
+        template<typename KeyT, typename ValueT>
+        struct IntegerDictionaryReference
+        {
+            const KeyT& first;
+            ValueT& second;
+
+            const IntegerDictionaryReference* operator->() const noexcept
+            {
+                return this;
+            }
+        };
+
+        template<typename DictionaryT, typename ValueT>
+        class IntegerDictionaryIterator
+        {
+            template<typename, typename, typename>
+            friend class Yupei::integer_dictionary;
+
+            template<typename, typename>
+            friend class IntegerDictionaryIterator;
+
+            using size_type = std::size_t;
+
+            IntegerDictionaryIterator(DictionaryT* dict, size_type index) noexcept
+                :dict_{dict}, index_{index}
+            {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::pair<typename DictionaryT::key_type, std::remove_const_t<ValueT>>;
+            using iterator_category = std::forward_iterator_tag;
+            using reference = IntegerDictionaryReference<typename DictionaryT::key_type, ValueT>;
+            using pointer = reference;
+
+            constexpr IntegerDictionaryIterator() noexcept
+                :dict_{}, index_{}
+            {}
+
+            template<typename OtherDictionaryT, typename OtherValueT, typename = std::enable_if_t<std::is_convertible<OtherValueT*, ValueT*>::value>>
+            IntegerDictionaryIterator(const IntegerDictionaryIterator<OtherDictionaryT, OtherValueT>& other) noexcept
+                :dict_{other.dict_}, index_{other.index_}
+            {}
+
+            IntegerDictionaryIterator& operator++() noexcept
+            {
+                YPASSERT(index_ < dict_->capacity_, "Increase an end iterator!");
+                index_ = dict_->NextOccupied(index_ + 1);
+                return *this;
+            }
+
+            IntegerDictionaryIterator operator++(int) noexcept
+            {
+                auto tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            reference operator*() const noexcept
+            {
+                YPASSERT(index_ < dict_->capacity_, "Deref an end iterator!");
+                return {dict_->keys_[index_], dict_->values_[index_]};
+            }
+
+            pointer operator->() const noexcept
+            {
+                return **this;
+            }
+
+            bool operator==(const IntegerDictionaryIterator& other) const noexcept
+            {
+                YPASSERT(dict_ == other.dict_, "Two iterators are not compatible!");
+                return index_ == other.index_;
+            }
+
+            bool operator!=(const IntegerDictionaryIterator& other) const noexcept
+            {
+                return !(*this == other);
+            }
+
+        private:
+            DictionaryT* dict_;
+            size_type index_;
+        };
+    }
+
+    //整数键的哈希表：开放寻址 + 线性探测，容量为 2 的幂，用 MixHash 混合后取低位定位，不保存哈希值（键本身就是哈希）。
+    //key 与 value 分开存放，探测只会读 key 数组。删除采用向后移位（backward shift），没有墓碑。
+    //EmptyKeyT 为 std::integral_constant<KeyT, v> 时，v 被用作空槽位的标记，不再需要每个槽位一字节的占用表，
+    //此时不能插入值为 v 的键。
+    template<typename KeyT, typename ValueT, typename EmptyKeyT = void>
+    class integer_dictionary
+    {
+        static_assert(std::is_integral<KeyT>::value || std::is_enum<KeyT>::value, "KeyT must be an integral or enum type!");
+
+    public:
+        using key_type = KeyT;
+        using mapped_type = ValueT;
+        using value_type = std::pair<key_type, mapped_type>;
+        using size_type = std::size_t;
+        using iterator = Internal::IntegerDictionaryIterator<integer_dictionary, mapped_type>;
+        using const_iterator = Internal::IntegerDictionaryIterator<const integer_dictionary, const mapped_type>;
+
+    private:
+        template<typename, typename>
+        friend class Internal::IntegerDictionaryIterator;
+
+        static constexpr bool kHasEmptyKey = !std::is_void<EmptyKeyT>::value;
+        static constexpr size_type kMinCapacity = 8;
+
+        struct NoEmptyKey
+        {
+            static constexpr key_type value = {};
+        };
+
+        static constexpr key_type kEmptyKey = std::conditional_t<kHasEmptyKey, EmptyKeyT, NoEmptyKey>::value;
+
+    public:
+        integer_dictionary() noexcept
+        {}
+
+        explicit integer_dictionary(memory_resource_ptr pmr) noexcept
+            :keyAllocator_{pmr}
+        {}
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        integer_dictionary(InputItT first, InputItT last, memory_resource_ptr pmr = {})
+            :integer_dictionary{pmr}
+        {
+            insert(first, last);
+        }
+
+        integer_dictionary(std::initializer_list<value_type> init, memory_resource_ptr pmr = {})
+            :integer_dictionary(init.begin(), init.end(), pmr)
+        {}
+
+        integer_dictionary(const integer_dictionary& other)
+            :integer_dictionary(other, other.keyAllocator_.resource())
+        {}
+
+        //复制到 pmr 上。
+        integer_dictionary(const integer_dictionary& other, memory_resource_ptr pmr)
+            :keyAllocator_{pmr}
+        {
+            CloneFrom(other);
+        }
+
+        integer_dictionary(integer_dictionary&& other) noexcept
+            :keyAllocator_{other.keyAllocator_},
+            keys_{other.keys_},
+            values_{other.values_},
+            occupied_{other.occupied_},
+            capacity_{other.capacity_},
+            size_{other.size_}
+        {
+            other.keys_ = {};
+            other.values_ = {};
+            other.occupied_ = {};
+            other.capacity_ = {};
+            other.size_ = {};
+        }
+
+        //pmr 与 other 的分配器相同时直接接管槽位数组，否则逐个移动 value，other 随后被清空。
+        integer_dictionary(integer_dictionary&& other, memory_resource_ptr pmr)
+            :keyAllocator_{pmr}
+        {
+            if (keyAllocator_ == other.keyAllocator_)
+                swap(other);
+            else
+            {
+                CloneFrom(std::move(other));
+                other.clear();
+            }
+        }
+
+        //赋值不改变本字典的分配器。
+        integer_dictionary& operator=(const integer_dictionary& other)
+        {
+            if (this != &other)
+                integer_dictionary(other, keyAllocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        integer_dictionary& operator=(integer_dictionary&& other)
+        {
+            if (this != &other)
+                integer_dictionary(std::move(other), keyAllocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        ~integer_dictionary()
+        {
+            clear();
+            Deallocate();
+        }
+
+        //要求两边的 memory_resource 相同。
+        void swap(integer_dictionary& other) noexcept
+        {
+            YPASSERT(keyAllocator_ == other.keyAllocator_, "Allocators of swapped integer_dictionaries must be equal.");
+            using std::swap;
+            swap(keys_, other.keys_);
+            swap(values_, other.values_);
+            swap(occupied_, other.occupied_);
+            swap(capacity_, other.capacity_);
+            swap(size_, other.size_);
+        }
+
+        size_type size() const noexcept
+        {
+            return size_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        //槽位总数，总是 0 或 2 的幂。
+        size_type capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        float load_factor() const noexcept
+        {
+            return capacity_ == 0 ? 0.f : static_cast<float>(size_) / static_cast<float>(capacity_);
+        }
+
+        static constexpr float max_load_factor() noexcept
+        {
+            return 0.75f;
+        }
+
+        //保证插入 n 个元素之前不会再重新分配。
+        void reserve(size_type n)
+        {
+            const auto capacity = CapacityFor(n);
+            if (capacity > capacity_)
+                Rehash(capacity);
+        }
+
+        iterator begin() noexcept
+        {
+            return {this, NextOccupied(0)};
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return {this, NextOccupied(0)};
+        }
+
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        iterator end() noexcept
+        {
+            return {this, capacity_};
+        }
+
+        const_iterator end() const noexcept
+        {
+            return {this, capacity_};
+        }
+
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+
+        iterator find(key_type key) noexcept
+        {
+            return {this, FindSlot(key)};
+        }
+
+        const_iterator find(key_type key) const noexcept
+        {
+            return {this, FindSlot(key)};
+        }
+
+        bool contains(key_type key) const noexcept
+        {
+            return FindSlot(key) != capacity_;
+        }
+
+        mapped_type& at(key_type key)
+        {
+            const auto i = FindSlot(key);
+            if (i == capacity_) throw std::out_of_range("Key doesn't exist!");
+            return values_[i];
+        }
+
+        const mapped_type& at(key_type key) const
+        {
+            const auto i = FindSlot(key);
+            if (i == capacity_) throw std::out_of_range("Key doesn't exist!");
+            return values_[i];
+        }
+
+        mapped_type& operator[](key_type key)
+        {
+            //try_emplace 可能重新分配，要在它之后再读 values_。
+            const auto i = try_emplace(key).first.index_;
+            return values_[i];
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return try_emplace(value.first, value.second);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value)
+        {
+            return try_emplace(value.first, std::move(value.second));
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void insert(InputItT first, InputItT last)
+        {
+            if (is_forward_iterator<InputItT>::value)
+                reserve(size_ + static_cast<size_type>(std::distance(first, last)));
+            std::for_each(first, last, [this](const auto& v) {
+                insert(v);
+            });
+        }
+
+        template<typename M>
+        std::pair<iterator, bool> insert_or_assign(key_type key, M&& obj)
+        {
+            const auto result = try_emplace(key, std::forward<M>(obj));
+            if (!result.second)
+                values_[result.first.index_] = std::forward<M>(obj);
+            return result;
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> try_emplace(key_type key, Args&&... args)
+        {
+            CheckKey(key);
+            if (capacity_ != 0)
+            {
+                const auto i = ProbeSlot(key);
+                if (IsOccupied(i))
+                    return {{this, i}, false};
+                if (size_ + 1 <= MaxSizeFor(capacity_))
+                    return {{this, EmplaceAt(i, key, std::forward<Args>(args)...)}, true};
+            }
+            Rehash(capacity_ == 0 ? kMinCapacity : capacity_ * 2);
+            return {{this, EmplaceAt(ProbeSlot(key), key, std::forward<Args>(args)...)}, true};
+        }
+
+        bool erase(key_type key) noexcept
+        {
+            const auto i = FindSlot(key);
+            if (i == capacity_) return false;
+            EraseSlot(i);
+            return true;
+        }
+
+        //保留槽位数组。
+        void clear() noexcept
+        {
+            for (size_type i = 0; i < capacity_; ++i)
+                if (IsOccupied(i))
+                {
+                    Yupei::destroy_at(values_ + i);
+                    SetEmpty(i);
+                }
+            size_ = {};
+        }
+
+    private:
+        polymorphic_allocator<key_type> keyAllocator_;
+        key_type* keys_ = {};
+        mapped_type* values_ = {};
+        //每个槽位一字节的占用表，有 EmptyKeyT 时为空。
+        std::uint8_t* occupied_ = {};
+        size_type capacity_ = {};
+        size_type size_ = {};
+
+        static size_type MaxSizeFor(size_type capacity) noexcept
+        {
+            return capacity - capacity / 4;
+        }
+
+        static size_type CapacityFor(size_type n) noexcept
+        {
+            size_type capacity = kMinCapacity;
+            while (MaxSizeFor(capacity) < n)
+                capacity *= 2;
+            return capacity;
+        }
+
+        size_type IdealSlot(key_type key) const noexcept
+        {
+            return static_cast<size_type>(Internal::MixHash(static_cast<std::uint64_t>(key))) & (capacity_ - 1);
+        }
+
+        static void CheckKey(key_type key)
+        {
+            if (kHasEmptyKey && key == kEmptyKey)
+                throw std::invalid_argument("Key equals the empty key!");
+        }
+
+        bool IsOccupied(size_type i) const noexcept
+        {
+            return kHasEmptyKey ? keys_[i] != kEmptyKey : occupied_[i] != 0;
+        }
+
+        void SetOccupied(size_type i) noexcept
+        {
+            if (!kHasEmptyKey) occupied_[i] = 1;
+        }
+
+        void SetEmpty(size_type i) noexcept
+        {
+            if (kHasEmptyKey) keys_[i] = kEmptyKey;
+            else occupied_[i] = 0;
+        }
+
+        size_type NextOccupied(size_type i) const noexcept
+        {
+            while (i < capacity_ && !IsOccupied(i))
+                ++i;
+            return i;
+        }
+
+        //key 所在的槽位，或者第一个空槽位。要求 capacity_ != 0。
+        size_type ProbeSlot(key_type key) const noexcept
+        {
+            const auto mask = capacity_ - 1;
+            auto i = IdealSlot(key);
+            while (IsOccupied(i) && keys_[i] != key)
+                i = (i + 1) & mask;
+            return i;
+        }
+
+        //未找到时返回 capacity_。
+        size_type FindSlot(key_type key) const noexcept
+        {
+            if (size_ == 0 || (kHasEmptyKey && key == kEmptyKey)) return capacity_;
+            const auto i = ProbeSlot(key);
+            return IsOccupied(i) ? i : capacity_;
+        }
+
+        template<typename... Args>
+        size_type EmplaceAt(size_type i, key_type key, Args&&... args)
+        {
+            Yupei::construct(values_ + i, std::forward<Args>(args)...);
+            keys_[i] = key;
+            SetOccupied(i);
+            ++size_;
+            return i;
+        }
+
+        //把后面探测链上可以前移的元素依次前移，保证查找不会在空槽位处提前停下。
+        void EraseSlot(size_type i) noexcept
+        {
+            const auto mask = capacity_ - 1;
+            Yupei::destroy_at(values_ + i);
+            for (auto j = (i + 1) & mask; IsOccupied(j); j = (j + 1) & mask)
+            {
+                const auto ideal = IdealSlot(keys_[j]);
+                //ideal 在 (i, j] 之内时 j 处的元素不能前移到 i。
+                const auto inRange = i <= j ? (i < ideal && ideal <= j) : (i < ideal || ideal <= j);
+                if (inRange) continue;
+                Yupei::construct(values_ + i, std::move(values_[j]));
+                Yupei::destroy_at(values_ + j);
+                keys_[i] = keys_[j];
+                SetOccupied(i);
+                i = j;
+            }
+            SetEmpty(i);
+            --size_;
+        }
+
+        //*this 为空且没有分配槽位。槽位布局与 other 相同，不必重新探测；other 为右值时移动 value。
+        template<typename DictionaryT>
+        void CloneFrom(DictionaryT&& other)
+        {
+            using ValueRef = std::conditional_t<std::is_lvalue_reference<DictionaryT>::value, const mapped_type&, mapped_type&&>;
+            if (other.size_ == 0) return;
+            Allocate(other.capacity_);
+            SCOPE_FAIL{
+                clear();
+                Deallocate();
+            };
+            for (size_type i = 0; i < capacity_; ++i)
+                if (other.IsOccupied(i))
+                    EmplaceAt(i, other.keys_[i], static_cast<ValueRef>(other.values_[i]));
+        }
+
+        polymorphic_allocator<mapped_type> GetValueAllocator() const noexcept
+        {
+            return polymorphic_allocator<mapped_type>{keyAllocator_.resource()};
+        }
+
+        polymorphic_allocator<std::uint8_t> GetOccupiedAllocator() const noexcept
+        {
+            return polymorphic_allocator<std::uint8_t>{keyAllocator_.resource()};
+        }
+
+        //分配 capacity 个空槽位。
+        void Allocate(size_type capacity)
+        {
+            const auto keys = keyAllocator_.allocate(capacity);
+            SCOPE_FAIL{
+                keyAllocator_.deallocate(keys, capacity);
+            };
+            const auto values = GetValueAllocator().allocate(capacity);
+            SCOPE_FAIL{
+                GetValueAllocator().deallocate(values, capacity);
+            };
+            std::uint8_t* occupied = {};
+            if (!kHasEmptyKey)
+            {
+                occupied = GetOccupiedAllocator().allocate(capacity);
+                std::fill(occupied, occupied + capacity, 0);
+            }
+            else
+                std::fill(keys, keys + capacity, kEmptyKey);
+            keys_ = keys;
+            values_ = values;
+            occupied_ = occupied;
+            capacity_ = capacity;
+        }
+
+        void Deallocate() noexcept
+        {
+            if (capacity_ == 0) return;
+            keyAllocator_.deallocate(keys_, capacity_);
+            GetValueAllocator().deallocate(values_, capacity_);
+            if (!kHasEmptyKey)
+                GetOccupiedAllocator().deallocate(occupied_, capacity_);
+            keys_ = {};
+            values_ = {};
+            occupied_ = {};
+            capacity_ = {};
+        }
+
+        void Rehash(size_type newCapacity)
+        {
+            YPASSERT(MaxSizeFor(newCapacity) >= size_, "New capacity is too small!");
+            integer_dictionary other{keyAllocator_.resource()};
+            other.Allocate(newCapacity);
+            for (size_type i = 0; i < capacity_; ++i)
+                if (IsOccupied(i))
+                    other.EmplaceAt(other.ProbeSlot(keys_[i]), keys_[i], std::move_if_noexcept(values_[i]));
+            swap(other);
+        }
+    };
+
+    //整数键时选用 integer_dictionary，其余情况下是 dictionary。
+    //两者的 find / at / operator[] / try_emplace / insert_or_assign / erase / 遍历用法相同，
+    //但 integer_dictionary 没有 stored_hash、*_hashed 与 node handle 等接口。
+    template<typename KeyT, typename ValueT>
+    using auto_dictionary = std::conditional_t<std::is_integral<KeyT>::value, integer_dictionary<KeyT, ValueT>, dictionary<KeyT, ValueT>>;
+}
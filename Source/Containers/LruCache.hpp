@@ -0,0 +1,617 @@
+﻿#pragma once
+
+#include "../Hash/Hash.hpp"
+#include "../Hash/HashHelpers.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../Scope.hpp"
+#include "../Assert.hpp"
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <type_traits>
+
+namespace Yupei
+{
+    namespace Internal
+    {
+        //每个元素的权重都是 1，此时 capacity 就是元素个数。
+        struct UnitWeigher
+        {
+            template<typename KeyT, typename ValueT>
+            std::size_t operator()(const KeyT&, const ValueT&) const noexcept
+            {
+                return 1;
+            }
+        };
+
+        //缓存用的哈希表，布局与 dictionary 相同（entry 数组 + 桶数组 + 空闲链表），
+        //但 Entry 中多了一个 LinkT，供替换策略存放自己的数据（LRU 链表的前后下标、CLOCK 的访问位）。
+        //扩容时元素保持原来的下标，因此 LinkT 里记录的下标不会失效。
+        template<typename KeyT, typename ValueT, typename HashFun, typename KeyEqualT, typename LinkT>
+        class CacheTable : KeyEqualT, HashFun
+        {
+        public:
+            using key_type = KeyT;
+            using mapped_type = ValueT;
+            using value_type = std::pair<key_type, mapped_type>;
+            using size_type = std::size_t;
+            using key_equal = KeyEqualT;
+            using hasher = HashFun;
+
+            static constexpr size_type kNothing = static_cast<size_type>(-1);
+
+            struct Entry
+            {
+                size_type HashCode_ = kNothing;
+                size_type NextEntryIndex_;
+                LinkT Link_;
+                value_type KeyValue_;
+            };
+
+            CacheTable(size_type entryCapacity, const hasher& hash, const key_equal& keyEqual, memory_resource_ptr pmr)
+                :key_equal{keyEqual},
+                hasher{hash},
+                allocator_{pmr}
+            {
+                Adopt(Allocate(std::max<size_type>(entryCapacity, 1)));
+                std::fill(buckets_, buckets_ + bucketCount_, kNothing);
+            }
+
+            CacheTable(const CacheTable&) = delete;
+            CacheTable& operator=(const CacheTable&) = delete;
+
+            ~CacheTable()
+            {
+                Clear();
+                Deallocate();
+            }
+
+            hasher hash_function() const
+            {
+                return static_cast<hasher>(*this);
+            }
+
+            key_equal key_eq() const
+            {
+                return static_cast<key_equal>(*this);
+            }
+
+            size_type Size() const noexcept
+            {
+                return count_ - freeCount_;
+            }
+
+            //最高水位线，[0, HighWater()) 之外没有元素。
+            size_type HighWater() const noexcept
+            {
+                return count_;
+            }
+
+            Entry& operator[](size_type index) noexcept
+            {
+                return entries_[index];
+            }
+
+            const Entry& operator[](size_type index) const noexcept
+            {
+                return entries_[index];
+            }
+
+            template<typename K>
+            size_type Find(const K& key, size_type hashCode) const
+            {
+                for (auto i = buckets_[hashCode % bucketCount_]; i != kNothing; i = entries_[i].NextEntryIndex_)
+                    if (entries_[i].HashCode_ == hashCode && key_eq()(entries_[i].KeyValue_.first, key))
+                        return i;
+                return kNothing;
+            }
+
+            //调用者保证 key 不存在。返回新元素的下标，Link_ 未初始化。
+            template<typename... Args>
+            size_type Emplace(size_type hashCode, Args&&... args)
+            {
+                size_type index;
+                if (freeCount_ != 0)
+                    index = freeList_;
+                else
+                {
+                    if (count_ == entryCapacity_)
+                        Grow();
+                    index = count_;
+                }
+                auto& entry = entries_[index];
+                Yupei::construct(std::addressof(entry.KeyValue_), std::forward<Args>(args)...);
+                if (freeCount_ != 0)
+                {
+                    freeList_ = entry.NextEntryIndex_;
+                    --freeCount_;
+                }
+                else
+                    ++count_;
+                const auto targetBucket = hashCode % bucketCount_;
+                entry.HashCode_ = hashCode;
+                entry.NextEntryIndex_ = buckets_[targetBucket];
+                buckets_[targetBucket] = index;
+                return index;
+            }
+
+            void Remove(size_type index) noexcept
+            {
+                auto& entry = entries_[index];
+                const auto targetBucket = entry.HashCode_ % bucketCount_;
+                auto last = kNothing;
+                for (auto i = buckets_[targetBucket]; i != index; last = i, i = entries_[i].NextEntryIndex_)
+                    ;
+                if (last == kNothing)
+                    buckets_[targetBucket] = entry.NextEntryIndex_;
+                else
+                    entries_[last].NextEntryIndex_ = entry.NextEntryIndex_;
+                Yupei::destroy_at(std::addressof(entry.KeyValue_));
+                entry.HashCode_ = kNothing;
+                entry.NextEntryIndex_ = freeList_;
+                freeList_ = index;
+                ++freeCount_;
+            }
+
+            void Clear() noexcept
+            {
+                for (size_type i = 0; i < count_; ++i)
+                    if (entries_[i].HashCode_ != kNothing)
+                    {
+                        Yupei::destroy_at(std::addressof(entries_[i].KeyValue_));
+                        entries_[i].HashCode_ = kNothing;
+                    }
+                std::fill(buckets_, buckets_ + bucketCount_, kNothing);
+                count_ = {};
+                freeList_ = kNothing;
+                freeCount_ = {};
+            }
+
+        private:
+            polymorphic_allocator<Entry> allocator_;
+            Entry* entries_ = {};
+            size_type* buckets_ = {};
+            size_type entryCapacity_ = {};
+            size_type bucketCount_ = {};
+            size_type count_ = {};
+            size_type freeList_ = kNothing;
+            size_type freeCount_ = {};
+
+            polymorphic_allocator<size_type> GetSizeTypeAllocator() const noexcept
+            {
+                return polymorphic_allocator<size_type>{allocator_.resource()};
+            }
+
+            struct Storage
+            {
+                Entry* Entries_;
+                size_type* Buckets_;
+                size_type EntryCapacity_;
+                size_type BucketCount_;
+            };
+
+            //两块内存都分配成功后才返回，成员由调用者通过 Adopt 写入，失败时成员保持不变。
+            Storage Allocate(size_type entryCapacity)
+            {
+                const auto bucketCount = HashHelpers::GetPrime(entryCapacity);
+                const auto buckets = GetSizeTypeAllocator().allocate(bucketCount);
+                SCOPE_FAIL{
+                    GetSizeTypeAllocator().deallocate(buckets, bucketCount);
+                };
+                const auto entries = allocator_.allocate(entryCapacity);
+                return {entries, buckets, entryCapacity, bucketCount};
+            }
+
+            void Adopt(const Storage& storage) noexcept
+            {
+                entries_ = storage.Entries_;
+                buckets_ = storage.Buckets_;
+                entryCapacity_ = storage.EntryCapacity_;
+                bucketCount_ = storage.BucketCount_;
+            }
+
+            void Deallocate(const Storage& storage) noexcept
+            {
+                allocator_.deallocate(storage.Entries_, storage.EntryCapacity_);
+                GetSizeTypeAllocator().deallocate(storage.Buckets_, storage.BucketCount_);
+            }
+
+            void Deallocate() noexcept
+            {
+                Deallocate({entries_, buckets_, entryCapacity_, bucketCount_});
+            }
+
+            //元素搬到新数组的同一个下标上，空闲链表原样保留，只重新串桶链。
+            //移动构造可能抛出异常时改为复制，全部搬完之后才替换成员，中途抛出异常时旧数组原封不动。
+            void Grow()
+            {
+                const auto storage = Allocate(entryCapacity_ * 2);
+                SCOPE_FAIL{
+                    Deallocate(storage);
+                };
+                const auto newEntries = storage.Entries_;
+                size_type constructed = {};
+                SCOPE_FAIL{
+                    for (size_type i = 0; i < constructed; ++i)
+                        if (entries_[i].HashCode_ != kNothing)
+                            Yupei::destroy_at(std::addressof(newEntries[i].KeyValue_));
+                };
+                for (; constructed < count_; ++constructed)
+                {
+                    auto& from = entries_[constructed];
+                    auto& to = newEntries[constructed];
+                    if (from.HashCode_ != kNothing)
+                    {
+                        Yupei::construct(std::addressof(to.KeyValue_), std::move_if_noexcept(from.KeyValue_));
+                        to.Link_ = from.Link_;
+                    }
+                    to.HashCode_ = from.HashCode_;
+                    to.NextEntryIndex_ = from.NextEntryIndex_;
+                }
+
+                std::fill(storage.Buckets_, storage.Buckets_ + storage.BucketCount_, kNothing);
+                for (size_type i = 0; i < count_; ++i)
+                {
+                    auto& entry = newEntries[i];
+                    if (entry.HashCode_ != kNothing)
+                    {
+                        Yupei::destroy_at(std::addressof(entries_[i].KeyValue_));
+                        const auto targetBucket = entry.HashCode_ % storage.BucketCount_;
+                        entry.NextEntryIndex_ = storage.Buckets_[targetBucket];
+                        storage.Buckets_[targetBucket] = i;
+                    }
+                }
+                Deallocate();
+                Adopt(storage);
+            }
+        };
+
+        struct LruLink
+        {
+            std::size_t Prev_;
+            std::size_t Next_;
+        };
+
+        struct ClockLink
+        {
+            bool Referenced_;
+        };
+    }
+
+    //最近最少使用（LRU）缓存。链表的前后下标直接存放在哈希表的 entry 里，没有额外的链表节点分配。
+    //get / put / erase / 淘汰都是 O(1)。所有元素权重之和不超过 capacity，
+    //默认每个元素权重为 1；给出 WeigherT(key, value) 即可按字节等计量。
+    template<typename KeyT, typename ValueT, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>,
+        typename WeigherT = Internal::UnitWeigher>
+    class lru_cache : WeigherT
+    {
+        using Table = Internal::CacheTable<KeyT, ValueT, HashFun, KeyEqualT, Internal::LruLink>;
+        static constexpr std::size_t kNothing = Table::kNothing;
+
+    public:
+        using key_type = KeyT;
+        using mapped_type = ValueT;
+        using value_type = std::pair<key_type, mapped_type>;
+        using size_type = std::size_t;
+        using hasher = HashFun;
+        using key_equal = KeyEqualT;
+        using weigher_type = WeigherT;
+
+        explicit lru_cache(size_type capacity, weigher_type weigher = {}, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :weigher_type{weigher},
+            table_{InitialEntryCapacity(capacity), hash, keyEqual, pmr},
+            capacity_{capacity}
+        {}
+
+        size_type size() const noexcept
+        {
+            return table_.Size();
+        }
+
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        size_type capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        //当前所有元素的权重之和。
+        size_type weight() const noexcept
+        {
+            return weight_;
+        }
+
+        //找到时把元素移到最近使用的位置并返回其地址，否则返回 nullptr。指针在下一次 put 之后失效。
+        mapped_type* get(const key_type& key)
+        {
+            const auto i = table_.Find(key, table_.hash_function()(key));
+            if (i == kNothing) return nullptr;
+            MoveToFront(i);
+            return std::addressof(table_[i].KeyValue_.second);
+        }
+
+        //不改变淘汰顺序的查找。
+        const mapped_type* peek(const key_type& key) const
+        {
+            const auto i = table_.Find(key, table_.hash_function()(key));
+            return i == kNothing ? nullptr : std::addressof(table_[i].KeyValue_.second);
+        }
+
+        bool contains(const key_type& key) const
+        {
+            return peek(key) != nullptr;
+        }
+
+        //插入或覆盖，并把元素移到最近使用的位置。必要时先淘汰最久未使用的元素。返回是否插入了新元素。
+        //单个元素的权重超过 capacity 时，它会是缓存里唯一的元素。
+        bool put(const key_type& key, mapped_type value)
+        {
+            return Put(key, std::move(value));
+        }
+
+        bool put(key_type&& key, mapped_type value)
+        {
+            return Put(std::move(key), std::move(value));
+        }
+
+        bool erase(const key_type& key)
+        {
+            const auto i = table_.Find(key, table_.hash_function()(key));
+            if (i == kNothing) return false;
+            Remove(i);
+            return true;
+        }
+
+        void clear() noexcept
+        {
+            table_.Clear();
+            head_ = tail_ = kNothing;
+            weight_ = {};
+        }
+
+    private:
+        Table table_;
+        size_type capacity_;
+        size_type weight_ = {};
+        //最近使用的一端。
+        size_type head_ = kNothing;
+        //最久未使用的一端，淘汰从这里开始。
+        size_type tail_ = kNothing;
+
+        static size_type InitialEntryCapacity(size_type capacity) noexcept
+        {
+            return std::is_same<weigher_type, Internal::UnitWeigher>::value ? capacity : 0;
+        }
+
+        size_type Weigh(const key_type& key, const mapped_type& value) const
+        {
+            return static_cast<const weigher_type&>(*this)(key, value);
+        }
+
+        template<typename K>
+        bool Put(K&& key, mapped_type&& value)
+        {
+            const auto hashCode = table_.hash_function()(key);
+            const auto newWeight = Weigh(key, value);
+            const auto i = table_.Find(key, hashCode);
+            if (i != kNothing)
+            {
+                auto& entry = table_[i];
+                weight_ -= Weigh(entry.KeyValue_.first, entry.KeyValue_.second);
+                entry.KeyValue_.second = std::move(value);
+                weight_ += newWeight;
+                MoveToFront(i);
+                while (weight_ > capacity_ && tail_ != i)
+                    Remove(tail_);
+                return false;
+            }
+
+            while (tail_ != kNothing && weight_ + newWeight > capacity_)
+                Remove(tail_);
+            const auto index = table_.Emplace(hashCode, std::forward<K>(key), std::move(value));
+            weight_ += newWeight;
+            PushFront(index);
+            return true;
+        }
+
+        void Unlink(size_type i) noexcept
+        {
+            const auto& link = table_[i].Link_;
+            if (link.Prev_ == kNothing)
+                head_ = link.Next_;
+            else
+                table_[link.Prev_].Link_.Next_ = link.Next_;
+            if (link.Next_ == kNothing)
+                tail_ = link.Prev_;
+            else
+                table_[link.Next_].Link_.Prev_ = link.Prev_;
+        }
+
+        void PushFront(size_type i) noexcept
+        {
+            auto& link = table_[i].Link_;
+            link.Prev_ = kNothing;
+            link.Next_ = head_;
+            if (head_ != kNothing)
+                table_[head_].Link_.Prev_ = i;
+            head_ = i;
+            if (tail_ == kNothing)
+                tail_ = i;
+        }
+
+        void MoveToFront(size_type i) noexcept
+        {
+            if (head_ == i) return;
+            Unlink(i);
+            PushFront(i);
+        }
+
+        void Remove(size_type i) noexcept
+        {
+            const auto& kv = table_[i].KeyValue_;
+            weight_ -= Weigh(kv.first, kv.second);
+            Unlink(i);
+            table_.Remove(i);
+        }
+    };
+
+    //CLOCK（second chance）缓存：命中时只置位访问位，不移动任何东西，适合读多写少的场景。
+    //淘汰时指针沿 entry 数组转圈，清掉遇到的访问位，淘汰第一个访问位为 0 的元素。
+    //接口与 lru_cache 相同。
+    template<typename KeyT, typename ValueT, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>,
+        typename WeigherT = Internal::UnitWeigher>
+    class clock_cache : WeigherT
+    {
+        using Table = Internal::CacheTable<KeyT, ValueT, HashFun, KeyEqualT, Internal::ClockLink>;
+        static constexpr std::size_t kNothing = Table::kNothing;
+
+    public:
+        using key_type = KeyT;
+        using mapped_type = ValueT;
+        using value_type = std::pair<key_type, mapped_type>;
+        using size_type = std::size_t;
+        using hasher = HashFun;
+        using key_equal = KeyEqualT;
+        using weigher_type = WeigherT;
+
+        explicit clock_cache(size_type capacity, weigher_type weigher = {}, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :weigher_type{weigher},
+            table_{std::is_same<weigher_type, Internal::UnitWeigher>::value ? capacity : 0, hash, keyEqual, pmr},
+            capacity_{capacity}
+        {}
+
+        size_type size() const noexcept
+        {
+            return table_.Size();
+        }
+
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        size_type capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        size_type weight() const noexcept
+        {
+            return weight_;
+        }
+
+        mapped_type* get(const key_type& key)
+        {
+            const auto i = table_.Find(key, table_.hash_function()(key));
+            if (i == kNothing) return nullptr;
+            table_[i].Link_.Referenced_ = true;
+            return std::addressof(table_[i].KeyValue_.second);
+        }
+
+        const mapped_type* peek(const key_type& key) const
+        {
+            const auto i = table_.Find(key, table_.hash_function()(key));
+            return i == kNothing ? nullptr : std::addressof(table_[i].KeyValue_.second);
+        }
+
+        bool contains(const key_type& key) const
+        {
+            return peek(key) != nullptr;
+        }
+
+        bool put(const key_type& key, mapped_type value)
+        {
+            return Put(key, std::move(value));
+        }
+
+        bool put(key_type&& key, mapped_type value)
+        {
+            return Put(std::move(key), std::move(value));
+        }
+
+        bool erase(const key_type& key)
+        {
+            const auto i = table_.Find(key, table_.hash_function()(key));
+            if (i == kNothing) return false;
+            Remove(i);
+            return true;
+        }
+
+        void clear() noexcept
+        {
+            table_.Clear();
+            hand_ = {};
+            weight_ = {};
+        }
+
+    private:
+        Table table_;
+        size_type capacity_;
+        size_type weight_ = {};
+        size_type hand_ = {};
+
+        size_type Weigh(const key_type& key, const mapped_type& value) const
+        {
+            return static_cast<const weigher_type&>(*this)(key, value);
+        }
+
+        template<typename K>
+        bool Put(K&& key, mapped_type&& value)
+        {
+            const auto hashCode = table_.hash_function()(key);
+            const auto newWeight = Weigh(key, value);
+            const auto i = table_.Find(key, hashCode);
+            if (i != kNothing)
+            {
+                auto& entry = table_[i];
+                weight_ -= Weigh(entry.KeyValue_.first, entry.KeyValue_.second);
+                entry.KeyValue_.second = std::move(value);
+                entry.Link_.Referenced_ = true;
+                weight_ += newWeight;
+                while (weight_ > capacity_ && size() > 1)
+                    EvictOne(i);
+                return false;
+            }
+
+            while (size() != 0 && weight_ + newWeight > capacity_)
+                EvictOne(kNothing);
+            const auto index = table_.Emplace(hashCode, std::forward<K>(key), std::move(value));
+            table_[index].Link_.Referenced_ = false;
+            weight_ += newWeight;
+            return true;
+        }
+
+        //转一圈清访问位，最多两圈一定能找到可淘汰的元素。keep 不会被淘汰。
+        void EvictOne(size_type keep) noexcept
+        {
+            YPASSERT(size() != 0, "Evict from an empty cache!");
+            for (;;)
+            {
+                if (hand_ >= table_.HighWater())
+                    hand_ = 0;
+                auto& entry = table_[hand_];
+                const auto current = hand_++;
+                if (entry.HashCode_ == kNothing || current == keep)
+                    continue;
+                if (entry.Link_.Referenced_)
+                    entry.Link_.Referenced_ = false;
+                else
+                {
+                    Remove(current);
+                    return;
+                }
+            }
+        }
+
+        void Remove(size_type i) noexcept
+        {
+            const auto& kv = table_[i].KeyValue_;
+            weight_ -= Weigh(kv.first, kv.second);
+            table_.Remove(i);
+        }
+    };
+}
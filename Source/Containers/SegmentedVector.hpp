@@ -0,0 +1,571 @@
+﻿#pragma once
+
+#include "../Assert.hpp"
+#include "../Scope.hpp"
+#include "../Iterator.hpp"
+#include "../HelperMacros.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Yupei
+{
+    template<typename ElementT, std::size_t BlockSize>
+    class segmented_vector;
+
+    namespace Internal
+    {
+        //每块不超过 4096 字节，至少 16 个元素，取 2 的幂以便用移位和掩码定位。
+        template<typename ElementT>
+        constexpr std::size_t DefaultSegmentLength() noexcept
+        {
+            std::size_t n = 16;
+            while (n * 2 * sizeof(ElementT) <= 4096)
+                n *= 2;
+            return n;
+        }
+
+        //ValueT 为 const 时是 const_iterator。迭代器保存容器指针与下标，块索引数组增长时仍然有效。
+        template<typename ValueT, typename OwnerT>
+        class SegmentedVectorIterator
+        {
+            template<typename, typename>
+            friend class SegmentedVectorIterator;
+
+        public:
+            using MyType = SegmentedVectorIterator<ValueT, OwnerT>;
+            using value_type = std::remove_const_t<ValueT>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = ValueT*;
+            using reference = ValueT&;
+            using iterator_category = std::random_access_iterator_tag;
+
+            constexpr SegmentedVectorIterator() noexcept
+                :owner_ {}, index_ {}
+            {}
+
+            SegmentedVectorIterator(OwnerT* owner, std::size_t index) noexcept
+                :owner_ { owner }, index_ { index }
+            {}
+
+            template<typename OtherValueT, typename OtherOwnerT, typename = std::enable_if_t<std::is_convertible<OtherOwnerT*, OwnerT*>::value>>
+            SegmentedVectorIterator(const SegmentedVectorIterator<OtherValueT, OtherOwnerT>& other) noexcept
+                :owner_ { other.owner_ }, index_ { other.index_ }
+            {}
+
+            reference operator*() const noexcept
+            {
+                return (*owner_)[index_];
+            }
+
+            pointer operator->() const noexcept
+            {
+                return std::addressof(**this);
+            }
+
+            reference operator[](difference_type n) const noexcept
+            {
+                return (*owner_)[index_ + n];
+            }
+
+            MyType& operator++() noexcept
+            {
+                ++index_;
+                return *this;
+            }
+
+            MyType operator++(int) noexcept
+            {
+                auto tmp = *this;
+                ++index_;
+                return tmp;
+            }
+
+            MyType& operator--() noexcept
+            {
+                --index_;
+                return *this;
+            }
+
+            MyType operator--(int) noexcept
+            {
+                auto tmp = *this;
+                --index_;
+                return tmp;
+            }
+
+            MyType& operator+=(difference_type n) noexcept
+            {
+                index_ += n;
+                return *this;
+            }
+
+            MyType& operator-=(difference_type n) noexcept
+            {
+                index_ -= n;
+                return *this;
+            }
+
+            friend MyType operator+(MyType it, difference_type n) noexcept
+            {
+                return it += n;
+            }
+
+            friend MyType operator+(difference_type n, MyType it) noexcept
+            {
+                return it += n;
+            }
+
+            friend MyType operator-(MyType it, difference_type n) noexcept
+            {
+                return it -= n;
+            }
+
+            friend difference_type operator-(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+            }
+
+            friend bool operator==(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return lhs.index_ == rhs.index_;
+            }
+
+            friend bool operator!=(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return lhs.index_ != rhs.index_;
+            }
+
+            friend bool operator<(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return lhs.index_ < rhs.index_;
+            }
+
+            friend bool operator>(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return rhs < lhs;
+            }
+
+            friend bool operator<=(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return !(rhs < lhs);
+            }
+
+            friend bool operator>=(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return !(lhs < rhs);
+            }
+
+        private:
+            OwnerT* owner_;
+            std::size_t index_;
+        };
+    }
+
+    //元素存放在固定大小的块里，另有一个块指针的索引数组，块都从 memory_resource 分配。
+    //push_back 只会新增块而不会搬动已有元素，因此指向元素的指针和引用在增长时始终有效；
+    //下标访问是 O(1) 的一次移位加一次掩码。for_each_block 按块给出连续内存，便于向量化地遍历。
+    template<typename ElementT, std::size_t BlockSize = Internal::DefaultSegmentLength<ElementT>()>
+    class segmented_vector
+    {
+        static_assert(BlockSize != 0 && (BlockSize & (BlockSize - 1)) == 0, "BlockSize of segmented_vector must be a power of 2.");
+
+    public:
+        CONTAINER_DEFINE(ElementT)
+        using allocator_type = polymorphic_allocator<value_type>;
+        using difference_type = std::ptrdiff_t;
+        using iterator = Internal::SegmentedVectorIterator<value_type, segmented_vector>;
+        using const_iterator = Internal::SegmentedVectorIterator<const value_type, const segmented_vector>;
+
+        static constexpr size_type block_size = BlockSize;
+
+        segmented_vector() noexcept
+            :blocks_ {}, blockCount_ {}, blockCapacity_ {}, size_ {}
+        {}
+
+        explicit segmented_vector(memory_resource_ptr resource) noexcept
+            :blocks_ {}, blockCount_ {}, blockCapacity_ {}, size_ {}, allocator_ { resource }
+        {}
+
+        segmented_vector(size_type n, memory_resource_ptr resource = {})
+            :segmented_vector(resource)
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            resize(n);
+        }
+
+        segmented_vector(size_type n, const value_type& v, memory_resource_ptr resource = {})
+            :segmented_vector(resource)
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            resize(n, v);
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        segmented_vector(InputItT first, InputItT last, memory_resource_ptr resource = {})
+            :segmented_vector(resource)
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+
+        segmented_vector(std::initializer_list<value_type> il, memory_resource_ptr resource = {})
+            :segmented_vector(il.begin(), il.end(), resource)
+        {}
+
+        segmented_vector(const segmented_vector& other)
+            :segmented_vector(other.allocator_.resource())
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            reserve(other.size());
+            other.for_each_block([this](const_pointer block, size_type n) {
+                for (size_type i {}; i < n; ++i)
+                    emplace_back(block[i]);
+            });
+        }
+
+        //只交换块索引，元素本身不动。
+        segmented_vector(segmented_vector&& other) noexcept
+            :blocks_ { other.blocks_ }, blockCount_ { other.blockCount_ }, blockCapacity_ { other.blockCapacity_ },
+            size_ { other.size_ }, allocator_ { other.allocator_ }
+        {
+            other.blocks_ = {};
+            other.blockCount_ = {};
+            other.blockCapacity_ = {};
+            other.size_ = {};
+        }
+
+        segmented_vector& operator=(const segmented_vector& other)
+        {
+            if (this != &other)
+                segmented_vector(other).swap(*this);
+            return *this;
+        }
+
+        //要求两边的分配器相等。
+        segmented_vector& operator=(segmented_vector&& other) noexcept
+        {
+            if (this != &other)
+                segmented_vector(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~segmented_vector()
+        {
+            Release();
+        }
+
+        //要求两边的分配器相等。
+        void swap(segmented_vector& other) noexcept
+        {
+            YPASSERT(allocator_.resource() == other.allocator_.resource(), "Allocators of swapped segmented_vectors must be equal.");
+            std::swap(blocks_, other.blocks_);
+            std::swap(blockCount_, other.blockCount_);
+            std::swap(blockCapacity_, other.blockCapacity_);
+            std::swap(size_, other.size_);
+        }
+
+        size_type size() const noexcept
+        {
+            return size_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        //已分配的块能容纳的元素个数。
+        size_type capacity() const noexcept
+        {
+            return blockCount_ * BlockSize;
+        }
+
+        allocator_type get_allocator() const
+        {
+            return allocator_;
+        }
+
+        reference operator[](size_type n) noexcept
+        {
+            YPASSERT(n < size(), "Out of Range!");
+            return blocks_[n / BlockSize][n % BlockSize];
+        }
+
+        const_reference operator[](size_type n) const noexcept
+        {
+            YPASSERT(n < size(), "Out of Range!");
+            return blocks_[n / BlockSize][n % BlockSize];
+        }
+
+        reference at(size_type n)
+        {
+            if (n >= size()) throw std::out_of_range("Out of range!");
+            return (*this)[n];
+        }
+
+        const_reference at(size_type n) const
+        {
+            if (n >= size()) throw std::out_of_range("Out of range!");
+            return (*this)[n];
+        }
+
+        reference front() noexcept
+        {
+            return (*this)[0];
+        }
+
+        const_reference front() const noexcept
+        {
+            return (*this)[0];
+        }
+
+        reference back() noexcept
+        {
+            return (*this)[size_ - 1];
+        }
+
+        const_reference back() const noexcept
+        {
+            return (*this)[size_ - 1];
+        }
+
+        iterator begin() noexcept
+        {
+            return { this, 0 };
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return { this, 0 };
+        }
+
+        iterator end() noexcept
+        {
+            return { this, size_ };
+        }
+
+        const_iterator end() const noexcept
+        {
+            return { this, size_ };
+        }
+
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+
+        //存放了元素的块数。
+        size_type block_count() const noexcept
+        {
+            return (size_ + BlockSize - 1) / BlockSize;
+        }
+
+        //第 i 块的首地址，[block_data(i), block_data(i) + block_length(i)) 是连续的。
+        pointer block_data(size_type i) noexcept
+        {
+            YPASSERT(i < block_count(), "Out of Range!");
+            return blocks_[i];
+        }
+
+        const_pointer block_data(size_type i) const noexcept
+        {
+            YPASSERT(i < block_count(), "Out of Range!");
+            return blocks_[i];
+        }
+
+        size_type block_length(size_type i) const noexcept
+        {
+            YPASSERT(i < block_count(), "Out of Range!");
+            return i + 1 < block_count() ? BlockSize : size_ - i * BlockSize;
+        }
+
+        //对每个非空的块调用 func(pointer, size_type)。
+        template<typename FuncT>
+        void for_each_block(FuncT&& func)
+        {
+            const auto count = block_count();
+            for (size_type i {}; i < count; ++i)
+                func(blocks_[i], block_length(i));
+        }
+
+        template<typename FuncT>
+        void for_each_block(FuncT&& func) const
+        {
+            const auto count = block_count();
+            for (size_type i {}; i < count; ++i)
+                func(const_pointer(blocks_[i]), block_length(i));
+        }
+
+        void push_back(const value_type& v)
+        {
+            emplace_back(v);
+        }
+
+        void push_back(value_type&& v)
+        {
+            emplace_back(std::move(v));
+        }
+
+        //已有元素不会移动，所以参数引用本容器中的元素也没有问题。
+        template<typename... ParamsT>
+        reference emplace_back(ParamsT&&... params)
+        {
+            if (size_ == capacity())
+                AddBlock();
+            const auto p = blocks_[size_ / BlockSize] + size_ % BlockSize;
+            Yupei::construct(p, std::forward<ParamsT>(params)...);
+            ++size_;
+            return *p;
+        }
+
+        void pop_back() noexcept
+        {
+            YPASSERT(!empty(), "pop_back on empty segmented_vector!");
+            --size_;
+            Yupei::destroy_at(blocks_[size_ / BlockSize] + size_ % BlockSize);
+        }
+
+        //析构所有元素，保留已分配的块。
+        void clear() noexcept
+        {
+            DestroyFrom(0);
+            size_ = 0;
+        }
+
+        void reserve(size_type n)
+        {
+            while (capacity() < n)
+                AddBlock();
+        }
+
+        void resize(size_type n)
+        {
+            Resize(n);
+        }
+
+        void resize(size_type n, const value_type& v)
+        {
+            Resize(n, v);
+        }
+
+        //释放没有元素的块，并把块索引数组缩到恰好大小。只复制块指针，元素不会移动。
+        //分配新索引失败时空块已经释放，索引保持原来的容量。
+        void shrink_to_fit()
+        {
+            const auto used = block_count();
+            for (auto i = used; i < blockCount_; ++i)
+                allocator_.deallocate(blocks_[i], BlockSize);
+            blockCount_ = used;
+            if (used == blockCapacity_)
+                return;
+            auto indexAllocator = IndexAllocator();
+            pointer* newBlocks = {};
+            if (used != 0)
+            {
+                newBlocks = indexAllocator.allocate(used);
+                std::memcpy(newBlocks, blocks_, used * sizeof(pointer));
+            }
+            indexAllocator.deallocate(blocks_, blockCapacity_);
+            blocks_ = newBlocks;
+            blockCapacity_ = used;
+        }
+
+    private:
+        polymorphic_allocator<pointer> IndexAllocator() const noexcept
+        {
+            return polymorphic_allocator<pointer>{ allocator_ };
+        }
+
+        //新分配一块。块索引数组满了就按 2 倍增长，增长时只复制块指针。
+        void AddBlock()
+        {
+            if (blockCount_ == blockCapacity_)
+            {
+                const auto newCapacity = blockCapacity_ == 0 ? size_type(8) : blockCapacity_ * 2;
+                auto indexAllocator = IndexAllocator();
+                const auto newBlocks = indexAllocator.allocate(newCapacity);
+                if (blockCount_ != 0)
+                    std::memcpy(newBlocks, blocks_, blockCount_ * sizeof(pointer));
+                if (blocks_ != nullptr)
+                    indexAllocator.deallocate(blocks_, blockCapacity_);
+                blocks_ = newBlocks;
+                blockCapacity_ = newCapacity;
+            }
+            blocks_[blockCount_] = allocator_.allocate(BlockSize);
+            ++blockCount_;
+        }
+
+        template<typename... ParamsT>
+        void Resize(size_type n, const ParamsT&... params)
+        {
+            if (n < size_)
+            {
+                DestroyFrom(n);
+                size_ = n;
+                return;
+            }
+            reserve(n);
+            while (size_ < n)
+                emplace_back(params...);
+        }
+
+        //析构下标不小于 first 的元素，按块批量析构。
+        void DestroyFrom(size_type first) noexcept
+        {
+            while (first < size_)
+            {
+                const auto offset = first % BlockSize;
+                const auto blockEnd = (std::min)(size_, first - offset + BlockSize);
+                Yupei::destroy_n(blocks_[first / BlockSize] + offset, blockEnd - first);
+                first = blockEnd;
+            }
+        }
+
+        void Release() noexcept
+        {
+            DestroyFrom(0);
+            size_ = 0;
+            for (size_type i {}; i < blockCount_; ++i)
+                allocator_.deallocate(blocks_[i], BlockSize);
+            if (blocks_ != nullptr)
+                IndexAllocator().deallocate(blocks_, blockCapacity_);
+            blocks_ = {};
+            blockCount_ = {};
+            blockCapacity_ = {};
+        }
+
+        pointer* blocks_;
+        size_type blockCount_;
+        size_type blockCapacity_;
+        size_type size_;
+        allocator_type allocator_;
+    };
+
+    template<typename ElementT, std::size_t BlockSize>
+    void swap(segmented_vector<ElementT, BlockSize>& lhs, segmented_vector<ElementT, BlockSize>& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+}
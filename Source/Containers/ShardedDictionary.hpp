@@ -0,0 +1,300 @@
+﻿#pragma once
+
+#include "Dictionary.hpp"
+#include "Array.hpp"
+#include "Vector.hpp"
+#include "../Hash/Hash.hpp"
+#include "../Hash/HashHelpers.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../Mutex.hpp"
+#include "../Scope.hpp"
+#include "../Assert.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <utility>
+
+namespace Yupei
+{
+    //按哈希分区的字典，用于多线程聚合（group by）。
+    //每个线程通过自己的 insert_handle 无锁地写入线程私有的分区；merge_with 按分区并行地把各线程的数据合并起来，
+    //合并时直接使用 entry 里保存的哈希值，不会再调用哈希函数。合并后各分区依然分开存放，可以并行遍历。
+    template<typename KeyT, typename ValueT, std::size_t Shards, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>>
+    class sharded_dictionary : KeyEqualT, HashFun
+    {
+        static_assert(Shards > 0, "Shards must be positive!");
+
+    public:
+        using dictionary_type = dictionary<KeyT, ValueT, HashFun, KeyEqualT>;
+        using key_type = KeyT;
+        using mapped_type = ValueT;
+        using value_type = std::pair<key_type, mapped_type>;
+        using size_type = std::size_t;
+        using key_equal = KeyEqualT;
+        using hasher = HashFun;
+
+        //只能由一个线程使用。
+        class insert_handle
+        {
+            friend class sharded_dictionary;
+
+        public:
+            insert_handle(const sharded_dictionary& owner, const hasher& hash, const key_equal& keyEqual, memory_resource_ptr pmr)
+                :owner_{&owner},
+                partitions_{MakePartitions(hash, keyEqual, pmr, std::make_index_sequence<Shards>{})}
+            {}
+
+            template<typename... Args>
+            bool try_emplace(const key_type& k, Args&&... args)
+            {
+                const auto hashCode = owner_->hash_function()(k);
+                return partitions_[PartitionOf(hashCode)].try_emplace_hashed(k, hashCode, std::forward<Args>(args)...).second;
+            }
+
+            template<typename... Args>
+            bool try_emplace(key_type&& k, Args&&... args)
+            {
+                const auto hashCode = owner_->hash_function()(k);
+                return partitions_[PartitionOf(hashCode)].try_emplace_hashed(std::move(k), hashCode, std::forward<Args>(args)...).second;
+            }
+
+            template<typename M>
+            bool insert_or_assign(const key_type& k, M&& obj)
+            {
+                //try_emplace_hashed 只有真正插入时才会使用 obj，未插入时再赋值。
+                const auto hashCode = owner_->hash_function()(k);
+                const auto result = partitions_[PartitionOf(hashCode)].try_emplace_hashed(k, hashCode, std::forward<M>(obj));
+                if (!result.second)
+                    result.first->second = std::forward<M>(obj);
+                return result.second;
+            }
+
+            //key 不存在时先值初始化一个 mapped_type，然后调用 fn(mapped_type&)。返回是否插入了新元素。
+            template<typename Fn>
+            bool upsert(const key_type& key, Fn fn)
+            {
+                const auto hashCode = owner_->hash_function()(key);
+                const auto result = partitions_[PartitionOf(hashCode)].try_emplace_hashed(key, hashCode);
+                fn(result.first->second);
+                return result.second;
+            }
+
+            size_type size() const noexcept
+            {
+                size_type result = {};
+                for (const auto& partition : partitions_)
+                    result += partition.size();
+                return result;
+            }
+
+        private:
+            const sharded_dictionary* owner_;
+            array<dictionary_type, Shards> partitions_;
+        };
+
+        explicit sharded_dictionary(size_type handleCount, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :key_equal{keyEqual},
+            hasher{hash},
+            allocator_{pmr},
+            handleCount_{handleCount},
+            partitions_{MakePartitions(hash, keyEqual, pmr, std::make_index_sequence<Shards>{})}
+        {
+            handles_ = allocator_.allocate(handleCount_);
+            size_type constructed = {};
+            SCOPE_FAIL{
+                for (size_type i = 0; i < constructed; ++i)
+                    Yupei::destroy_at(handles_ + i);
+                allocator_.deallocate(handles_, handleCount_);
+            };
+            for (; constructed < handleCount_; ++constructed)
+                Yupei::construct(handles_ + constructed, *this, hash, keyEqual, pmr);
+        }
+
+        sharded_dictionary(const sharded_dictionary&) = delete;
+        sharded_dictionary& operator=(const sharded_dictionary&) = delete;
+
+        ~sharded_dictionary()
+        {
+            for (size_type i = 0; i < handleCount_; ++i)
+                Yupei::destroy_at(handles_ + i);
+            allocator_.deallocate(handles_, handleCount_);
+        }
+
+        hasher hash_function() const
+        {
+            return static_cast<hasher>(*this);
+        }
+
+        key_equal key_eq() const
+        {
+            return static_cast<key_equal>(*this);
+        }
+
+        size_type handle_count() const noexcept
+        {
+            return handleCount_;
+        }
+
+        insert_handle& handle(size_type i) noexcept
+        {
+            YPASSERT(i < handleCount_, "Handle index out of range!");
+            return handles_[i];
+        }
+
+        static constexpr size_type partition_count() noexcept
+        {
+            return Shards;
+        }
+
+        size_type partition_of(const key_type& key) const
+        {
+            return PartitionOf(hash_function()(key));
+        }
+
+        dictionary_type& partition(size_type p) noexcept
+        {
+            return partitions_[p];
+        }
+
+        const dictionary_type& partition(size_type p) const noexcept
+        {
+            return partitions_[p];
+        }
+
+        //已合并的元素个数，不包括还留在 insert_handle 里的。
+        size_type size() const noexcept
+        {
+            size_type result = {};
+            for (const auto& partition : partitions_)
+                result += partition.size();
+            return result;
+        }
+
+        bool contains(const key_type& key) const
+        {
+            const auto hashCode = hash_function()(key);
+            const auto& partition = partitions_[PartitionOf(hashCode)];
+            return partition.find_hashed(key, hashCode) != partition.end();
+        }
+
+        mapped_type& at(const key_type& key)
+        {
+            return partitions_[partition_of(key)].at(key);
+        }
+
+        const mapped_type& at(const key_type& key) const
+        {
+            return partitions_[partition_of(key)].at(key);
+        }
+
+        //把所有 insert_handle 中的数据并行地合并进各分区，之后 insert_handle 被清空，可以继续使用。
+        //已存在的键调用 combine(mapped_type& existing, mapped_type&& incoming)。
+        //各分区在不同的工作线程上合并，combine 会被并发调用（每次调用涉及的值属于不同的分区），因此它本身必须是线程安全的，不能修改未加锁的共享状态。
+        //必须在所有写入线程都停下之后调用。
+        template<typename Fn>
+        void merge_with(Fn combine)
+        {
+            ParallelFor(Shards, [&](size_type p) {
+                MergePartition(p, combine);
+            });
+        }
+
+        //每个分区在一个线程上调用 fn(size_type partitionIndex, const dictionary_type&)。
+        template<typename Fn>
+        void parallel_for_each(Fn fn) const
+        {
+            ParallelFor(Shards, [&](size_type p) {
+                fn(p, partitions_[p]);
+            });
+        }
+
+    private:
+        polymorphic_allocator<insert_handle> allocator_;
+        size_type handleCount_;
+        insert_handle* handles_;
+        array<dictionary_type, Shards> partitions_;
+
+        //用混合后的哈希选分区，与分区内 dictionary 取模用的位不相关。
+        static size_type PartitionOf(size_type hashCode) noexcept
+        {
+            return static_cast<size_type>(Internal::MixHash(hashCode) % Shards);
+        }
+
+        template<std::size_t... I>
+        static array<dictionary_type, Shards> MakePartitions(const hasher& hash, const key_equal& keyEqual, memory_resource_ptr pmr, std::index_sequence<I...>)
+        {
+            return {{MakePartition(I, hash, keyEqual, pmr)...}};
+        }
+
+        static dictionary_type MakePartition(size_type, const hasher& hash, const key_equal& keyEqual, memory_resource_ptr pmr)
+        {
+            return dictionary_type{0, hash, keyEqual, pmr};
+        }
+
+        template<typename Fn>
+        void MergePartition(size_type p, Fn& combine)
+        {
+            auto& target = partitions_[p];
+            for (size_type h = 0; h < handleCount_; ++h)
+            {
+                auto& source = handles_[h].partitions_[p];
+                if (source.size() == 0) continue;
+                if (target.size() == 0)
+                {
+                    target.swap(source);
+                    continue;
+                }
+                target.reserve(target.size() + source.size());
+                for (auto it = source.begin(); it != source.end(); ++it)
+                {
+                    //只有真正插入时才会移动 key 和 value。
+                    const auto result = target.try_emplace_hashed(std::move(it->first), source.stored_hash(it), std::move(it->second));
+                    if (!result.second)
+                        combine(result.first->second, std::move(it->second));
+                }
+                source.clear();
+            }
+        }
+
+        //在 min(n, 硬件线程数) 个线程上执行 fn(0) ... fn(n - 1)，第一个异常会在所有线程结束后重新抛出。
+        template<typename Fn>
+        static void ParallelFor(size_type n, Fn fn)
+        {
+            const auto workerCount = std::min<size_type>(n, std::max(1u, std::thread::hardware_concurrency()));
+            std::atomic<size_type> next{0};
+            std::exception_ptr exception;
+            mutex exceptionMutex;
+            const auto work = [&] {
+                for (auto i = next++; i < n; i = next++)
+                {
+                    try
+                    {
+                        fn(i);
+                    }
+                    catch (...)
+                    {
+                        lock_guard<mutex> lock{exceptionMutex};
+                        if (!exception) exception = std::current_exception();
+                    }
+                }
+            };
+
+            {
+                //当前线程也参与工作，只需另开 workerCount - 1 个线程。
+                vector<std::thread> threads;
+                threads.reserve(workerCount - 1);
+                SCOPE_EXIT{
+                    for (auto& thread : threads)
+                        thread.join();
+                };
+                for (size_type i = 1; i < workerCount; ++i)
+                    threads.push_back(std::thread{work});
+                work();
+            }
+            if (exception) std::rethrow_exception(exception);
+        }
+    };
+}
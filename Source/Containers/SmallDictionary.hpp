@@ -0,0 +1,496 @@
+﻿#pragma once
+
+#include "Dictionary.hpp"
+#include "../Hash/Hash.hpp"
+#include "../Iterator.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../Scope.hpp"
+#include "../Assert.hpp"
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Yupei
+{
+    template<typename KeyT, typename ValueT, std::size_t N, typename HashFun, typename KeyEqualT>
+    class small_dictionary;
+
+    namespace Internal
+    {
+        //内联时 ptr_ 指向内联数组，溢出到 dictionary 之后 ptr_ 为空，改用 it_。
+        template<typename ValueT, typename DictionaryIteratorT>
+        class SmallDictionaryIterator
+        {
+            template<typename, typename, std::size_t, typename, typename>
+            friend class Yupei::small_dictionary;
+
+            template<typename, typename>
+            friend class SmallDictionaryIterator;
+
+            SmallDictionaryIterator(ValueT* ptr, DictionaryIteratorT it) noexcept
+                :ptr_{ptr}, it_{it}
+            {}
+
+        public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::remove_const_t<ValueT>;
+            using iterator_category = std::forward_iterator_tag;
+            using pointer = ValueT*;
+            using reference = ValueT&;
+
+            constexpr SmallDictionaryIterator() noexcept
+                :ptr_{}, it_{}
+            {}
+
+            template<typename OtherValueT, typename OtherIteratorT, typename = std::enable_if_t<std::is_convertible<OtherValueT*, ValueT*>::value>>
+            SmallDictionaryIterator(const SmallDictionaryIterator<OtherValueT, OtherIteratorT>& other) noexcept
+                :ptr_{other.ptr_}, it_{other.it_}
+            {}
+
+            SmallDictionaryIterator& operator++() noexcept
+            {
+                if (ptr_) ++ptr_;
+                else ++it_;
+                return *this;
+            }
+
+            SmallDictionaryIterator operator++(int) noexcept
+            {
+                auto tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            reference operator*() const noexcept
+            {
+                return ptr_ ? *ptr_ : *it_;
+            }
+
+            pointer operator->() const noexcept
+            {
+                return std::addressof(this->operator*());
+            }
+
+            bool operator==(const SmallDictionaryIterator& other) const noexcept
+            {
+                return ptr_ == other.ptr_ && it_ == other.it_;
+            }
+
+            bool operator!=(const SmallDictionaryIterator& other) const noexcept
+            {
+                return !(*this == other);
+            }
+
+        private:
+            ValueT* ptr_;
+            DictionaryIteratorT it_;
+        };
+    }
+
+    //元素不超过 N 个时内联存放，不分配内存也不计算哈希，查找就是对键的线性扫描；
+    //超过 N 个之后整体搬进一个 dictionary。clear() 之后回到内联模式。
+    template<typename KeyT, typename ValueT, std::size_t N = 8, typename HashFun = hash<>, typename KeyEqualT = std::equal_to<KeyT>>
+    class small_dictionary : KeyEqualT, HashFun
+    {
+        static_assert(N > 0, "N must be positive!");
+
+    public:
+        using key_type = KeyT;
+        using mapped_type = ValueT;
+        using value_type = std::pair<key_type, mapped_type>;
+        using size_type = std::size_t;
+        using key_equal = KeyEqualT;
+        using hasher = HashFun;
+        using dictionary_type = dictionary<KeyT, ValueT, HashFun, KeyEqualT>;
+        using iterator = Internal::SmallDictionaryIterator<value_type, typename dictionary_type::iterator>;
+        using const_iterator = Internal::SmallDictionaryIterator<const value_type, typename dictionary_type::const_iterator>;
+
+        small_dictionary() noexcept
+        {}
+
+        explicit small_dictionary(hasher hash, key_equal keyEqual = {}, memory_resource_ptr pmr = {}) noexcept
+            :key_equal{keyEqual},
+            hasher{hash},
+            allocator_{pmr}
+        {}
+
+        explicit small_dictionary(memory_resource_ptr pmr) noexcept
+            :allocator_{pmr}
+        {}
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        small_dictionary(InputItT first, InputItT last, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :small_dictionary{hash, keyEqual, pmr}
+        {
+            SCOPE_FAIL{
+                clear();
+            };
+            insert(first, last);
+        }
+
+        small_dictionary(std::initializer_list<value_type> init, hasher hash = {}, key_equal keyEqual = {}, memory_resource_ptr pmr = {})
+            :small_dictionary(init.begin(), init.end(), hash, keyEqual, pmr)
+        {}
+
+        small_dictionary(const small_dictionary& other)
+            :small_dictionary(other, other.allocator_.resource())
+        {}
+
+        //复制到 pmr 上。
+        small_dictionary(const small_dictionary& other, memory_resource_ptr pmr)
+            :key_equal{other.key_eq()},
+            hasher{other.hash_function()},
+            allocator_{pmr}
+        {
+            if (other.large_)
+                large_ = NewDictionary(*other.large_, pmr);
+            else
+            {
+                SCOPE_FAIL{
+                    clear();
+                };
+                for (; size_ < other.size_; ++size_)
+                    Yupei::construct(InlineData() + size_, other.InlineData()[size_]);
+            }
+        }
+
+        small_dictionary(small_dictionary&& other) noexcept(std::is_nothrow_move_constructible<value_type>::value)
+            :key_equal{other.key_eq()},
+            hasher{other.hash_function()},
+            large_{other.large_},
+            allocator_{other.allocator_}
+        {
+            other.large_ = nullptr;
+            for (; size_ < other.size_; ++size_)
+                Yupei::construct(InlineData() + size_, std::move(other.InlineData()[size_]));
+            other.clear();
+        }
+
+        //赋值不改变本容器的分配器。
+        small_dictionary& operator=(const small_dictionary& other)
+        {
+            if (this != &other)
+                small_dictionary(other, allocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        //分配器相等时直接接管 other 溢出的 dictionary，否则把它的元素移到本容器的分配器上。
+        small_dictionary& operator=(small_dictionary&& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                static_cast<hasher&>(*this) = static_cast<const hasher&>(other);
+                static_cast<key_equal&>(*this) = static_cast<const key_equal&>(other);
+                if (other.large_ && allocator_ == other.allocator_)
+                {
+                    large_ = other.large_;
+                    other.large_ = nullptr;
+                }
+                else if (other.large_)
+                    large_ = NewDictionary(std::move(*other.large_), allocator_.resource());
+                for (; size_ < other.size_; ++size_)
+                    Yupei::construct(InlineData() + size_, std::move(other.InlineData()[size_]));
+                other.clear();
+            }
+            return *this;
+        }
+
+        ~small_dictionary()
+        {
+            clear();
+        }
+
+        //经由移动赋值交换，两边各自保留原来的分配器。
+        void swap(small_dictionary& other)
+        {
+            small_dictionary tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+        hasher hash_function() const
+        {
+            return static_cast<hasher>(*this);
+        }
+
+        key_equal key_eq() const
+        {
+            return static_cast<key_equal>(*this);
+        }
+
+        static constexpr size_type inline_capacity() noexcept
+        {
+            return N;
+        }
+
+        //是否仍然内联存放。
+        bool is_inline() const noexcept
+        {
+            return large_ == nullptr;
+        }
+
+        size_type size() const noexcept
+        {
+            return large_ ? large_->size() : size_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        iterator begin() noexcept
+        {
+            return large_ ? iterator{nullptr, large_->begin()} : iterator{InlineData(), {}};
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return large_ ? const_iterator{nullptr, Large().begin()} : const_iterator{InlineData(), {}};
+        }
+
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        iterator end() noexcept
+        {
+            return large_ ? iterator{nullptr, large_->end()} : iterator{InlineData() + size_, {}};
+        }
+
+        const_iterator end() const noexcept
+        {
+            return large_ ? const_iterator{nullptr, Large().end()} : const_iterator{InlineData() + size_, {}};
+        }
+
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+
+        iterator find(const key_type& key)
+        {
+            if (large_) return {nullptr, large_->find(key)};
+            return {InlineData() + FindInline(key), {}};
+        }
+
+        const_iterator find(const key_type& key) const
+        {
+            if (large_) return {nullptr, Large().find(key)};
+            return {InlineData() + FindInline(key), {}};
+        }
+
+        bool contains(const key_type& key) const
+        {
+            return find(key) != end();
+        }
+
+        mapped_type& at(const key_type& key)
+        {
+            const auto it = find(key);
+            if (it == end()) throw std::out_of_range("Key doesn't exist!");
+            return it->second;
+        }
+
+        const mapped_type& at(const key_type& key) const
+        {
+            const auto it = find(key);
+            if (it == end()) throw std::out_of_range("Key doesn't exist!");
+            return it->second;
+        }
+
+        mapped_type& operator[](const key_type& key)
+        {
+            return try_emplace(key).first->second;
+        }
+
+        mapped_type& operator[](key_type&& key)
+        {
+            return try_emplace(std::move(key)).first->second;
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return Insert(std::true_type{}, value.first, value.second);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value)
+        {
+            return Insert(std::true_type{}, std::move(value.first), std::move(value.second));
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void insert(InputItT first, InputItT last)
+        {
+            std::for_each(first, last, [this](const auto& v) {
+                insert(v);
+            });
+        }
+
+        template<typename M>
+        std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+        {
+            return Insert(std::false_type{}, k, std::forward<M>(obj));
+        }
+
+        template<typename M>
+        std::pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj)
+        {
+            return Insert(std::false_type{}, std::move(k), std::forward<M>(obj));
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args)
+        {
+            return Insert(std::true_type{}, k, std::forward<Args>(args)...);
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args)
+        {
+            return Insert(std::true_type{}, std::move(k), std::forward<Args>(args)...);
+        }
+
+        //内联时用最后一个元素填补空位，因此会改变遍历顺序。
+        bool erase(const key_type& key)
+        {
+            if (large_) return large_->erase(key);
+            const auto i = FindInline(key);
+            if (i == size_) return false;
+            const auto data = InlineData();
+            if (i != size_ - 1)
+                data[i] = std::move(data[size_ - 1]);
+            Yupei::destroy_at(data + size_ - 1);
+            --size_;
+            return true;
+        }
+
+        //释放溢出的 dictionary，回到内联模式。
+        void clear() noexcept
+        {
+            if (large_)
+            {
+                Yupei::destroy_at(large_);
+                allocator_.deallocate(large_, 1);
+                large_ = nullptr;
+            }
+            Yupei::destroy_n(InlineData(), size_);
+            size_ = {};
+        }
+
+    private:
+        std::aligned_storage_t<sizeof(value_type), alignof(value_type)> inline_[N];
+        size_type size_ = {};
+        dictionary_type* large_ = {};
+        polymorphic_allocator<dictionary_type> allocator_;
+
+        value_type* InlineData() noexcept
+        {
+            return reinterpret_cast<value_type*>(inline_);
+        }
+
+        const value_type* InlineData() const noexcept
+        {
+            return reinterpret_cast<const value_type*>(inline_);
+        }
+
+        const dictionary_type& Large() const noexcept
+        {
+            return *large_;
+        }
+
+        //未找到时返回 size_。
+        size_type FindInline(const key_type& key) const
+        {
+            const auto data = InlineData();
+            size_type i = 0;
+            for (; i < size_; ++i)
+                if (key_eq()(data[i].first, key))
+                    break;
+            return i;
+        }
+
+        template<typename... Args>
+        dictionary_type* NewDictionary(Args&&... args)
+        {
+            const auto p = allocator_.allocate(1);
+            SCOPE_FAIL{
+                allocator_.deallocate(p, 1);
+            };
+            Yupei::construct(p, std::forward<Args>(args)...);
+            return p;
+        }
+
+        //AddOnlyT 为 std::true_type 时是 try_emplace，否则是 insert_or_assign。
+        template<typename AddOnlyT, typename K, typename... Args>
+        std::pair<iterator, bool> Insert(AddOnlyT addOnly, K&& key, Args&&... args)
+        {
+            if (large_)
+                return LargeInsert(addOnly, std::forward<K>(key), std::forward<Args>(args)...);
+
+            const auto data = InlineData();
+            const auto i = FindInline(key);
+            if (i != size_)
+            {
+                Assign(addOnly, data[i].second, std::forward<Args>(args)...);
+                return {{data + i, {}}, false};
+            }
+            if (size_ == N)
+            {
+                Spill();
+                return LargeInsert(addOnly, std::forward<K>(key), std::forward<Args>(args)...);
+            }
+            Yupei::construct(data + size_, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+            ++size_;
+            return {{data + size_ - 1, {}}, true};
+        }
+
+        template<typename... Args>
+        static void Assign(std::true_type, mapped_type&, Args&&...) noexcept
+        {}
+
+        template<typename M>
+        static void Assign(std::false_type, mapped_type& value, M&& obj)
+        {
+            value = std::forward<M>(obj);
+        }
+
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> LargeInsert(std::true_type, K&& key, Args&&... args)
+        {
+            const auto result = large_->try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+            return {{nullptr, result.first}, result.second};
+        }
+
+        template<typename K, typename M>
+        std::pair<iterator, bool> LargeInsert(std::false_type, K&& key, M&& obj)
+        {
+            const auto result = large_->insert_or_assign(std::forward<K>(key), std::forward<M>(obj));
+            return {{nullptr, result.first}, result.second};
+        }
+
+        //把内联的元素搬进新建的 dictionary。
+        void Spill()
+        {
+            const auto large = NewDictionary(N * 2, hash_function(), key_eq(), allocator_.resource());
+            SCOPE_FAIL{
+                Yupei::destroy_at(large);
+                allocator_.deallocate(large, 1);
+            };
+            const auto data = InlineData();
+            for (size_type i = 0; i < size_; ++i)
+                large->insert(std::move(data[i]));
+            Yupei::destroy_n(data, size_);
+            size_ = {};
+            large_ = large;
+        }
+    };
+}
@@ -0,0 +1,566 @@
+﻿#pragma once
+
+#include "../Assert.hpp"
+#include "../Scope.hpp"
+#include "../Iterator.hpp"
+#include "../HelperMacros.hpp"
+#include "../ConstructDestruct.hpp"
+#include "Vector.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Yupei
+{
+    //前 N 个元素放在对象内部的数组里，超过 N 之后才从 memory_resource 分配，接口与 vector 相同。
+    //元素很少的临时对象因此完全不需要调用分配器。迭代器就是指针。
+    template<typename ElementT, std::size_t N>
+    class small_vector
+    {
+        static_assert(N > 0, "Inline capacity of small_vector must be positive.");
+
+    public:
+        CONTAINER_DEFINE(ElementT)
+        using allocator_type = polymorphic_allocator<value_type>;
+        using difference_type = std::ptrdiff_t;
+        using iterator = pointer;
+        using const_iterator = const_pointer;
+
+        small_vector() noexcept
+            :storage_{InlineStorage()}
+        {}
+
+        explicit small_vector(memory_resource_ptr resource) noexcept
+            :storage_{InlineStorage()}, allocator_{resource}
+        {}
+
+        small_vector(size_type n, memory_resource_ptr resource = {})
+            :small_vector(resource)
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            resize(n);
+        }
+
+        small_vector(size_type n, const value_type& v, memory_resource_ptr resource = {})
+            :small_vector(resource)
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            resize(n, v);
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        small_vector(InputItT first, InputItT last, memory_resource_ptr resource = {})
+            :small_vector(resource)
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            append(first, last);
+        }
+
+        small_vector(std::initializer_list<value_type> il, memory_resource_ptr resource = {})
+            :small_vector(il.begin(), il.end(), resource)
+        {}
+
+        small_vector(const small_vector& other)
+            :small_vector(other.begin(), other.end(), other.allocator_.resource())
+        {}
+
+        small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible<value_type>::value)
+            :storage_{InlineStorage()}, allocator_{other.allocator_}
+        {
+            TakeFrom(other);
+        }
+
+        //赋值不改变本容器的分配器。
+        small_vector& operator=(const small_vector& other)
+        {
+            if (this != &other)
+                small_vector(other.begin(), other.end(), allocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        //分配器不同时不能接管 other 的堆空间，只能逐个移动元素。
+        small_vector& operator=(small_vector&& other)
+        {
+            if (this != &other)
+            {
+                Release();
+                if (allocator_ == other.allocator_)
+                    TakeFrom(other);
+                else
+                {
+                    append(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+                    other.Release();
+                }
+            }
+            return *this;
+        }
+
+        small_vector& operator=(std::initializer_list<value_type> il)
+        {
+            small_vector(il, allocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        ~small_vector()
+        {
+            Release();
+        }
+
+        //两边都在堆上且分配器相等时只交换指针，否则经由移动赋值逐个移动元素，各自保留原来的分配器。
+        void swap(small_vector& other)
+        {
+            if (this == &other) return;
+            if (!is_inline() && !other.is_inline() && allocator_ == other.allocator_)
+            {
+                std::swap(storage_, other.storage_);
+                std::swap(size_, other.size_);
+                std::swap(capacity_, other.capacity_);
+                return;
+            }
+            small_vector tmp {std::move(other)};
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+        //元素是否还在对象内部的数组里。
+        bool is_inline() const noexcept
+        {
+            return storage_ == InlineStorage();
+        }
+
+        static constexpr size_type inline_capacity() noexcept
+        {
+            return N;
+        }
+
+        allocator_type get_allocator() const
+        {
+            return allocator_;
+        }
+
+        reference back() noexcept
+        {
+            return storage_[size_ - 1];
+        }
+
+        const_reference back() const noexcept
+        {
+            return storage_[size_ - 1];
+        }
+
+        reference front() noexcept
+        {
+            return storage_[0];
+        }
+
+        const_reference front() const noexcept
+        {
+            return storage_[0];
+        }
+
+        size_type max_size() const noexcept
+        {
+            return size_type(-1) / sizeof(value_type);
+        }
+
+        pointer data() noexcept
+        {
+            return storage_;
+        }
+
+        const_pointer data() const noexcept
+        {
+            return storage_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        size_type size() const noexcept
+        {
+            return size_;
+        }
+
+        size_type capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        //保留已分配的堆空间。
+        void clear() noexcept
+        {
+            Yupei::destroy_n(storage_, size_);
+            size_ = {};
+        }
+
+        reference operator[](size_type n) noexcept
+        {
+            YPASSERT(n < size(), "Out of Range!");
+            return storage_[n];
+        }
+
+        const_reference operator[](size_type n) const noexcept
+        {
+            YPASSERT(n < size(), "Out of Range!");
+            return storage_[n];
+        }
+
+        reference at(size_type pos)
+        {
+            if (pos >= size()) throw std::out_of_range("Out of range!");
+            return storage_[pos];
+        }
+
+        const_reference at(size_type pos) const
+        {
+            if (pos >= size()) throw std::out_of_range("Out of range!");
+            return storage_[pos];
+        }
+
+        iterator begin() noexcept
+        {
+            return storage_;
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return storage_;
+        }
+
+        iterator end() noexcept
+        {
+            return storage_ + size_;
+        }
+
+        const_iterator end() const noexcept
+        {
+            return storage_ + size_;
+        }
+
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+
+        void reserve(size_type cap)
+        {
+            if (cap > capacity_)
+                Reallocate(cap);
+        }
+
+        void resize(size_type count)
+        {
+            Resize(count);
+        }
+
+        void resize(size_type count, const value_type& v)
+        {
+            //v 可能引用本容器中的元素，重新分配前先复制一份。
+            if (count > capacity_)
+            {
+                const value_type copy(v);
+                Resize(count, copy);
+            }
+            else
+                Resize(count, v);
+        }
+
+        void push_back(const value_type& v)
+        {
+            emplace_back(v);
+        }
+
+        void push_back(value_type&& v)
+        {
+            emplace_back(std::move(v));
+        }
+
+        //参数可能引用本容器中的元素，所以重新分配时先构造新元素，再搬动旧元素。
+        template<typename... ParamsT>
+        reference emplace_back(ParamsT&&... params)
+        {
+            if (size_ == capacity_)
+            {
+                const auto newCapacity = CalcNewSize(size_ + 1);
+                const auto newStorage = allocator_.allocate(newCapacity);
+                SCOPE_FAIL{
+                    allocator_.deallocate(newStorage, newCapacity);
+                };
+                Yupei::construct(newStorage + size_, std::forward<ParamsT>(params)...);
+                SCOPE_FAIL{
+                    Yupei::destroy_at(newStorage + size_);
+                };
+                Yupei::relocate_n(storage_, size_, newStorage);
+                ReplaceStorage(newStorage, newCapacity);
+            }
+            else
+                Yupei::construct(storage_ + size_, std::forward<ParamsT>(params)...);
+            return storage_[size_++];
+        }
+
+        void pop_back(size_type n = 1) noexcept
+        {
+            YPASSERT(n <= size_, "Pop too many elements!");
+            Yupei::destroy_n(storage_ + size_ - n, n);
+            size_ -= n;
+        }
+
+        iterator insert(const_iterator pos, const value_type& value)
+        {
+            return emplace(pos, value);
+        }
+
+        iterator insert(const_iterator pos, value_type&& value)
+        {
+            return emplace(pos, std::move(value));
+        }
+
+        template<typename... ParamsT>
+        iterator emplace(const_iterator pos, ParamsT&&... params)
+        {
+            const auto offset = static_cast<size_type>(pos - cbegin());
+            YPASSERT(offset <= size_, "Insert at an invalid position!");
+            if (offset == size_)
+            {
+                emplace_back(std::forward<ParamsT>(params)...);
+                return storage_ + offset;
+            }
+            //先构造出来，params 可能引用将被移动的元素。
+            value_type value(std::forward<ParamsT>(params)...);
+            if (size_ == capacity_)
+            {
+                const auto newCapacity = CalcNewSize(size_ + 1);
+                const auto newStorage = allocator_.allocate(newCapacity);
+                SCOPE_FAIL{
+                    allocator_.deallocate(newStorage, newCapacity);
+                };
+                Yupei::construct(newStorage + offset, std::move(value));
+                SCOPE_FAIL{
+                    Yupei::destroy_at(newStorage + offset);
+                };
+                RelocateAround(newStorage, offset, is_trivially_relocatable<value_type>());
+                ReplaceStorage(newStorage, newCapacity);
+            }
+            else
+            {
+                Yupei::construct(storage_ + size_, std::move(storage_[size_ - 1]));
+                std::move_backward(storage_ + offset, storage_ + size_ - 1, storage_ + size_);
+                storage_[offset] = std::move(value);
+            }
+            ++size_;
+            return storage_ + offset;
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void append(InputItT first, InputItT last)
+        {
+            Append(first, last, is_forward_iterator<InputItT>{});
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            const auto offset = first - cbegin();
+            const auto count = last - first;
+            if (count != 0)
+            {
+                const auto target = std::move(storage_ + offset + count, end(), storage_ + offset);
+                Yupei::destroy_n(target, static_cast<size_type>(end() - target));
+                size_ -= static_cast<size_type>(count);
+            }
+            return storage_ + offset;
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            return erase(pos, pos + 1);
+        }
+
+    private:
+        pointer storage_;
+        size_type size_ = {};
+        size_type capacity_ = N;
+        polymorphic_allocator<ElementT> allocator_;
+        std::aligned_storage_t<sizeof(value_type), alignof(value_type)> inline_[N];
+
+        pointer InlineStorage() noexcept
+        {
+            return reinterpret_cast<pointer>(inline_);
+        }
+
+        const_pointer InlineStorage() const noexcept
+        {
+            return reinterpret_cast<const_pointer>(inline_);
+        }
+
+        //要求 *this 为空且在内联数组里。other 在堆上时直接接管，在内联数组里时逐个移动元素。
+        void TakeFrom(small_vector& other) noexcept(std::is_nothrow_move_constructible<value_type>::value)
+        {
+            YPASSERT(empty() && is_inline(), "Take elements into a non-empty small_vector!");
+            if (other.is_inline())
+            {
+                Yupei::relocate_n(other.storage_, other.size_, storage_);
+                size_ = other.size_;
+                other.size_ = {};
+            }
+            else
+            {
+                storage_ = other.storage_;
+                size_ = other.size_;
+                capacity_ = other.capacity_;
+                other.storage_ = other.InlineStorage();
+                other.size_ = {};
+                other.capacity_ = N;
+            }
+        }
+
+        void Release() noexcept
+        {
+            Yupei::destroy_n(storage_, size_);
+            size_ = {};
+            if (!is_inline())
+            {
+                allocator_.deallocate(storage_, capacity_);
+                storage_ = InlineStorage();
+                capacity_ = N;
+            }
+        }
+
+        //使用 vector 的默认增长策略。
+        size_type CalcNewSize(size_type newCapacity) const noexcept
+        {
+            return vector_growth_1_5x::grow(capacity_, newCapacity, sizeof(value_type));
+        }
+
+        //旧元素已经搬走，只释放旧空间。
+        void ReplaceStorage(pointer newStorage, size_type newCapacity) noexcept
+        {
+            if (!is_inline())
+                allocator_.deallocate(storage_, capacity_);
+            storage_ = newStorage;
+            capacity_ = newCapacity;
+        }
+
+        //把 [0, offset) 与 [offset, size_) 分别搬到 newStorage 与 newStorage + offset + 1。
+        void RelocateAround(pointer newStorage, size_type offset, std::true_type) noexcept
+        {
+            Yupei::relocate_n(storage_, offset, newStorage);
+            Yupei::relocate_n(storage_ + offset, size_ - offset, newStorage + offset + 1);
+        }
+
+        //两段都构造成功之后才析构旧元素，与 vector 相同。
+        void RelocateAround(pointer newStorage, size_type offset, std::false_type)
+        {
+            Yupei::uninitialized_move_if_noexcept_n(storage_, offset, newStorage);
+            SCOPE_FAIL{
+                Yupei::destroy_n(newStorage, offset);
+            };
+            Yupei::uninitialized_move_if_noexcept_n(storage_ + offset, size_ - offset, newStorage + offset + 1);
+            Yupei::destroy_n(storage_, size_);
+        }
+
+        void Reallocate(size_type newCapacity)
+        {
+            const auto newStorage = allocator_.allocate(newCapacity);
+            SCOPE_FAIL{
+                allocator_.deallocate(newStorage, newCapacity);
+            };
+            Yupei::relocate_n(storage_, size_, newStorage);
+            ReplaceStorage(newStorage, newCapacity);
+        }
+
+        template<typename... ParamsT>
+        void Resize(size_type count, const ParamsT&... params)
+        {
+            if (count <= size_)
+            {
+                pop_back(size_ - count);
+                return;
+            }
+            if (count > capacity_)
+                Reallocate(CalcNewSize(count));
+            for (; size_ < count; ++size_)
+                Yupei::construct(storage_ + size_, params...);
+        }
+
+        template<typename InputItT>
+        void Append(InputItT first, InputItT last, std::false_type)
+        {
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+
+        //[first, last) 可能来自本容器，所以重新分配时先在新空间里构造追加的元素，再搬动旧元素。
+        template<typename ForwardItT>
+        void Append(ForwardItT first, ForwardItT last, std::true_type)
+        {
+            const auto n = static_cast<size_type>(std::distance(first, last));
+            if (size_ + n > capacity_)
+            {
+                const auto newCapacity = CalcNewSize(size_ + n);
+                const auto newStorage = allocator_.allocate(newCapacity);
+                SCOPE_FAIL{
+                    allocator_.deallocate(newStorage, newCapacity);
+                };
+                ConstructRange(first, n, newStorage + size_);
+                SCOPE_FAIL{
+                    Yupei::destroy_n(newStorage + size_, n);
+                };
+                Yupei::relocate_n(storage_, size_, newStorage);
+                ReplaceStorage(newStorage, newCapacity);
+                size_ += n;
+                return;
+            }
+            for (; first != last; ++first, ++size_)
+                Yupei::construct(storage_ + size_, *first);
+        }
+
+        //在未初始化的 dest 上复制 n 个元素，失败时析构已构造的部分。
+        template<typename ForwardItT>
+        static void ConstructRange(ForwardItT first, size_type n, pointer dest)
+        {
+            size_type i = {};
+            SCOPE_FAIL{
+                Yupei::destroy_n(dest, i);
+            };
+            for (; i < n; ++i, ++first)
+                Yupei::construct(dest + i, *first);
+        }
+    };
+
+    template<typename ElementT, std::size_t N>
+    void swap(small_vector<ElementT, N>& lhs, small_vector<ElementT, N>& rhs) noexcept(noexcept(lhs.swap(rhs)))
+    {
+        lhs.swap(rhs);
+    }
+
+    template<typename ElementT, std::size_t N>
+    bool operator==(const small_vector<ElementT, N>& lhs, const small_vector<ElementT, N>& rhs)
+    {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    template<typename ElementT, std::size_t N>
+    bool operator!=(const small_vector<ElementT, N>& lhs, const small_vector<ElementT, N>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+}
@@ -0,0 +1,728 @@
+﻿#pragma once
+
+#include "../Assert.hpp"
+#include "../Scope.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "Vector.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace Yupei
+{
+    //一列连续的元素，供向量化的循环直接使用。不拥有内存，soa_vector 重新分配后失效。
+    template<typename T>
+    class soa_column
+    {
+    public:
+        using value_type = std::remove_const_t<T>;
+        using size_type = std::size_t;
+        using pointer = T*;
+        using reference = T&;
+        using iterator = T*;
+
+        constexpr soa_column() noexcept
+            :data_ {}, size_ {}
+        {}
+
+        constexpr soa_column(T* data, size_type size) noexcept
+            :data_ { data }, size_ { size }
+        {}
+
+        constexpr T* data() const noexcept
+        {
+            return data_;
+        }
+
+        constexpr size_type size() const noexcept
+        {
+            return size_;
+        }
+
+        constexpr bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        constexpr T* begin() const noexcept
+        {
+            return data_;
+        }
+
+        constexpr T* end() const noexcept
+        {
+            return data_ + size_;
+        }
+
+        T& operator[](size_type i) const noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            return data_[i];
+        }
+
+    private:
+        T* data_;
+        size_type size_;
+    };
+
+    namespace Internal
+    {
+        //解引用得到 soa_vector 的行代理（引用的 tuple）。迭代器保存容器指针与行号。
+        template<typename OwnerT, typename ReferenceT>
+        class SoaVectorIterator
+        {
+            template<typename, typename>
+            friend class SoaVectorIterator;
+
+        public:
+            using MyType = SoaVectorIterator<OwnerT, ReferenceT>;
+            using value_type = typename std::remove_const_t<OwnerT>::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = ReferenceT;
+            using iterator_category = std::random_access_iterator_tag;
+
+            constexpr SoaVectorIterator() noexcept
+                :owner_ {}, index_ {}
+            {}
+
+            SoaVectorIterator(OwnerT* owner, std::size_t index) noexcept
+                :owner_ { owner }, index_ { index }
+            {}
+
+            template<typename OtherOwnerT, typename OtherReferenceT, typename = std::enable_if_t<std::is_convertible<OtherOwnerT*, OwnerT*>::value>>
+            SoaVectorIterator(const SoaVectorIterator<OtherOwnerT, OtherReferenceT>& other) noexcept
+                :owner_ { other.owner_ }, index_ { other.index_ }
+            {}
+
+            reference operator*() const noexcept
+            {
+                return (*owner_)[index_];
+            }
+
+            reference operator[](difference_type n) const noexcept
+            {
+                return (*owner_)[index_ + n];
+            }
+
+            MyType& operator++() noexcept
+            {
+                ++index_;
+                return *this;
+            }
+
+            MyType operator++(int) noexcept
+            {
+                auto tmp = *this;
+                ++index_;
+                return tmp;
+            }
+
+            MyType& operator--() noexcept
+            {
+                --index_;
+                return *this;
+            }
+
+            MyType operator--(int) noexcept
+            {
+                auto tmp = *this;
+                --index_;
+                return tmp;
+            }
+
+            MyType& operator+=(difference_type n) noexcept
+            {
+                index_ += n;
+                return *this;
+            }
+
+            MyType& operator-=(difference_type n) noexcept
+            {
+                index_ -= n;
+                return *this;
+            }
+
+            friend MyType operator+(MyType it, difference_type n) noexcept
+            {
+                return it += n;
+            }
+
+            friend MyType operator+(difference_type n, MyType it) noexcept
+            {
+                return it += n;
+            }
+
+            friend MyType operator-(MyType it, difference_type n) noexcept
+            {
+                return it -= n;
+            }
+
+            friend difference_type operator-(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+            }
+
+            friend bool operator==(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return lhs.index_ == rhs.index_;
+            }
+
+            friend bool operator!=(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return lhs.index_ != rhs.index_;
+            }
+
+            friend bool operator<(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return lhs.index_ < rhs.index_;
+            }
+
+            friend bool operator>(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return rhs < lhs;
+            }
+
+            friend bool operator<=(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return !(rhs < lhs);
+            }
+
+            friend bool operator>=(const MyType& lhs, const MyType& rhs) noexcept
+            {
+                return !(lhs < rhs);
+            }
+
+        private:
+            OwnerT* owner_;
+            std::size_t index_;
+        };
+    }
+
+    //结构体数组的按列存储：每个成员类型一列，所有列放在同一块从 memory_resource 分配的内存里，每列按 64 字节对齐。
+    //只扫描一两个字段的循环因此只会读到这几列，不会把整条记录都拉进缓存。
+    //operator[] 返回引用的 tuple 作为行代理，column<I>() 返回整列的 soa_column。
+    template<typename... Ts>
+    class soa_vector
+    {
+        static_assert(sizeof...(Ts) > 0, "soa_vector needs at least one column.");
+
+        static constexpr std::size_t kColumnAlign = 64;
+        static constexpr std::size_t kColumnCount = sizeof...(Ts);
+        static constexpr std::size_t kColumnSizes[kColumnCount] = { sizeof(Ts)... };
+        static constexpr std::size_t kRowBytes = (0 + ... + sizeof(Ts));
+
+        static_assert((true && ... && (alignof(Ts) <= kColumnAlign)), "Column types of soa_vector must not be over-aligned.");
+
+        using Columns = std::tuple<Ts*...>;
+        using Indices = std::index_sequence_for<Ts...>;
+
+    public:
+        using value_type = std::tuple<Ts...>;
+        using reference = std::tuple<Ts&...>;
+        using const_reference = std::tuple<const Ts&...>;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using iterator = Internal::SoaVectorIterator<soa_vector, reference>;
+        using const_iterator = Internal::SoaVectorIterator<const soa_vector, const_reference>;
+
+        template<std::size_t I>
+        using column_type = std::tuple_element_t<I, value_type>;
+
+        soa_vector() noexcept
+            :columns_ {}
+        {}
+
+        explicit soa_vector(memory_resource_ptr resource) noexcept
+            :allocator_ { resource }, columns_ {}
+        {}
+
+        soa_vector(size_type n, memory_resource_ptr resource = {})
+            :soa_vector(resource)
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            resize(n);
+        }
+
+        soa_vector(const soa_vector& other)
+            :soa_vector(other.allocator_)
+        {
+            SCOPE_FAIL{
+                Release();
+            };
+            reserve(other.size_);
+            for (size_type i {}; i < other.size_; ++i)
+                CopyRow(other, i, Indices());
+        }
+
+        soa_vector(soa_vector&& other) noexcept
+            :allocator_ { other.allocator_ }, storage_ { other.storage_ }, columns_ { other.columns_ },
+            size_ { other.size_ }, capacity_ { other.capacity_ }
+        {
+            other.storage_ = {};
+            other.columns_ = {};
+            other.size_ = {};
+            other.capacity_ = {};
+        }
+
+        soa_vector& operator=(const soa_vector& other)
+        {
+            if (this != &other)
+                soa_vector(other).swap(*this);
+            return *this;
+        }
+
+        //要求两边的分配器相等。
+        soa_vector& operator=(soa_vector&& other) noexcept
+        {
+            if (this != &other)
+                soa_vector(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~soa_vector()
+        {
+            Release();
+        }
+
+        //要求两边的分配器相等。
+        void swap(soa_vector& other) noexcept
+        {
+            YPASSERT(allocator_ == other.allocator_, "Allocators of swapped soa_vectors must be equal.");
+            std::swap(storage_, other.storage_);
+            std::swap(columns_, other.columns_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+        }
+
+        size_type size() const noexcept
+        {
+            return size_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        size_type capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        size_type max_size() const noexcept
+        {
+            return (size_type(-1) - kColumnAlign * (kColumnCount + 1)) / kRowBytes;
+        }
+
+        memory_resource_ptr resource() const noexcept
+        {
+            return allocator_;
+        }
+
+        reference operator[](size_type i) noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            return MakeRow<reference>(columns_, i, Indices());
+        }
+
+        const_reference operator[](size_type i) const noexcept
+        {
+            YPASSERT(i < size_, "Out of Range!");
+            return MakeRow<const_reference>(columns_, i, Indices());
+        }
+
+        reference at(size_type i)
+        {
+            if (i >= size_) throw std::out_of_range("Out of range!");
+            return (*this)[i];
+        }
+
+        const_reference at(size_type i) const
+        {
+            if (i >= size_) throw std::out_of_range("Out of range!");
+            return (*this)[i];
+        }
+
+        reference front() noexcept
+        {
+            return (*this)[0];
+        }
+
+        const_reference front() const noexcept
+        {
+            return (*this)[0];
+        }
+
+        reference back() noexcept
+        {
+            return (*this)[size_ - 1];
+        }
+
+        const_reference back() const noexcept
+        {
+            return (*this)[size_ - 1];
+        }
+
+        template<std::size_t I>
+        soa_column<column_type<I>> column() noexcept
+        {
+            return { std::get<I>(columns_), size_ };
+        }
+
+        template<std::size_t I>
+        soa_column<const column_type<I>> column() const noexcept
+        {
+            return { std::get<I>(columns_), size_ };
+        }
+
+        iterator begin() noexcept
+        {
+            return { this, 0 };
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return { this, 0 };
+        }
+
+        iterator end() noexcept
+        {
+            return { this, size_ };
+        }
+
+        const_iterator end() const noexcept
+        {
+            return { this, size_ };
+        }
+
+        const_iterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        const_iterator cend() const noexcept
+        {
+            return end();
+        }
+
+        void push_back(const Ts&... values)
+        {
+            emplace_back(values...);
+        }
+
+        void push_back(Ts&&... values)
+        {
+            emplace_back(std::move(values)...);
+        }
+
+        //每个参数构造对应列的一个元素。参数可能引用本容器中的元素，重新分配时先在新内存中构造这一行再搬动旧元素。
+        template<typename... ArgsT>
+        reference emplace_back(ArgsT&&... args)
+        {
+            static_assert(sizeof...(ArgsT) == kColumnCount, "emplace_back needs exactly one argument per column.");
+            if (size_ == capacity_)
+            {
+                const auto newCapacity = CalcNewCapacity(size_ + 1);
+                void* newStorage;
+                const auto newColumns = Allocate(newCapacity, newStorage);
+                SCOPE_FAIL{
+                    Deallocate(newStorage, newCapacity);
+                };
+                ConstructRow(newColumns, size_, Indices(), std::forward<ArgsT>(args)...);
+                SCOPE_FAIL{
+                    DestroyRow(newColumns, size_, Indices());
+                };
+                TransferTo(newStorage, newColumns, newCapacity);
+            }
+            else
+                ConstructRow(columns_, size_, Indices(), std::forward<ArgsT>(args)...);
+            ++size_;
+            return back();
+        }
+
+        void pop_back() noexcept
+        {
+            YPASSERT(!empty(), "pop_back on empty soa_vector!");
+            --size_;
+            DestroyRow(columns_, size_, Indices());
+        }
+
+        void clear() noexcept
+        {
+            DestroyRows(0, Indices());
+            size_ = 0;
+        }
+
+        void reserve(size_type n)
+        {
+            if (n > capacity_)
+                Reallocate(n);
+        }
+
+        void resize(size_type n)
+        {
+            if (n < size_)
+            {
+                DestroyRows(n, Indices());
+                size_ = n;
+                return;
+            }
+            if (n > capacity_)
+                Reallocate(CalcNewCapacity(n));
+            while (size_ < n)
+            {
+                ConstructDefaultRow(size_, Indices());
+                ++size_;
+            }
+        }
+
+        void resize(size_type n, const Ts&... values)
+        {
+            if (n < size_)
+            {
+                DestroyRows(n, Indices());
+                size_ = n;
+                return;
+            }
+            if (n > capacity_)
+            {
+                //values 可能引用本容器中的元素，重新分配前先复制一份。
+                const std::tuple<Ts...> copy(values...);
+                Reallocate(CalcNewCapacity(n));
+                ResizeFrom(n, copy, Indices());
+                return;
+            }
+            while (size_ < n)
+            {
+                ConstructRow(columns_, size_, Indices(), values...);
+                ++size_;
+            }
+        }
+
+        void shrink_to_fit()
+        {
+            if (capacity_ == size_)
+                return;
+            if (size_ == 0)
+            {
+                Deallocate(storage_, capacity_);
+                storage_ = {};
+                columns_ = {};
+                capacity_ = {};
+            }
+            else
+                Reallocate(size_);
+        }
+
+    private:
+        template<std::size_t... Is>
+        void ResizeFrom(size_type n, const std::tuple<Ts...>& values, std::index_sequence<Is...>)
+        {
+            resize(n, std::get<Is>(values)...);
+        }
+
+        static constexpr size_type AlignUp(size_type n) noexcept
+        {
+            return (n + kColumnAlign - 1) & ~(kColumnAlign - 1);
+        }
+
+        //每列的字节数都向上取整到 64，这样下一列的起点也是对齐的。多分配 64 字节用来对齐首地址。
+        static size_type BlockBytes(size_type capacity) noexcept
+        {
+            size_type bytes = kColumnAlign;
+            for (auto columnSize : kColumnSizes)
+                bytes += AlignUp(capacity * columnSize);
+            return bytes;
+        }
+
+        template<std::size_t... Is>
+        static Columns MakeColumns(unsigned char* base, size_type capacity, std::index_sequence<Is...>) noexcept
+        {
+            size_type offsets[kColumnCount] {};
+            for (size_type i = 1; i < kColumnCount; ++i)
+                offsets[i] = offsets[i - 1] + AlignUp(capacity * kColumnSizes[i - 1]);
+            return Columns { reinterpret_cast<Ts*>(base + offsets[Is])... };
+        }
+
+        //new_delete_resource 不保证对齐，手动对齐到 64 字节。
+        Columns Allocate(size_type capacity, void*& storage)
+        {
+            if (capacity > max_size())
+                throw std::bad_array_new_length();
+            storage = allocator_->allocate(BlockBytes(capacity), alignof(std::max_align_t));
+            const auto address = reinterpret_cast<std::uintptr_t>(storage);
+            const auto base = reinterpret_cast<unsigned char*>((address + kColumnAlign - 1) & ~static_cast<std::uintptr_t>(kColumnAlign - 1));
+            return MakeColumns(base, capacity, Indices());
+        }
+
+        void Deallocate(void* storage, size_type capacity) noexcept
+        {
+            if (storage)
+                allocator_->deallocate(storage, BlockBytes(capacity), alignof(std::max_align_t));
+        }
+
+        size_type CalcNewCapacity(size_type required) const noexcept
+        {
+            return vector_growth_1_5x::grow(capacity_, required, kRowBytes);
+        }
+
+        template<typename RowT, std::size_t... Is>
+        static RowT MakeRow(const Columns& columns, size_type i, std::index_sequence<Is...>) noexcept
+        {
+            return RowT { std::get<Is>(columns)[i]... };
+        }
+
+        //逐列构造第 row 行，某一列构造失败时析构这一行已构造的列。
+        template<std::size_t... Is, typename... ArgsT>
+        static void ConstructRow(const Columns& columns, size_type row, std::index_sequence<Is...>, ArgsT&&... args)
+        {
+            size_type constructed {};
+            SCOPE_FAIL{
+                DestroyRowPrefix(columns, row, constructed, std::index_sequence<Is...>());
+            };
+            ((Yupei::construct(std::get<Is>(columns) + row, std::forward<ArgsT>(args)), ++constructed), ...);
+        }
+
+        template<std::size_t... Is>
+        void ConstructDefaultRow(size_type row, std::index_sequence<Is...>)
+        {
+            size_type constructed {};
+            SCOPE_FAIL{
+                DestroyRowPrefix(columns_, row, constructed, std::index_sequence<Is...>());
+            };
+            ((Yupei::construct(std::get<Is>(columns_) + row), ++constructed), ...);
+        }
+
+        template<std::size_t... Is>
+        void CopyRow(const soa_vector& other, size_type row, std::index_sequence<Is...>)
+        {
+            ConstructRow(columns_, size_, Indices(), static_cast<const Ts&>(std::get<Is>(other.columns_)[row])...);
+            ++size_;
+        }
+
+        template<std::size_t... Is>
+        static void DestroyRowPrefix(const Columns& columns, size_type row, size_type count, std::index_sequence<Is...>) noexcept
+        {
+            ((Is < count ? Yupei::destroy_at(std::get<Is>(columns) + row) : void()), ...);
+        }
+
+        template<std::size_t... Is>
+        static void DestroyRow(const Columns& columns, size_type row, std::index_sequence<Is...>) noexcept
+        {
+            (Yupei::destroy_at(std::get<Is>(columns) + row), ...);
+        }
+
+        template<std::size_t... Is>
+        void DestroyRows(size_type first, std::index_sequence<Is...>) noexcept
+        {
+            (Yupei::destroy_n(std::get<Is>(columns_) + first, size_ - first), ...);
+        }
+
+        void Reallocate(size_type newCapacity)
+        {
+            void* newStorage;
+            const auto newColumns = Allocate(newCapacity, newStorage);
+            SCOPE_FAIL{
+                Deallocate(newStorage, newCapacity);
+            };
+            TransferTo(newStorage, newColumns, newCapacity);
+        }
+
+        //把所有列搬到新内存并释放旧内存。全部搬完后才析构旧元素，失败时原容器不变。
+        void TransferTo(void* newStorage, const Columns& newColumns, size_type newCapacity)
+        {
+            TransferColumns(newColumns, Indices());
+            Deallocate(storage_, capacity_);
+            storage_ = newStorage;
+            columns_ = newColumns;
+            capacity_ = newCapacity;
+        }
+
+        //搬动时可能抛出异常的列：既不能按字节搬，移动构造也可能抛出，只能复制。
+        template<typename T>
+        using TransferMayThrow = std::integral_constant<bool, !is_trivially_relocatable<T>::value && !std::is_nothrow_move_constructible<T>::value>;
+
+        //先复制可能失败的列，这时所有源列都还完好；其余的列不会失败，再移动过去。
+        template<std::size_t... Is>
+        void TransferColumns(const Columns& newColumns, std::index_sequence<Is...>)
+        {
+            bool copied[kColumnCount] {};
+            SCOPE_FAIL{
+                ((copied[Is] ? AbandonColumn(std::get<Is>(newColumns), size_, is_trivially_relocatable<Ts>()) : void()), ...);
+            };
+            ((TransferMayThrow<Ts>::value ? (CopyColumn(std::get<Is>(columns_), size_, std::get<Is>(newColumns), is_trivially_relocatable<Ts>()), void(copied[Is] = true)) : void()), ...);
+            ((TransferMayThrow<Ts>::value ? void() : CopyColumn(std::get<Is>(columns_), size_, std::get<Is>(newColumns), is_trivially_relocatable<Ts>())), ...);
+            (FinishColumn(std::get<Is>(columns_), size_, is_trivially_relocatable<Ts>()), ...);
+        }
+
+        template<typename T>
+        static void CopyColumn(T* from, size_type n, T* to, std::true_type) noexcept
+        {
+            if (n != 0)
+                std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), n * sizeof(T));
+        }
+
+        //移动构造可能抛出异常时改为复制，保证源不变。
+        template<typename T>
+        static void CopyColumn(T* from, size_type n, T* to, std::false_type)
+        {
+            size_type i {};
+            SCOPE_FAIL{
+                Yupei::destroy_n(to, i);
+            };
+            for (; i < n; ++i)
+                Yupei::construct(to + i, std::move_if_noexcept(from[i]));
+        }
+
+        template<typename T>
+        static void AbandonColumn(T*, size_type, std::true_type) noexcept
+        {}
+
+        template<typename T>
+        static void AbandonColumn(T* to, size_type n, std::false_type) noexcept
+        {
+            Yupei::destroy_n(to, n);
+        }
+
+        template<typename T>
+        static void FinishColumn(T*, size_type, std::true_type) noexcept
+        {}
+
+        template<typename T>
+        static void FinishColumn(T* from, size_type n, std::false_type) noexcept
+        {
+            Yupei::destroy_n(from, n);
+        }
+
+        void Release() noexcept
+        {
+            clear();
+            Deallocate(storage_, capacity_);
+            storage_ = {};
+            columns_ = {};
+            capacity_ = {};
+        }
+
+        memory_resource_ptr allocator_;
+        void* storage_ = {};
+        Columns columns_;
+        size_type size_ = {};
+        size_type capacity_ = {};
+    };
+
+    template<typename... Ts>
+    void swap(soa_vector<Ts...>& lhs, soa_vector<Ts...>& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+}
@@ -0,0 +1,348 @@
+﻿#pragma once
+
+#include "Dictionary.hpp"
+#include "../Hash/Hash.hpp"
+#include "../MemoryResource/MemoryResource.hpp"
+#include "../ConstructDestruct.hpp"
+#include "../Scope.hpp"
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+namespace Yupei
+{
+    namespace Internal
+    {
+        //字符串的前 8 个字节，不足的部分补 0。
+        inline std::uint64_t LoadStringPrefix(const char* data, std::size_t length) noexcept
+        {
+            std::uint64_t prefix = 0;
+            if (length != 0)
+                std::memcpy(&prefix, data, std::min<std::size_t>(length, sizeof(prefix)));
+            return prefix;
+        }
+
+        //存放在 entry 里的键：字节在 arena 中，长度与前缀内联。
+        struct ArenaStringKey
+        {
+            const char* Data_;
+            std::size_t Length_;
+            std::uint64_t Prefix_;
+
+            std::string_view view() const noexcept
+            {
+                return {Data_, Length_};
+            }
+
+            operator std::string_view() const noexcept
+            {
+                return view();
+            }
+        };
+
+        //查找用的键，前缀只在查找开始时算一次。
+        struct StringLookupKey
+        {
+            std::string_view String_;
+            std::uint64_t Prefix_;
+
+            explicit StringLookupKey(std::string_view str) noexcept
+                :String_{str}, Prefix_{LoadStringPrefix(str.data(), str.size())}
+            {}
+        };
+
+        template<typename HashFun>
+        struct ArenaStringHash : HashFun
+        {
+            using is_transparent = void;
+
+            ArenaStringHash() = default;
+
+            explicit ArenaStringHash(const HashFun& hash)
+                :HashFun{hash}
+            {}
+
+            std::size_t operator()(const ArenaStringKey& key) const
+            {
+                return HashFun::operator()(key.view());
+            }
+
+            std::size_t operator()(const StringLookupKey& key) const
+            {
+                return HashFun::operator()(key.String_);
+            }
+        };
+
+        //先比较长度与前缀，只有长度超过 8 时才会读 arena 里剩下的字节。
+        struct ArenaStringEqual
+        {
+            using is_transparent = void;
+
+            static bool Equal(const char* lhs, std::size_t lhsLength, std::uint64_t lhsPrefix,
+                const char* rhs, std::size_t rhsLength, std::uint64_t rhsPrefix) noexcept
+            {
+                constexpr auto kPrefixSize = sizeof(std::uint64_t);
+                return lhsLength == rhsLength && lhsPrefix == rhsPrefix &&
+                    (lhsLength <= kPrefixSize || std::memcmp(lhs + kPrefixSize, rhs + kPrefixSize, lhsLength - kPrefixSize) == 0);
+            }
+
+            bool operator()(const ArenaStringKey& lhs, const ArenaStringKey& rhs) const noexcept
+            {
+                return Equal(lhs.Data_, lhs.Length_, lhs.Prefix_, rhs.Data_, rhs.Length_, rhs.Prefix_);
+            }
+
+            bool operator()(const ArenaStringKey& lhs, const StringLookupKey& rhs) const noexcept
+            {
+                return Equal(lhs.Data_, lhs.Length_, lhs.Prefix_, rhs.String_.data(), rhs.String_.size(), rhs.Prefix_);
+            }
+        };
+    }
+
+    //字符串键的字典。插入时把键的字节复制进一个 monotonic_buffer_resource，entry 里只存指针、长度和前 8 个字节；
+    //比较键时先比长度和前缀，因此大多数不相等的键不会去读 arena，也不会为每个键单独分配内存。
+    //遍历得到的 first 可以隐式转换为 std::string_view，在元素被删除或 clear() 之前一直有效。
+    //erase 不会回收键占用的 arena 字节，clear() 才会。
+    template<typename ValueT, typename HashFun = hash<>>
+    class string_dictionary
+    {
+    public:
+        using key_type = std::string_view;
+        using mapped_type = ValueT;
+        using size_type = std::size_t;
+        using hasher = HashFun;
+        using dictionary_type = dictionary<Internal::ArenaStringKey, ValueT, Internal::ArenaStringHash<HashFun>, Internal::ArenaStringEqual>;
+        using value_type = typename dictionary_type::value_type;
+        using iterator = typename dictionary_type::iterator;
+        using const_iterator = typename dictionary_type::const_iterator;
+
+        explicit string_dictionary(memory_resource_ptr pmr = {})
+            :string_dictionary{hasher{}, pmr}
+        {}
+
+        explicit string_dictionary(hasher hash, memory_resource_ptr pmr = {})
+            :arenaAllocator_{pmr},
+            arena_{NewArena()},
+            dict_{0, Internal::ArenaStringHash<HashFun>{hash}, {}, pmr}
+        {}
+
+        string_dictionary(std::initializer_list<std::pair<key_type, mapped_type>> init, memory_resource_ptr pmr = {})
+            :string_dictionary{pmr}
+        {
+            dict_.reserve(init.size());
+            for (const auto& kv : init)
+                try_emplace(kv.first, kv.second);
+        }
+
+        string_dictionary(const string_dictionary& other)
+            :string_dictionary(other, other.arenaAllocator_.resource())
+        {}
+
+        //键复制进 pmr 上新的 arena，哈希值沿用 other 保存的值。
+        string_dictionary(const string_dictionary& other, memory_resource_ptr pmr)
+            :arenaAllocator_{pmr},
+            arena_{NewArena()},
+            dict_{0, other.dict_.hash_function(), {}, pmr}
+        {
+            SCOPE_FAIL{
+                DeleteArena();
+            };
+            CopyFrom(other);
+        }
+
+        //other 留下一个新的空 arena 和一个有桶的空字典，仍然可以继续使用。
+        string_dictionary(string_dictionary&& other)
+            :arenaAllocator_{other.arenaAllocator_},
+            arena_{other.NewArena()},
+            dict_{0, other.dict_.hash_function(), {}, other.arenaAllocator_.resource()}
+        {
+            swap(other);
+        }
+
+        //赋值不改变本字典的分配器。
+        string_dictionary& operator=(const string_dictionary& other)
+        {
+            if (this != &other)
+                string_dictionary(other, arenaAllocator_.resource()).swap(*this);
+            return *this;
+        }
+
+        //分配器不同时不能接管 other 的 arena，键复制进本字典的 arena，值逐个移动。
+        string_dictionary& operator=(string_dictionary&& other)
+        {
+            if (this == &other) return *this;
+            if (arenaAllocator_ == other.arenaAllocator_)
+                string_dictionary(std::move(other)).swap(*this);
+            else
+            {
+                string_dictionary result(static_cast<const hasher&>(other.dict_.hash_function()), arenaAllocator_.resource());
+                result.CopyFrom(std::move(other));
+                result.swap(*this);
+                other.clear();
+            }
+            return *this;
+        }
+
+        ~string_dictionary()
+        {
+            dict_.clear();
+            DeleteArena();
+        }
+
+        //要求两边的分配器相等。
+        void swap(string_dictionary& other) noexcept
+        {
+            YPASSERT(arenaAllocator_ == other.arenaAllocator_, "Allocators of swapped string_dictionaries must be equal.");
+            using std::swap;
+            swap(arena_, other.arena_);
+            dict_.swap(other.dict_);
+        }
+
+        size_type size() const noexcept
+        {
+            return dict_.size();
+        }
+
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        void reserve(size_type n)
+        {
+            dict_.reserve(n);
+        }
+
+        iterator begin() noexcept
+        {
+            return dict_.begin();
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return dict_.begin();
+        }
+
+        iterator end() noexcept
+        {
+            return dict_.end();
+        }
+
+        const_iterator end() const noexcept
+        {
+            return dict_.end();
+        }
+
+        iterator find(key_type key)
+        {
+            return dict_.find(Internal::StringLookupKey{key});
+        }
+
+        const_iterator find(key_type key) const
+        {
+            return dict_.find(Internal::StringLookupKey{key});
+        }
+
+        bool contains(key_type key) const
+        {
+            return find(key) != end();
+        }
+
+        mapped_type& at(key_type key)
+        {
+            return dict_.at(Internal::StringLookupKey{key});
+        }
+
+        const mapped_type& at(key_type key) const
+        {
+            return dict_.at(Internal::StringLookupKey{key});
+        }
+
+        mapped_type& operator[](key_type key)
+        {
+            return try_emplace(key).first->second;
+        }
+
+        //只有在真正插入时才会把键复制进 arena。
+        template<typename... Args>
+        std::pair<iterator, bool> try_emplace(key_type key, Args&&... args)
+        {
+            const Internal::StringLookupKey lookupKey{key};
+            const auto hashCode = dict_.hash_function()(lookupKey);
+            const auto it = dict_.find_hashed(lookupKey, hashCode);
+            if (it != dict_.end()) return {it, false};
+            return dict_.try_emplace_hashed(CopyKey(key), hashCode, std::forward<Args>(args)...);
+        }
+
+        template<typename M>
+        std::pair<iterator, bool> insert_or_assign(key_type key, M&& obj)
+        {
+            const Internal::StringLookupKey lookupKey{key};
+            const auto hashCode = dict_.hash_function()(lookupKey);
+            const auto it = dict_.find_hashed(lookupKey, hashCode);
+            if (it != dict_.end())
+            {
+                it->second = std::forward<M>(obj);
+                return {it, false};
+            }
+            return dict_.try_emplace_hashed(CopyKey(key), hashCode, std::forward<M>(obj));
+        }
+
+        bool erase(key_type key)
+        {
+            return dict_.erase(Internal::StringLookupKey{key});
+        }
+
+        //同时释放 arena 中所有键的字节。先分配新的 arena，分配失败时字典保持不变。
+        void clear()
+        {
+            const auto arena = NewArena();
+            dict_.clear();
+            DeleteArena();
+            arena_ = arena;
+        }
+
+    private:
+        polymorphic_allocator<monotonic_buffer_resource> arenaAllocator_;
+        monotonic_buffer_resource* arena_;
+        dictionary_type dict_;
+
+        monotonic_buffer_resource* NewArena()
+        {
+            const auto arena = arenaAllocator_.allocate(1);
+            SCOPE_FAIL{
+                arenaAllocator_.deallocate(arena, 1);
+            };
+            Yupei::construct(arena, arenaAllocator_.resource());
+            return arena;
+        }
+
+        void DeleteArena() noexcept
+        {
+            Yupei::destroy_at(arena_);
+            arenaAllocator_.deallocate(arena_, 1);
+        }
+
+        //other 为右值时移动值。
+        template<typename StringDictionaryT>
+        void CopyFrom(StringDictionaryT&& other)
+        {
+            using ValueRef = std::conditional_t<std::is_lvalue_reference<StringDictionaryT>::value, const mapped_type&, mapped_type&&>;
+            dict_.reserve(other.size());
+            for (auto it = other.dict_.begin(); it != other.dict_.end(); ++it)
+                dict_.try_emplace_hashed(CopyKey(it->first.view()), other.dict_.stored_hash(it), static_cast<ValueRef>(it->second));
+        }
+
+        Internal::ArenaStringKey CopyKey(key_type key)
+        {
+            char* data = nullptr;
+            if (!key.empty())
+            {
+                data = static_cast<char*>(arena_->allocate(key.size(), 1));
+                std::memcpy(data, key.data(), key.size());
+            }
+            return {data, key.size(), Internal::LoadStringPrefix(key.data(), key.size())};
+        }
+    };
+}
@@ -10,35 +10,38 @@
 #include <algorithm>
 #include <stdexcept> //for std::out_of_range
 #include <memory>
+#include <cstring>
 
 namespace Yupei
 {
-    template<typename ElementT>
+    struct vector_growth_1_5x;
+
+    template<typename ElementT, typename GrowthPolicyT = vector_growth_1_5x>
     class vector;
 
     namespace Internal
     {
-        template<typename T>
+        template<typename T, typename ContainerT>
+        class vector_const_iterator;
+
+        template<typename T, typename ContainerT>
         class vector_iterator
         {
         public:
-            using MyType = vector_iterator<T>;
+            using MyType = vector_iterator<T, ContainerT>;
             using difference_type = std::ptrdiff_t;
             using iterator_category = std::random_access_iterator_tag;
 
-            template<typename U>
-            friend class Yupei::vector;
+            friend ContainerT;
 
-            template<typename U>
-            friend constexpr auto do_pointer_from(vector_iterator<U> it) noexcept -> U*
+            friend constexpr auto do_pointer_from(MyType it) noexcept -> T*
             {
                 return it.current_;
             }
 
-            template<typename U>
-            friend class vector_const_iterator;
+            friend class vector_const_iterator<T, ContainerT>;
 
-            using ContainerType = Yupei::vector<T>;
+            using ContainerType = ContainerT;
 
             T* current_;
             ContainerType* container_;
@@ -74,15 +77,13 @@ namespace Yupei
                 return tmp;
             }
 
-            template<typename U>
-            friend vector_iterator<U> operator + (vector_iterator<U> it, difference_type n) noexcept
+            friend MyType operator + (MyType it, difference_type n) noexcept
             {
                 it += n;
                 return it;
             }
 
-            template<typename U>
-            friend vector_iterator<U> operator + (difference_type n, vector_iterator<U> it) noexcept
+            friend MyType operator + (difference_type n, MyType it) noexcept
             {
                 it += n;
                 return it;
@@ -101,15 +102,13 @@ namespace Yupei
                 return tmp;
             }
 
-            template<typename U>
-            friend vector_iterator<U> operator - (vector_iterator<U> it, difference_type n) noexcept
+            friend MyType operator - (MyType it, difference_type n) noexcept
             {
                 it -= n;
                 return it;
             }
 
-            template<typename U>
-            friend difference_type operator - (const vector_iterator<U>& lhs, const vector_iterator<U>& rhs) noexcept
+            friend difference_type operator - (const MyType& lhs, const MyType& rhs) noexcept
             {
                 return lhs.current_ - rhs.current_;
             }
@@ -156,19 +155,17 @@ namespace Yupei
 
         };
 
-        template<typename T>
+        template<typename T, typename ContainerT>
         class vector_const_iterator
         {
         public:
-            using MyType = vector_const_iterator<T>;
+            using MyType = vector_const_iterator<T, ContainerT>;
 
-            template<typename U>
-            friend class Yupei::vector;
+            friend ContainerT;
 
-            using ContainerType = Yupei::vector<T>;
+            using ContainerType = ContainerT;
 
-            template<typename U>
-            friend constexpr auto do_pointer_from(vector_const_iterator<U> it) noexcept -> U*
+            friend constexpr auto do_pointer_from(MyType it) noexcept -> T*
             {
                 return it.current_;
             }
@@ -193,7 +190,7 @@ namespace Yupei
                 container_ {}
             {}
 
-            vector_const_iterator(const vector_iterator<T>& it)
+            vector_const_iterator(const vector_iterator<T, ContainerT>& it)
                 :current_ { it.current_ },
                 container_ { it.container_ }
             {}
@@ -228,29 +225,25 @@ namespace Yupei
                 return tmp;
             }
 
-            template<typename U>
-            friend vector_const_iterator<U> operator + (vector_const_iterator<U> it, difference_type n) noexcept
+            friend MyType operator + (MyType it, difference_type n) noexcept
             {
                 it += n;
                 return it;
             }
 
-            template<typename U>
-            friend vector_const_iterator<U> operator + (difference_type n, vector_const_iterator<U> it) noexcept
+            friend MyType operator + (difference_type n, MyType it) noexcept
             {
                 it += n;
                 return it;
             }
 
-            template<typename U>
-            friend vector_const_iterator<U> operator - (vector_const_iterator<U> it, difference_type n) noexcept
+            friend MyType operator - (MyType it, difference_type n) noexcept
             {
                 it -= n;
                 return it;
             }
 
-            template<typename U>
-            friend difference_type operator - (const vector_const_iterator<U>& lhs, const vector_const_iterator<U>& rhs) noexcept
+            friend difference_type operator - (const MyType& lhs, const MyType& rhs) noexcept
             {
                 return lhs.current_ - rhs.current_;
             }
@@ -297,16 +290,66 @@ namespace Yupei
         };
     }
 
-    template<typename ElementT>
+    //vector 的增长策略。grow 根据当前容量、至少需要的容量和元素大小给出新的容量，结果不能小于 required。
+    //reserve 与 shrink_to_fit 总是按确切大小分配，不经过增长策略。
+
+    //1.5 倍增长，字节数向上取整到 64。默认策略。
+    struct vector_growth_1_5x
+    {
+        static std::size_t grow(std::size_t capacity, std::size_t required, std::size_t elementSize) noexcept
+        {
+            auto newCapacity = capacity + (capacity >> 1) + 1;
+            if (newCapacity < required) newCapacity = required;
+            const auto bytes = (newCapacity * elementSize + 63) & ~std::size_t(63);
+            return (std::max)(bytes / elementSize, required);
+        }
+    };
+
+    //2 倍增长，重新分配的次数更少，但最多浪费一半空间。
+    struct vector_growth_2x
+    {
+        static std::size_t grow(std::size_t capacity, std::size_t required, std::size_t elementSize) noexcept
+        {
+            auto newCapacity = capacity == 0 ? (std::max)(std::size_t(64) / elementSize, std::size_t(1)) : capacity * 2;
+            return (std::max)(newCapacity, required);
+        }
+    };
+
+    //1.5 倍增长，超过一页后按页（4096 字节）向上取整，适合大的缓冲区。
+    struct vector_growth_page
+    {
+        static constexpr std::size_t PageSize = 4096;
+
+        static std::size_t grow(std::size_t capacity, std::size_t required, std::size_t elementSize) noexcept
+        {
+            const auto newCapacity = vector_growth_1_5x::grow(capacity, required, elementSize);
+            const auto bytes = newCapacity * elementSize;
+            if (bytes < PageSize)
+                return newCapacity;
+            return (std::max)(((bytes + PageSize - 1) & ~(PageSize - 1)) / elementSize, required);
+        }
+    };
+
+    //只分配需要的大小，内存最省，但逐个追加时每次都会重新分配。
+    struct vector_growth_exact
+    {
+        static std::size_t grow(std::size_t, std::size_t required, std::size_t) noexcept
+        {
+            return required;
+        }
+    };
+
+    template<typename ElementT, typename GrowthPolicyT>
     class vector
     {
     public:
         CONTAINER_DEFINE(ElementT)
         using allocator_type = polymorphic_allocator<value_type>;
+        using growth_policy = GrowthPolicyT;
 
 #ifdef _DEBUG
-        using iterator = Internal::vector_iterator<ElementT>;
-        using const_iterator = Internal::vector_const_iterator<ElementT>;
+        using iterator = Internal::vector_iterator<ElementT, vector>;
+        using const_iterator = Internal::vector_const_iterator<ElementT, vector>;
 #else
         using iterator = pointer;
         using const_iterator = const value_type*;
@@ -323,7 +366,7 @@ namespace Yupei
         vector(size_type n, const value_type& v, memory_resource_ptr resource = {})
             :vector { resource }
         {
-            Reserve(n);
+            reserve(n);
             Yupei::construct_n(storage_, n, v);
             size_ = n;
         }
@@ -336,9 +379,7 @@ namespace Yupei
             vector(InputItT first, InputItT last, memory_resource_ptr pmr = {})
             : vector { pmr }
         {
-            std::for_each(first, last, [&](const iterator_value_type_t<InputItT>& v) {
-                push_back(v);
-            });
+            append(first, last);
         }
 
         vector(std::initializer_list<value_type> il)
@@ -449,13 +490,32 @@ namespace Yupei
                 Yupei::destroy_n(storage_ + count, nowSize - count);
             else if (count > nowSize)
             {
-                Reserve(count);
+                ReserveMore(count - nowSize);
                 const auto prevEnd = storage_ + nowSize;
                 Yupei::construct_n(prevEnd, count - nowSize);
             }
             size_ = count;
         }
 
+        //调整大小但不初始化新增的元素，用于马上要被整体覆盖的缓冲区（例如读文件、接收网络数据）。
+        void resize_uninitialized(size_type count)
+        {
+            static_assert(std::is_trivial<value_type>::value, "resize_uninitialized requires a trivial value_type.");
+            if (count > size_)
+                ReserveMore(count - size_);
+            size_ = count;
+        }
+
+        //在末尾追加 n 个未初始化的元素，返回指向第一个新元素的指针。
+        pointer append_uninitialized(size_type n)
+        {
+            static_assert(std::is_trivial<value_type>::value, "append_uninitialized requires a trivial value_type.");
+            ReserveMore(n);
+            const auto first = storage_ + size_;
+            size_ += n;
+            return first;
+        }
+
         reference operator[](size_type n) noexcept
         {
             YPASSERT(n < size(), "Out of Range!");
@@ -517,14 +577,28 @@ namespace Yupei
 
         void push_back(const value_type& v)
         {
-            ReserveMore(1);
-            AddElementAtLast(v);
+            emplace_back(v);
         }
 
         void push_back(value_type&& v)
         {
-            ReserveMore(1);
-            AddElementAtLast(std::move(v));
+            emplace_back(std::move(v));
+        }
+
+        //直接在末尾构造元素。参数可能引用本容器中的元素，重新分配时交给 Insert 先构造新元素再搬动旧元素。
+        template<typename... ParamsT>
+        reference emplace_back(ParamsT&&... params)
+        {
+            if (size_ == capacity_)
+                return *Insert(cend(), std::forward<ParamsT>(params)...);
+            AddElementAtLast(std::forward<ParamsT>(params)...);
+            return back();
+        }
+
+        template<typename... ParamsT>
+        iterator emplace(const_iterator pos, ParamsT&&... params)
+        {
+            return Insert(pos, std::forward<ParamsT>(params)...);
         }
 
         void pop_back(size_type n = 1) noexcept
@@ -540,45 +614,70 @@ namespace Yupei
 
         void reserve(size_type cap)
         {
-            Reserve(cap);
+            if (cap > capacity())
+                Reserve(cap);
+        }
+
+        //释放多余的容量。元素会被搬到一块恰好大小的新内存中。
+        void shrink_to_fit()
+        {
+            if (capacity_ == size_)
+                return;
+            if (size_ == 0)
+            {
+                allocator_.deallocate(storage_, capacity_);
+                storage_ = {};
+                capacity_ = {};
+            }
+            else
+                Reserve(size_);
         }
 
         iterator insert(const_iterator pos, const value_type& value)
         {
-            return Insert(1, pos, value);
+            return Insert(pos, value);
         }
 
         iterator insert(const_iterator pos, value_type&& value)
         {
-            return Insert(1, pos, std::move(value));
+            return Insert(pos, std::move(value));
         }
 
-        template<typename IteratorT>
-        void append(IteratorT first, IteratorT last)
+        iterator insert(const_iterator pos, size_type n, const value_type& value)
         {
-            if (std::is_base_of<std::forward_iterator_tag, IteratorT>::value)
-            {
-                const auto dist = std::distance(first, last);
-                ReserveMore(dist);
-                std::for_each(first, last, [this](const iterator_value_type_t<IteratorT>& v) {
-                    AddElementAtLast(v);
-                });
-            }
-            else
-            {
-                std::for_each(first, last, [this](const iterator_value_type_t<IteratorT>& v) {
-                    push_back(v);
-                });
-            }
+            //value 可能是本容器中的元素，挪动前先复制一份。
+            const value_type copy(value);
+            return InsertN(static_cast<size_type>(pos - cbegin()), n, [&](pointer dest) {
+                FillN(dest, n, copy);
+            });
+        }
+
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        iterator insert(const_iterator pos, InputItT first, InputItT last)
+        {
+            return InsertRange(static_cast<size_type>(pos - cbegin()), first, last, iterator_category_t<InputItT>());
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<value_type> il)
+        {
+            return insert(pos, il.begin(), il.end());
+        }
+
+        //[first, last) 可以是本容器的元素。
+        template<typename InputItT, typename = std::enable_if_t<is_input_iterator<InputItT>::value>>
+        void append(InputItT first, InputItT last)
+        {
+            (void)InsertRange(size_, first, last, iterator_category_t<InputItT>());
         }
 
         iterator erase(const_iterator first, const_iterator last)
         {
-            const auto numToErase = last - first;
-            Yupei::destroy_n(std::addressof(*first), numToErase);
-            std::move(last, end(), first);
+            const auto offset = static_cast<size_type>(first - cbegin());
+            const auto numToErase = static_cast<size_type>(last - first);
+            if (numToErase != 0)
+                EraseGap(storage_ + offset, numToErase, is_trivially_relocatable<value_type>());
             size_ -= numToErase;
-            return last;
+            return MakeIterator(storage_ + offset);
         }
 
         iterator erase(const_iterator pos)
@@ -587,29 +686,214 @@ namespace Yupei
         }
 
     private:
+        //在 pos 处插入一个用 params 构造的元素。params 可能引用本容器中的元素，因此先构造好新元素再挪动旧元素。
         template<typename... ParamsT>
-        iterator Insert(size_type n, const_iterator pos, ParamsT&&... params)
+        iterator Insert(const_iterator pos, ParamsT&&... params)
+        {
+            const auto offset = static_cast<size_type>(pos - cbegin());
+            if (size_ == capacity_)
+            {
+                //重新分配时直接把新元素构造在最终位置，旧元素各搬一次。
+                const auto newCapacity = CalcNewSize(size_ + 1);
+                const auto newStorage = allocator_.allocate(newCapacity);
+                SCOPE_FAIL{
+                    allocator_.deallocate(newStorage, newCapacity);
+                };
+                Yupei::construct(newStorage + offset, std::forward<ParamsT>(params)...);
+                SCOPE_FAIL{
+                    Yupei::destroy_at(newStorage + offset);
+                };
+                RelocateAround(newStorage, offset, 1);
+                allocator_.deallocate(storage_, capacity_);
+                storage_ = newStorage;
+                capacity_ = newCapacity;
+            }
+            else if (offset == size_)
+                Yupei::construct(storage_ + offset, std::forward<ParamsT>(params)...);
+            else
+                InsertGap(offset, is_trivially_relocatable<value_type>(), std::forward<ParamsT>(params)...);
+            ++size_;
+            return MakeIterator(storage_ + offset);
+        }
+
+        //只能单趟遍历的区间无法预先知道长度，逐个追加到末尾后再旋转到 offset。
+        template<typename InputItT>
+        iterator InsertRange(size_type offset, InputItT first, InputItT last, std::input_iterator_tag)
         {
-            const auto newSize = size() + n;
-            const auto insertionOffset = pos - cbegin();
-            pointer des {};
-            ReserveMore(n);
-            //因为 reserveMore 可能会重新分配内存，故要将依赖指针的操作放在后面。
-            const auto prevEnd = storage_ + size();
-            const auto insertionPoint = begin() + insertionOffset;
-            if (pos == cend())
-            {
-                Yupei::construct_n(prevEnd, n, std::forward<ParamsT>(params)...);
-                des = prevEnd;
-            }
+            const auto oldSize = size_;
+            SCOPE_FAIL{
+                pop_back(size_ - oldSize);
+            };
+            for (; first != last; ++first)
+                emplace_back(*first);
+            std::rotate(storage_ + offset, storage_ + oldSize, storage_ + size_);
+            return MakeIterator(storage_ + offset);
+        }
+
+        //先求出长度，只分配一次、只挪动一次尾部。
+        template<typename ForwardItT>
+        iterator InsertRange(size_type offset, ForwardItT first, ForwardItT last, std::forward_iterator_tag)
+        {
+            const auto n = static_cast<size_type>(std::distance(first, last));
+            return InsertN(offset, n, [&](pointer dest) {
+                CopyN(first, n, dest, CanMemcpyFrom<ForwardItT>());
+            });
+        }
+
+        //在 offset 处空出 n 个位置，由 constructN(dest) 在未初始化的 dest 上构造 n 个元素，失败时它负责析构已构造的部分。
+        //需要重新分配时先在新空间里构造新元素，再搬动旧元素，因此新元素可以来自本容器。
+        template<typename ConstructorT>
+        iterator InsertN(size_type offset, size_type n, ConstructorT constructN)
+        {
+            if (n == 0)
+                return MakeIterator(storage_ + offset);
+            if (n > capacity_ - size_)
+            {
+                if (size_ + n < size_)
+                    throw std::bad_array_new_length();
+                const auto newCapacity = CalcNewSize(size_ + n);
+                const auto newStorage = allocator_.allocate(newCapacity);
+                SCOPE_FAIL{
+                    allocator_.deallocate(newStorage, newCapacity);
+                };
+                constructN(newStorage + offset);
+                SCOPE_FAIL{
+                    Yupei::destroy_n(newStorage + offset, n);
+                };
+                RelocateAround(newStorage, offset, n);
+                allocator_.deallocate(storage_, capacity_);
+                storage_ = newStorage;
+                capacity_ = newCapacity;
+            }
+            else if (offset == size_)
+                constructN(storage_ + offset);
             else
-            {
-                std::move_backward(insertionPoint, end(), prevEnd + n);
-                des = storage_ + insertionOffset;
-                Yupei::construct_n(des, n, std::forward<ParamsT>(params)...);
-            }
-            size_ = newSize;
-            return MakeIterator(des);
+                InsertGapN(offset, n, constructN, is_trivially_relocatable<value_type>());
+            size_ += n;
+            return MakeIterator(storage_ + offset);
+        }
+
+        //按字节把尾部整体后移 n 格再构造新元素；构造失败时再移回去。
+        template<typename ConstructorT>
+        void InsertGapN(size_type offset, size_type n, ConstructorT& constructN, std::true_type)
+        {
+            const auto gap = storage_ + offset;
+            const auto tailBytes = (size_ - offset) * sizeof(value_type);
+            std::memmove(static_cast<void*>(gap + n), static_cast<const void*>(gap), tailBytes);
+            SCOPE_FAIL{
+                std::memmove(static_cast<void*>(gap), static_cast<const void*>(gap + n), tailBytes);
+            };
+            constructN(gap);
+        }
+
+        //在末尾构造新元素后旋转到 offset。
+        template<typename ConstructorT>
+        void InsertGapN(size_type offset, size_type n, ConstructorT& constructN, std::false_type)
+        {
+            const auto last = storage_ + size_;
+            constructN(last);
+            SCOPE_FAIL{
+                Yupei::destroy_n(last, n);
+            };
+            std::rotate(storage_ + offset, last, last + n);
+        }
+
+        //来源是连续内存且元素 trivially copyable 时可以直接 memcpy。
+        template<typename IteratorT>
+        using CanMemcpyFrom = std::integral_constant<bool, is_contiguous_iterator<IteratorT>::value
+            && std::is_trivially_copyable<value_type>::value
+            && std::is_same<std::remove_cv_t<iterator_value_type_t<IteratorT>>, value_type>::value>;
+
+        template<typename ForwardItT>
+        static void CopyN(ForwardItT first, size_type n, pointer dest, std::true_type) noexcept
+        {
+            std::memcpy(static_cast<void*>(dest), static_cast<const void*>(Yupei::pointer_from(first)), n * sizeof(value_type));
+        }
+
+        template<typename ForwardItT>
+        static void CopyN(ForwardItT first, size_type n, pointer dest, std::false_type)
+        {
+            size_type i {};
+            SCOPE_FAIL{
+                Yupei::destroy_n(dest, i);
+            };
+            for (; i < n; ++i, ++first)
+                Yupei::construct(dest + i, *first);
+        }
+
+        static void FillN(pointer dest, size_type n, const value_type& value)
+        {
+            size_type i {};
+            SCOPE_FAIL{
+                Yupei::destroy_n(dest, i);
+            };
+            for (; i < n; ++i)
+                Yupei::construct(dest + i, value);
+        }
+
+        //把 [0, offset) 与 [offset, size_) 分别搬到 newStorage 与 newStorage + offset + gap。
+        void RelocateAround(pointer newStorage, size_type offset, size_type gap)
+        {
+            RelocateAround(newStorage, offset, gap, is_trivially_relocatable<value_type>());
+        }
+
+        void RelocateAround(pointer newStorage, size_type offset, size_type gap, std::true_type) noexcept
+        {
+            Yupei::relocate_n(storage_, offset, newStorage);
+            Yupei::relocate_n(storage_ + offset, size_ - offset, newStorage + offset + gap);
+        }
+
+        //两段都在新空间里构造成功之后才析构旧元素，任何一步抛出异常时原容器保持不变。
+        void RelocateAround(pointer newStorage, size_type offset, size_type gap, std::false_type)
+        {
+            Yupei::uninitialized_move_if_noexcept_n(storage_, offset, newStorage);
+            SCOPE_FAIL{
+                Yupei::destroy_n(newStorage, offset);
+            };
+            Yupei::uninitialized_move_if_noexcept_n(storage_ + offset, size_ - offset, newStorage + offset + gap);
+            Yupei::destroy_n(storage_, size_);
+        }
+
+        //按字节把尾部整体后移一格，在空出的位置上构造新元素；构造失败时再移回去。
+        template<typename... ParamsT>
+        void InsertGap(size_type offset, std::true_type, ParamsT&&... params)
+        {
+            value_type value(std::forward<ParamsT>(params)...);
+            const auto gap = storage_ + offset;
+            const auto tailBytes = (size_ - offset) * sizeof(value_type);
+            std::memmove(static_cast<void*>(gap + 1), static_cast<const void*>(gap), tailBytes);
+            SCOPE_FAIL{
+                std::memmove(static_cast<void*>(gap), static_cast<const void*>(gap + 1), tailBytes);
+            };
+            Yupei::construct(gap, std::move(value));
+        }
+
+        //把最后一个元素移动构造到未初始化区，其余向后移动赋值，再把新值赋进空位。
+        template<typename... ParamsT>
+        void InsertGap(size_type offset, std::false_type, ParamsT&&... params)
+        {
+            value_type value(std::forward<ParamsT>(params)...);
+            const auto last = storage_ + size_;
+            Yupei::construct(last, std::move(last[-1]));
+            SCOPE_FAIL{
+                Yupei::destroy_at(last);
+            };
+            std::move_backward(storage_ + offset, last - 1, last);
+            storage_[offset] = std::move(value);
+        }
+
+        //析构被删除的元素后按字节把尾部前移。
+        void EraseGap(pointer first, size_type n, std::true_type) noexcept
+        {
+            Yupei::destroy_n(first, n);
+            std::memmove(static_cast<void*>(first), static_cast<const void*>(first + n), (storage_ + size_ - first - n) * sizeof(value_type));
+        }
+
+        void EraseGap(pointer first, size_type n, std::false_type)
+        {
+            const auto last = storage_ + size_;
+            std::move(first + n, last, first);
+            Yupei::destroy_n(last - n, n);
         }
 
         iterator MakeIterator(pointer p) noexcept
@@ -637,14 +921,17 @@ namespace Yupei
             if (newCapacity < oldSize)
                 throw std::bad_array_new_length();
             if (newCapacity <= capacity()) return;
-            Reserve(newCapacity);
+            Reserve(CalcNewSize(newCapacity));
         }
 
-        void Reserve(size_type newCapacity)
+        //分配恰好 elementsToAlloc 个元素的空间，旧元素搬到新空间（trivially relocatable 时直接 memcpy），随后释放旧空间。
+        void Reserve(size_type elementsToAlloc)
         {
-            const auto elementsToAlloc = CalcNewSize(newCapacity);
             const auto newStorage = allocator_.allocate(elementsToAlloc);
-            std::move(storage_, storage_ + size_, newStorage);
+            SCOPE_FAIL{
+                allocator_.deallocate(newStorage, elementsToAlloc);
+            };
+            Yupei::relocate_n(storage_, size_, newStorage);
             allocator_.deallocate(storage_, capacity_);
             capacity_ = elementsToAlloc;
             storage_ = newStorage;
@@ -652,14 +939,7 @@ namespace Yupei
 
         size_type CalcNewSize(size_type newCapacity) const noexcept
         {
-            const auto oldCapacity = capacity_;
-            auto elementsToAlloc = oldCapacity + 1;
-            elementsToAlloc += (elementsToAlloc >> 1);
-            elementsToAlloc = (elementsToAlloc + 0x0Fu) & (size_type)-0x10;
-
-            if (elementsToAlloc < newCapacity) elementsToAlloc = newCapacity;
-
-            return elementsToAlloc;
+            return growth_policy::grow(capacity_, newCapacity, sizeof(value_type));
         }
 
         template<typename... ParamsT>
@@ -677,36 +957,36 @@ namespace Yupei
 
     namespace Internal
     {
-        template<typename T>
-        auto vector_iterator<T>::operator += (typename vector_iterator<T>::difference_type n) noexcept
-            -> vector_iterator<T>&
+        template<typename T, typename ContainerT>
+        auto vector_iterator<T, ContainerT>::operator += (typename vector_iterator<T, ContainerT>::difference_type n) noexcept
+            -> vector_iterator<T, ContainerT>&
         {
             current_ += n;
             assert(*this <= container_->end());
             return *this;
         }
 
-        template<typename T>
-        auto vector_iterator<T>::operator -= (typename vector_iterator<T>::difference_type n) noexcept
-            -> vector_iterator<T>&
+        template<typename T, typename ContainerT>
+        auto vector_iterator<T, ContainerT>::operator -= (typename vector_iterator<T, ContainerT>::difference_type n) noexcept
+            -> vector_iterator<T, ContainerT>&
         {
             current_ -= n;
             assert(*this >= container_->begin());
             return *this;
         }
 
-        template<typename T>
-        auto vector_const_iterator<T>::operator += (typename vector_const_iterator<T>::difference_type n) noexcept
-            -> vector_const_iterator<T>&
+        template<typename T, typename ContainerT>
+        auto vector_const_iterator<T, ContainerT>::operator += (typename vector_const_iterator<T, ContainerT>::difference_type n) noexcept
+            -> vector_const_iterator<T, ContainerT>&
         {
             current_ += n;
             assert(*this <= container_->end());
             return *this;
         }
 
-        template<typename T>
-        auto vector_const_iterator<T>::operator -= (typename vector_const_iterator<T>::difference_type n) noexcept
-            -> vector_const_iterator<T>&
+        template<typename T, typename ContainerT>
+        auto vector_const_iterator<T, ContainerT>::operator -= (typename vector_const_iterator<T, ContainerT>::difference_type n) noexcept
+            -> vector_const_iterator<T, ContainerT>&
         {
             current_ -= n;
             assert(*this >= container_->begin());
@@ -7,6 +7,8 @@
 #include "fnv64.hpp"
 #include <utility>
 #include <cstdint>
+#include <string>
+#include <string_view>
 
 namespace Yupei
 {
@@ -94,6 +96,19 @@ namespace Yupei
         Internal::HashBytes(hashCode, 0);
     }
 
+    //basic_string 与 basic_string_view 的哈希值相同，以便 transparent hasher 使用。
+    template<typename HashCode, typename CharT, typename TraitsT>
+    inline void hash_value(HashCode& hashCode, std::basic_string_view<CharT, TraitsT> str)
+    {
+        hash_combine_range(hashCode, str.data(), str.data() + str.size());
+    }
+
+    template<typename HashCode, typename CharT, typename TraitsT, typename AllocatorT>
+    inline void hash_value(HashCode& hashCode, const std::basic_string<CharT, TraitsT, AllocatorT>& str)
+    {
+        hash_combine_range(hashCode, str.data(), str.data() + str.size());
+    }
+
     template <typename HashCode, typename T, typename... Ts>
     inline void hash_combine(HashCode& hashCode, const T& v, const Ts&... ts) noexcept
     {
@@ -25,6 +25,17 @@ namespace Yupei
             static std::size_t GetPrime(std::size_t min) noexcept;
             static std::size_t ExpandPrime(std::size_t oldSize) noexcept;
         };
+
+        //MurmurHash3 的 fmix64：让输入的每一位都影响输出的每一位。
+        constexpr std::uint64_t MixHash(std::uint64_t k) noexcept
+        {
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdull;
+            k ^= k >> 33;
+            k *= 0xc4ceb9fe1a85ec53ull;
+            k ^= k >> 33;
+            return k;
+        }
     }
 
 }
\ No newline at end of file
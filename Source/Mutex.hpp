@@ -1,10 +1,17 @@
 #pragma once
 
 #include <mutex>
+#include <shared_mutex>
 
 namespace Yupei
 {
 	using std::mutex;
 
 	using std::lock_guard;
+
+	using std::shared_mutex;
+
+	using std::shared_lock;
+
+	using std::unique_lock;
 }
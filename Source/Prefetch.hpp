@@ -0,0 +1,22 @@
+﻿#pragma once
+
+#include "Config.hpp"
+
+#if defined(YPMSVC) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#endif
+
+namespace Yupei
+{
+    //提示 CPU 将 p 所在的 cache line 提前读入 L1，不会产生任何可见的副作用。
+    inline void prefetch(const void* p) noexcept
+    {
+#if defined(YPMSVC) && (defined(_M_IX86) || defined(_M_X64))
+        _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(p);
+#else
+        (void)p;
+#endif
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef INSTRUMENTED_H
+#define INSTRUMENTED_H
+
+#include <MemoryResource/MemoryResource.hpp>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+// Counts allocations made through it; live is the number not yet released.
+class CountingResource : public Yupei::memory_resource
+{
+public:
+    std::size_t allocations = 0;
+    std::size_t live = 0;
+
+protected:
+    void* do_allocate(size_type bytes, size_type alignment) override
+    {
+        ++allocations;
+        ++live;
+        return Yupei::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    // vector releases its null storage through the resource as well.
+    void do_deallocate(void* p, size_type bytes, size_type alignment) noexcept override
+    {
+        if (!p) return;
+        --live;
+        Yupei::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// A template so that the counters can be defined in this header.
+template<typename = void>
+struct ThrowingCopyCounters
+{
+    static int live;
+    static int copiesLeft;
+};
+
+template<typename T>
+int ThrowingCopyCounters<T>::live = 0;
+
+template<typename T>
+int ThrowingCopyCounters<T>::copiesLeft = 1000;
+
+// Move may throw, so reallocation copies; every copy throws once copiesLeft runs out.
+struct ThrowingCopy : ThrowingCopyCounters<>
+{
+    std::string value;
+
+    ThrowingCopy(const char* s) : value(s) { ++live; }
+    ThrowingCopy(const ThrowingCopy& other) : value(other.value)
+    {
+        if (copiesLeft-- <= 0)
+            throw std::runtime_error("copy");
+        ++live;
+    }
+    ThrowingCopy(ThrowingCopy&& other) : ThrowingCopy(static_cast<const ThrowingCopy&>(other)) {}
+    ThrowingCopy& operator=(const ThrowingCopy&) = default;
+    ~ThrowingCopy() { --live; }
+};
+
+#endif  // INSTRUMENTED_H
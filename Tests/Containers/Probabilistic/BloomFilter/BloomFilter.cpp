@@ -0,0 +1,121 @@
+// <Containers/BloomFilter.hpp>
+
+#include <Containers/BloomFilter.hpp>
+#include <catch.hpp>
+#include <string>
+#include <vector>
+#include <iterator>
+#include <stdexcept>
+#include <cstdint>
+#include <new>
+
+TEST_CASE("BloomFilter")
+{
+	using namespace Yupei;
+
+	SECTION("no false negatives")
+	{
+		blocked_bloom_filter<int> filter { 16 };
+		CHECK(filter.block_count() == 16);
+		CHECK(filter.size_in_bytes() == 16 * 64);
+		CHECK(!filter.contains(1));
+		for (int i = 0; i < 500; ++i)
+			filter.insert(i);
+		for (int i = 0; i < 500; ++i)
+			CHECK(filter.contains(i));
+		filter.clear();
+		CHECK(!filter.contains(1));
+	}
+
+	SECTION("false positive rate")
+	{
+		const std::size_t n = 20000;
+		const auto blocks = blocked_bloom_filter<std::string>::blocks_for(n, 0.01);
+		CHECK(blocked_bloom_filter<std::string>::estimate_false_positive_rate(n, blocks) <= 0.01);
+		CHECK(blocked_bloom_filter<std::string>::estimate_false_positive_rate(n, blocks - 1) > 0.01);
+
+		blocked_bloom_filter<std::string> filter { blocks };
+		std::vector<std::string> keys;
+		for (std::size_t i = 0; i < n; ++i)
+			keys.push_back("key" + std::to_string(i));
+		filter.insert(keys.begin(), keys.end());
+
+		std::vector<std::string> others;
+		for (std::size_t i = 0; i < n; ++i)
+			others.push_back("other" + std::to_string(i));
+		std::vector<bool> found;
+		filter.contains_batch(keys.begin(), keys.end(), std::back_inserter(found));
+		CHECK(found == std::vector<bool>(n, true));
+
+		found.clear();
+		filter.contains_batch(others.begin(), others.end(), std::back_inserter(found));
+		std::size_t falsePositives = 0;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			CHECK(found[i] == filter.contains(others[i]));
+			if (found[i]) ++falsePositives;
+		}
+		CHECK(falsePositives < n * 2 / 100);
+
+		CHECK_THROWS_AS(blocked_bloom_filter<int>::blocks_for(10, 0.), std::invalid_argument);
+		CHECK_THROWS_AS(blocked_bloom_filter<int>::blocks_for(10, 1.), std::invalid_argument);
+	}
+
+	SECTION("serialize")
+	{
+		blocked_bloom_filter<int> filter { 4 };
+		for (int i = 0; i < 100; i += 2)
+			filter.insert(i);
+		std::vector<unsigned char> bytes;
+		filter.serialize(std::back_inserter(bytes));
+		CHECK(bytes.size() == filter.serialized_size());
+
+		auto copy = blocked_bloom_filter<int>::deserialize(bytes.begin(), bytes.end());
+		CHECK(copy.block_count() == 4);
+		for (int i = 0; i < 100; ++i)
+			CHECK(copy.contains(i) == filter.contains(i));
+
+		auto truncated = bytes;
+		truncated.pop_back();
+		CHECK_THROWS_AS(blocked_bloom_filter<int>::deserialize(truncated.begin(), truncated.end()), std::invalid_argument);
+		auto corrupted = bytes;
+		corrupted[0] ^= 1;
+		CHECK_THROWS_AS(blocked_bloom_filter<int>::deserialize(corrupted.begin(), corrupted.end()), std::invalid_argument);
+		bytes.push_back(0);
+		CHECK_THROWS_AS(blocked_bloom_filter<int>::deserialize(bytes.begin(), bytes.end()), std::invalid_argument);
+
+		//block count in bytes 8..15, little endian
+		auto huge = bytes;
+		const auto maxBlocks = static_cast<std::uint64_t>(static_cast<std::size_t>(-1) / blocked_bloom_filter<int>::kBlockBytes);
+		for (std::size_t i = 0; i < 8; ++i)
+			huge[8 + i] = static_cast<unsigned char>(maxBlocks >> (8 * i));
+		CHECK_THROWS_AS(blocked_bloom_filter<int>::deserialize(huge.begin(), huge.end()), std::invalid_argument);
+
+		CHECK_THROWS_AS(blocked_bloom_filter<int>(static_cast<std::size_t>(-1) / blocked_bloom_filter<int>::kBlockBytes), std::bad_array_new_length);
+	}
+
+	SECTION("copy, move and union")
+	{
+		blocked_bloom_filter<int> a { 8 }, b { 8 };
+		for (int i = 0; i < 50; ++i)
+		{
+			a.insert(i);
+			b.insert(i + 1000);
+		}
+		auto c = a;
+		c.union_with(b);
+		for (int i = 0; i < 50; ++i)
+		{
+			CHECK(c.contains(i));
+			CHECK(c.contains(i + 1000));
+		}
+		auto d = std::move(c);
+		CHECK(d.contains(1000));
+		CHECK(!c.contains(1000));
+		c = a;
+		CHECK(c.contains(0));
+
+		blocked_bloom_filter<int> e { 4 };
+		CHECK_THROWS_AS(e.union_with(a), std::invalid_argument);
+	}
+}
@@ -0,0 +1,75 @@
+// <Containers/CountMinSketch.hpp>
+
+#include <Containers/CountMinSketch.hpp>
+#include <catch.hpp>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+TEST_CASE("CountMinSketch")
+{
+	using namespace Yupei;
+
+	SECTION("dimensions")
+	{
+		CHECK(count_min_sketch<int>::width_for(0.01) == 272);
+		CHECK(count_min_sketch<int>::depth_for(0.01) == 5);
+		CHECK_THROWS_AS(count_min_sketch<int>::width_for(0.), std::invalid_argument);
+		CHECK_THROWS_AS(count_min_sketch<int>::depth_for(1.), std::invalid_argument);
+		CHECK_THROWS_AS((count_min_sketch<int>{ 0, 1 }), std::invalid_argument);
+	}
+
+	SECTION("estimates")
+	{
+		count_min_sketch<int> sketch { count_min_sketch<int>::width_for(0.001), count_min_sketch<int>::depth_for(0.001) };
+		CHECK(sketch.estimate(1) == 0);
+		for (int i = 0; i < 10000; ++i)
+			sketch.add(i % 1000);
+		for (int i = 0; i < 5000; ++i)
+			sketch.add(-1);
+		sketch.add(-2, 300);
+		CHECK(sketch.total() == 15300);
+
+		CHECK(sketch.estimate(-1) >= 5000);
+		CHECK(sketch.estimate(-1) <= 5000 + 15);
+		CHECK(sketch.estimate(-2) >= 300);
+		for (int i = 0; i < 1000; ++i)
+		{
+			CHECK(sketch.estimate(i) >= 10);
+			CHECK(sketch.estimate(i) <= 10 + 15);
+		}
+
+		sketch.clear();
+		CHECK(sketch.estimate(-1) == 0);
+		CHECK(sketch.total() == 0);
+	}
+
+	SECTION("saturation")
+	{
+		count_min_sketch<int, hash<>, std::uint8_t> sketch { 16, 2 };
+		sketch.add(1, 200);
+		sketch.add(1, 200);
+		CHECK(sketch.estimate(1) == 255);
+	}
+
+	SECTION("merge")
+	{
+		count_min_sketch<std::string> a { 512, 4 }, b { 512, 4 };
+		for (int i = 0; i < 100; ++i)
+		{
+			a.add("x");
+			b.add("x", 2);
+			b.add(std::to_string(i));
+		}
+		auto merged = a;
+		merged.merge(b);
+		CHECK(merged.estimate("x") >= 300);
+		CHECK(merged.total() == a.total() + b.total());
+
+		count_min_sketch<std::string> other { 256, 4 };
+		CHECK_THROWS_AS(other.merge(a), std::invalid_argument);
+
+		auto moved = std::move(merged);
+		CHECK(moved.estimate("x") >= 300);
+	}
+}
@@ -0,0 +1,82 @@
+// <Containers/HyperLogLog.hpp>
+
+#include <Containers/HyperLogLog.hpp>
+#include <catch.hpp>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+
+TEST_CASE("HyperLogLog")
+{
+	using namespace Yupei;
+
+	SECTION("precision")
+	{
+		CHECK_THROWS_AS(hyperloglog<int>{ 3 }, std::invalid_argument);
+		CHECK_THROWS_AS(hyperloglog<int>{ 19 }, std::invalid_argument);
+		hyperloglog<int> hll { 10 };
+		CHECK(hll.precision() == 10);
+		CHECK(hll.register_count() == 1024);
+		CHECK(hll.estimate() == 0.);
+	}
+
+	SECTION("sparse and dense estimates")
+	{
+		hyperloglog<int> hll;
+		CHECK(hll.is_sparse());
+		for (int i = 0; i < 100; ++i)
+		{
+			hll.insert(i);
+			hll.insert(i);
+		}
+		CHECK(hll.is_sparse());
+		CHECK(std::abs(hll.estimate() - 100.) < 3.);
+
+		for (int i = 100; i < 200000; ++i)
+			hll.insert(i);
+		CHECK(!hll.is_sparse());
+		const auto error = 4 * hyperloglog<int>::relative_error(hll.precision());
+		CHECK(std::abs(hll.estimate() / 200000. - 1.) < error);
+
+		hll.clear();
+		CHECK(hll.is_sparse());
+		CHECK(hll.estimate() == 0.);
+	}
+
+	SECTION("merge")
+	{
+		hyperloglog<std::string> a { 12 }, b { 12 }, all { 12 };
+		for (int i = 0; i < 50000; ++i)
+		{
+			const auto key = std::to_string(i);
+			(i % 3 == 0 ? a : b).insert(key);
+			all.insert(key);
+		}
+		auto merged = a;
+		merged.merge(b);
+		CHECK(merged.estimate() == all.estimate());
+
+		hyperloglog<std::string> small { 12 };
+		small.insert("1");
+		small.insert("extra");
+		CHECK(small.is_sparse());
+		auto merged2 = merged;
+		merged2.merge(small);
+		all.insert("extra");
+		CHECK(merged2.estimate() == all.estimate());
+
+		auto sparse = small;
+		sparse.merge(small);
+		CHECK(sparse.estimate() == small.estimate());
+		sparse.merge(merged);
+		CHECK(!sparse.is_sparse());
+		CHECK(sparse.estimate() == all.estimate());
+
+		hyperloglog<std::string> other { 10 };
+		CHECK_THROWS_AS(other.merge(a), std::invalid_argument);
+
+		const auto estimate = merged.estimate();
+		auto moved = std::move(merged);
+		CHECK(moved.estimate() == estimate);
+	}
+}
@@ -0,0 +1,201 @@
+// <Containers/BitVector.hpp>
+
+#include <Containers/BitVector.hpp>
+#include <Bits.hpp>
+#include <MemoryResource/MemoryResource.hpp>
+#include <catch.hpp>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	Yupei::bit_vector MakeRandom(std::size_t n, std::uint32_t seed, int percent)
+	{
+		std::mt19937 engine { seed };
+		Yupei::bit_vector bits(n);
+		for (std::size_t i = 0; i < n; ++i)
+			if (static_cast<int>(engine() % 100) < percent)
+				bits.set(i);
+		return bits;
+	}
+}
+
+TEST_CASE("BitVector")
+{
+	using Yupei::bit_vector;
+
+	SECTION("bit helpers")
+	{
+		CHECK(Yupei::popcount(0) == 0);
+		CHECK(Yupei::popcount(0xFFFFFFFFFFFFFFFFu) == 64);
+		CHECK(Yupei::popcount(0x8000000000000001u) == 2);
+		CHECK(Yupei::countr_zero(0) == 64);
+		CHECK(Yupei::countr_zero(8) == 3);
+		CHECK(Yupei::countr_zero(0x8000000000000000u) == 63);
+		CHECK(Yupei::select_bit(0xA5, 0) == 0);
+		CHECK(Yupei::select_bit(0xA5, 1) == 2);
+		CHECK(Yupei::select_bit(0xA5, 3) == 7);
+		CHECK(Yupei::select_bit(0x8000000000000000u, 0) == 63);
+	}
+
+	SECTION("single bits")
+	{
+		bit_vector bits(130);
+		CHECK(bits.size() == 130);
+		CHECK(bits.word_count() == 3);
+		CHECK(bits.none());
+		bits.set(0);
+		bits.set(64);
+		bits.set(129);
+		CHECK(bits[0]);
+		CHECK(bits[64]);
+		CHECK(bits[129]);
+		CHECK(!bits[1]);
+		CHECK(bits.count() == 3);
+		bits.reset(64);
+		CHECK(!bits[64]);
+		bits.flip(65);
+		CHECK(bits[65]);
+		bits.set(65, false);
+		CHECK(!bits[65]);
+		CHECK(!bits.test_and_set(100));
+		CHECK(bits.test_and_set(100));
+		CHECK(bits.count() == 3);
+		CHECK_THROWS_AS(bits.test(130), std::out_of_range);
+		bits.flip();
+		CHECK(bits.count() == 127);
+		bits.fill(true);
+		CHECK(bits.count() == 130);
+		bits.fill(false);
+		CHECK(bits.none());
+	}
+
+	SECTION("push_back and resize")
+	{
+		bit_vector bits;
+		std::vector<bool> expected;
+		for (int i = 0; i < 1000; ++i)
+		{
+			const bool value = i % 3 == 0;
+			bits.push_back(value);
+			expected.push_back(value);
+		}
+		CHECK(bits.size() == 1000);
+		bool same = true;
+		for (std::size_t i = 0; i < expected.size(); ++i)
+			same = same && bits[i] == expected[i];
+		CHECK(same);
+		CHECK(bits.count() == 334);
+		bits.resize(10);
+		CHECK(bits.count() == 4);
+		bits.resize(200, true);
+		CHECK(bits.count() == 194);
+		CHECK(bits[10]);
+		CHECK(bits[199]);
+		bits.resize(70);
+		bits.resize(300);
+		CHECK(bits.count() == 64);
+		bits.pop_back();
+		CHECK(bits.size() == 299);
+		bits.clear();
+		CHECK(bits.empty());
+		bits.push_back(true);
+		CHECK(bits.count() == 1);
+		bits.shrink_to_fit();
+		CHECK(bits.capacity() == 64);
+	}
+
+	SECTION("find")
+	{
+		bit_vector bits(300);
+		CHECK(bits.find_first() == bit_vector::npos);
+		bits.set(5);
+		bits.set(63);
+		bits.set(64);
+		bits.set(299);
+		CHECK(bits.find_first() == 5);
+		CHECK(bits.find_next(5) == 63);
+		CHECK(bits.find_next(63) == 64);
+		CHECK(bits.find_next(64) == 299);
+		CHECK(bits.find_next(299) == bit_vector::npos);
+		bit_vector b(70);
+		b.set(1);
+		CHECK(b.find_next(1) == bit_vector::npos);
+		CHECK(bit_vector().find_first() == bit_vector::npos);
+	}
+
+	SECTION("bulk operations")
+	{
+		const auto a = MakeRandom(1000, 1, 50);
+		const auto b = MakeRandom(1000, 2, 50);
+		const auto andBits = a & b;
+		const auto orBits = a | b;
+		const auto xorBits = a ^ b;
+		auto andNotBits = a;
+		andNotBits.and_not(b);
+		bool same = true;
+		for (std::size_t i = 0; i < 1000; ++i)
+		{
+			same = same && andBits[i] == (a[i] && b[i]);
+			same = same && orBits[i] == (a[i] || b[i]);
+			same = same && xorBits[i] == (a[i] != b[i]);
+			same = same && andNotBits[i] == (a[i] && !b[i]);
+		}
+		CHECK(same);
+		CHECK(andBits.count() + orBits.count() == a.count() + b.count());
+		CHECK(xorBits.count() == orBits.count() - andBits.count());
+		auto c = a;
+		CHECK(c == a);
+		c ^= a;
+		CHECK(c.none());
+		CHECK(c != a);
+		bit_vector shorter(999);
+		CHECK_THROWS_AS(c &= shorter, std::invalid_argument);
+	}
+
+	SECTION("rank and select")
+	{
+		for (int percent : { 0, 1, 50, 99, 100 })
+		{
+			const auto bits = MakeRandom(5000, 3, percent);
+			const Yupei::bit_rank_select index { bits };
+			std::size_t ones = 0;
+			bool rankOk = true, select1Ok = true, select0Ok = true;
+			for (std::size_t i = 0; i < bits.size(); ++i)
+			{
+				rankOk = rankOk && index.rank1(i) == ones && index.rank0(i) == i - ones;
+				if (bits[i])
+				{
+					select1Ok = select1Ok && index.select1(ones) == i;
+					++ones;
+				}
+				else
+					select0Ok = select0Ok && index.select0(i - ones) == i;
+			}
+			CHECK(rankOk);
+			CHECK(select1Ok);
+			CHECK(select0Ok);
+			CHECK(index.rank1(bits.size()) == ones);
+			CHECK(index.ones() == ones);
+			CHECK_THROWS_AS(index.select1(ones), std::out_of_range);
+			CHECK_THROWS_AS(index.select0(bits.size() - ones), std::out_of_range);
+		}
+		const bit_vector empty;
+		const Yupei::bit_rank_select index { empty };
+		CHECK(index.rank1(0) == 0);
+		CHECK(index.ones() == 0);
+	}
+
+	SECTION("memory resource")
+	{
+		Yupei::monotonic_buffer_resource arena { Yupei::memory_resource_ptr {} };
+		bit_vector bits(100, true, Yupei::memory_resource_ptr { &arena });
+		CHECK(bits.count() == 100);
+		CHECK(bits.get_allocator().resource() == Yupei::memory_resource_ptr { &arena });
+		const auto copy = bits;
+		CHECK(copy.get_allocator().resource() == Yupei::memory_resource_ptr { &arena });
+		CHECK(copy == bits);
+	}
+}
@@ -0,0 +1,165 @@
+// <Containers/SegmentedVector.hpp>
+
+#include <Containers/SegmentedVector.hpp>
+#include "../../Instrumented.h"
+#include <MemoryResource/MemoryResource.hpp>
+#include <catch.hpp>
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+
+TEST_CASE("SegmentedVector")
+{
+	using Yupei::segmented_vector;
+
+	SECTION("default block size")
+	{
+		CHECK(segmented_vector<char>::block_size == 4096);
+		CHECK(segmented_vector<int>::block_size == 1024);
+		CHECK(segmented_vector<std::string>::block_size * sizeof(std::string) <= 4096);
+		struct Huge { char bytes[1000]; };
+		CHECK(segmented_vector<Huge>::block_size == 16);
+	}
+
+	SECTION("push_back keeps addresses")
+	{
+		segmented_vector<int, 8> v;
+		std::vector<const int*> addresses;
+		for (int i = 0; i < 1000; ++i)
+		{
+			v.push_back(i);
+			addresses.push_back(&v.back());
+		}
+		CHECK(v.size() == 1000);
+		CHECK(v.block_count() == 125);
+		for (int i = 0; i < 1000; ++i)
+		{
+			CHECK(addresses[i] == &v[i]);
+			CHECK(*addresses[i] == i);
+		}
+		CHECK_THROWS_AS(v.at(1000), std::out_of_range);
+	}
+
+	SECTION("emplace_back aliasing")
+	{
+		segmented_vector<std::string, 4> v;
+		v.emplace_back("a string long enough to live on the heap");
+		for (int i = 0; i < 20; ++i)
+			v.emplace_back(v.front());
+		CHECK(v.size() == 21);
+		CHECK(v.back() == v.front());
+		auto& r = v.emplace_back(v[3], 2, 6);
+		CHECK(r == "string");
+	}
+
+	SECTION("iteration")
+	{
+		segmented_vector<int, 16> v;
+		for (int i = 0; i < 100; ++i)
+			v.push_back(i);
+		CHECK(std::accumulate(v.begin(), v.end(), 0) == 4950);
+		CHECK(v.end() - v.begin() == 100);
+		auto it = std::find(v.cbegin(), v.cend(), 42);
+		CHECK(it - v.cbegin() == 42);
+		CHECK(*(v.begin() + 17) == 17);
+		CHECK(v.begin()[99] == 99);
+		std::reverse(v.begin(), v.end());
+		CHECK(v.front() == 99);
+		CHECK(v.back() == 0);
+		std::sort(v.begin(), v.end());
+		CHECK(v[50] == 50);
+		segmented_vector<int, 16>::const_iterator ci = v.begin();
+		CHECK(ci == v.cbegin());
+	}
+
+	SECTION("blocks")
+	{
+		segmented_vector<int, 32> v;
+		for (int i = 0; i < 70; ++i)
+			v.push_back(i);
+		CHECK(v.block_count() == 3);
+		CHECK(v.block_length(0) == 32);
+		CHECK(v.block_length(2) == 6);
+		CHECK(v.block_data(1)[0] == 32);
+		std::size_t blocks = 0;
+		long long sum = 0;
+		v.for_each_block([&](int* p, std::size_t n) {
+			++blocks;
+			for (std::size_t i = 0; i < n; ++i)
+				sum += p[i];
+		});
+		CHECK(blocks == 3);
+		CHECK(sum == 2415);
+		const auto& cv = v;
+		std::size_t total = 0;
+		cv.for_each_block([&](const int*, std::size_t n) { total += n; });
+		CHECK(total == 70);
+	}
+
+	SECTION("resize and clear")
+	{
+		CountingResource resource;
+		{
+			segmented_vector<std::string, 8> v { Yupei::memory_resource_ptr { &resource } };
+			v.resize(20, "x");
+			CHECK(v.size() == 20);
+			CHECK(v[19] == "x");
+			CHECK(v.capacity() == 24);
+			v.resize(5);
+			CHECK(v.size() == 5);
+			CHECK(v.capacity() == 24);
+			const auto allocations = resource.allocations;
+			v.shrink_to_fit();
+			CHECK(v.capacity() == 8);
+			//one block left, and the block index is reallocated to hold just that one
+			CHECK(resource.allocations == allocations + 1);
+			CHECK(resource.live == 2);
+			CHECK(v[4] == "x");
+			v.shrink_to_fit();
+			CHECK(resource.allocations == allocations + 1);
+			v.reserve(30);
+			CHECK(v.capacity() == 32);
+			v.clear();
+			CHECK(v.empty());
+			CHECK(v.capacity() == 32);
+			v.push_back("again");
+			CHECK(v.front() == "again");
+			v.pop_back();
+			v.shrink_to_fit();
+			CHECK(v.capacity() == 0);
+			CHECK(resource.live == 0);
+			v.resize(3);
+			CHECK(v[2].empty());
+		}
+		CHECK(resource.live == 0);
+	}
+
+	SECTION("copy and move")
+	{
+		CountingResource resource;
+		{
+			segmented_vector<std::string, 4> a { Yupei::memory_resource_ptr { &resource } };
+			for (int i = 0; i < 10; ++i)
+				a.push_back(std::to_string(i));
+			segmented_vector<std::string, 4> b = a;
+			CHECK(b.size() == 10);
+			CHECK(b[9] == "9");
+			CHECK(b.get_allocator().resource() == a.get_allocator().resource());
+			const auto p = &a[5];
+			segmented_vector<std::string, 4> c = std::move(a);
+			CHECK(a.empty());
+			CHECK(&c[5] == p);
+			a = c;
+			CHECK(a.size() == 10);
+			c = std::move(b);
+			CHECK(c[0] == "0");
+			swap(a, c);
+			CHECK(a[3] == "3");
+			segmented_vector<int> il { 1, 2, 3 };
+			CHECK(il.size() == 3);
+			CHECK(il[2] == 3);
+		}
+		CHECK(resource.live == 0);
+	}
+}
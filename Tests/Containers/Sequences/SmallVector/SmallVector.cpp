@@ -0,0 +1,216 @@
+// <Containers/SmallVector.hpp>
+
+#include <Containers/SmallVector.hpp>
+#include "../../Instrumented.h"
+#include <MemoryResource/MemoryResource.hpp>
+#include <MoveOnly.h>
+#include <catch.hpp>
+#include <string>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
+
+TEST_CASE("SmallVector")
+{
+	using namespace Yupei;
+
+	SECTION("inline storage")
+	{
+		CountingResource resource;
+		{
+			small_vector<std::string, 4> v { memory_resource_ptr{ &resource } };
+			CHECK(v.empty());
+			CHECK(v.is_inline());
+			CHECK(v.capacity() == 4);
+			for (int i = 0; i < 4; ++i)
+				v.push_back(std::to_string(i));
+			CHECK(v.size() == 4);
+			CHECK(v.is_inline());
+			CHECK(resource.allocations == 0);
+			CHECK(v.front() == "0");
+			CHECK(v.back() == "3");
+
+			v.push_back(v[0]);
+			CHECK(!v.is_inline());
+			CHECK(resource.allocations == 1);
+			CHECK(v.size() == 5);
+			for (int i = 0; i < 4; ++i)
+				CHECK(v[i] == std::to_string(i));
+			CHECK(v[4] == "0");
+			CHECK_THROWS_AS(v.at(5), std::out_of_range);
+
+			v.clear();
+			CHECK(v.empty());
+			CHECK(!v.is_inline());
+		}
+		CHECK(resource.live == 0);
+	}
+
+	SECTION("insert and erase")
+	{
+		small_vector<int, 8> v { 0, 1, 2, 3, 4 };
+		auto it = v.insert(v.cbegin() + 2, 10);
+		CHECK(*it == 10);
+		CHECK((v == small_vector<int, 8>{ 0, 1, 10, 2, 3, 4 }));
+		v.insert(v.cend(), 5);
+		v.insert(v.cbegin(), v[5]);
+		CHECK((v == small_vector<int, 8>{ 4, 0, 1, 10, 2, 3, 4, 5 }));
+		CHECK(v.is_inline());
+		v.insert(v.cbegin() + 1, v.back());
+		CHECK(!v.is_inline());
+		CHECK((v == small_vector<int, 8>{ 4, 5, 0, 1, 10, 2, 3, 4, 5 }));
+
+		it = v.erase(v.cbegin() + 1, v.cbegin() + 3);
+		CHECK(*it == 1);
+		CHECK((v == small_vector<int, 8>{ 4, 1, 10, 2, 3, 4, 5 }));
+		it = v.erase(v.cend() - 1);
+		CHECK(it == v.end());
+		v.erase(v.cbegin(), v.cbegin());
+		CHECK(v.size() == 6);
+
+		v.emplace(v.cbegin() + 3, 7);
+		CHECK(v[3] == 7);
+		CHECK(v.emplace_back(8) == 8);
+		v.pop_back(2);
+		CHECK((v == small_vector<int, 8>{ 4, 1, 10, 7, 2, 3 }));
+	}
+
+	SECTION("resize and append")
+	{
+		small_vector<int, 4> v(3, 7);
+		CHECK(v.size() == 3);
+		v.resize(6);
+		CHECK((v == small_vector<int, 4>{ 7, 7, 7, 0, 0, 0 }));
+		v.resize(2);
+		CHECK((v == small_vector<int, 4>{ 7, 7 }));
+		v.resize(5, 1);
+		CHECK((v == small_vector<int, 4>{ 7, 7, 1, 1, 1 }));
+
+		std::istringstream input { "4 5 6" };
+		small_vector<int, 4> w;
+		w.append(std::istream_iterator<int>{ input }, std::istream_iterator<int>{});
+		const int more[] = { 7, 8 };
+		w.append(std::begin(more), std::end(more));
+		CHECK((w == small_vector<int, 4>{ 4, 5, 6, 7, 8 }));
+		w.reserve(100);
+		CHECK(w.capacity() >= 100);
+		CHECK((w == small_vector<int, 4>{ 4, 5, 6, 7, 8 }));
+
+		small_vector<std::string, 2> s { "first", "second" };
+		s.resize(100, s[0]);
+		CHECK(s.size() == 100);
+		CHECK(s[1] == "second");
+		CHECK(s[2] == "first");
+		CHECK(s[99] == "first");
+
+		small_vector<std::string, 2> self { "a long enough string", "b long enough string", "c long enough string" };
+		REQUIRE(!self.is_inline());
+		REQUIRE(self.capacity() < 6);
+		self.append(self.begin(), self.end());
+		CHECK(self.size() == 6);
+		CHECK(self[3] == "a long enough string");
+		CHECK(self[5] == "c long enough string");
+	}
+
+	SECTION("reallocating insert keeps the vector on exceptions")
+	{
+		{
+			small_vector<ThrowingCopy, 4> v;
+			for (auto s : { "a long enough string", "b long enough string", "c long enough string", "d long enough string" })
+				v.emplace_back(s);
+			REQUIRE(v.size() == v.capacity());
+
+			//new element, the front half and one element of the tail succeed
+			ThrowingCopy::copiesLeft = 4;
+			CHECK_THROWS_AS(v.emplace(v.cbegin() + 2, "x"), std::runtime_error);
+			ThrowingCopy::copiesLeft = 1000;
+			REQUIRE(v.size() == 4);
+			CHECK(v.is_inline());
+			CHECK(v[0].value == "a long enough string");
+			CHECK(v[1].value == "b long enough string");
+			CHECK(v[2].value == "c long enough string");
+			CHECK(v[3].value == "d long enough string");
+			CHECK(ThrowingCopy::live == 4);
+
+			v.emplace(v.cbegin() + 2, "x");
+			CHECK(v.size() == 5);
+			CHECK(v[2].value == "x");
+			CHECK(v[4].value == "d long enough string");
+		}
+		CHECK(ThrowingCopy::live == 0);
+	}
+
+	SECTION("copy, move and swap")
+	{
+		small_vector<std::string, 2> a { "a" };
+		small_vector<std::string, 2> b { "b", "c", "d" };
+		auto c = b;
+		CHECK(c == b);
+
+		auto d = std::move(b);
+		CHECK(b.empty());
+		CHECK(b.is_inline());
+		CHECK((d == small_vector<std::string, 2>{ "b", "c", "d" }));
+
+		auto e = std::move(a);
+		CHECK(e.is_inline());
+		CHECK(a.empty());
+		CHECK(e[0] == "a");
+
+		swap(e, d);
+		CHECK(e.size() == 3);
+		CHECK(d.size() == 1);
+		CHECK(d[0] == "a");
+		swap(c, e);
+		CHECK(c.size() == 3);
+		d.swap(d);
+		CHECK(d.size() == 1);
+
+		c = d;
+		CHECK(c == d);
+		c = { "x", "y", "z" };
+		CHECK(c.size() == 3);
+		c = std::move(d);
+		CHECK(c.size() == 1);
+
+		small_vector<MoveOnly, 2> m;
+		for (int i = 1; i <= 5; ++i)
+			m.push_back(MoveOnly{ i });
+		m.insert(m.cbegin(), MoveOnly{ 9 });
+		auto n = std::move(m);
+		CHECK(n.size() == 6);
+		CHECK(n[0].get() == 9);
+		CHECK(n[5].get() == 5);
+	}
+
+	SECTION("assignment and swap keep each side's resource")
+	{
+		CountingResource left, right;
+		{
+			small_vector<std::string, 2> a({ "a long enough string", "b long enough string", "c long enough string" }, memory_resource_ptr{ &left });
+			small_vector<std::string, 2> b({ "d long enough string", "e long enough string", "f long enough string", "g long enough string" }, memory_resource_ptr{ &right });
+			REQUIRE(!a.is_inline());
+			REQUIRE(!b.is_inline());
+
+			swap(a, b);
+			CHECK(a.size() == 4);
+			CHECK(b.size() == 3);
+			CHECK(a[0] == "d long enough string");
+			CHECK(b[2] == "c long enough string");
+			CHECK(a.get_allocator().resource() == memory_resource_ptr{ &left });
+			CHECK(b.get_allocator().resource() == memory_resource_ptr{ &right });
+
+			a = std::move(b);
+			CHECK(a.size() == 3);
+			CHECK(b.empty());
+			CHECK(a[1] == "b long enough string");
+
+			small_vector<std::string, 2> c({ "x" }, memory_resource_ptr{ &right });
+			c = a;
+			CHECK(c == a);
+			CHECK(!c.is_inline());
+		}
+		CHECK(left.live == 0);
+		CHECK(right.live == 0);
+	}
+}
@@ -0,0 +1,178 @@
+// <Containers/SoaVector.hpp>
+
+#include <Containers/SoaVector.hpp>
+#include "../../Instrumented.h"
+#include <MemoryResource/MemoryResource.hpp>
+#include <catch.hpp>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("SoaVector")
+{
+	using Yupei::soa_vector;
+
+	SECTION("rows")
+	{
+		soa_vector<int, double, std::string> v;
+		CHECK(v.empty());
+		v.push_back(1, 1.5, "one");
+		v.emplace_back(2, 2.5, "two");
+		std::string three = "three";
+		v.push_back(3, 3.5, three);
+		CHECK(v.size() == 3);
+		CHECK(std::get<0>(v[1]) == 2);
+		CHECK(std::get<1>(v[1]) == 2.5);
+		CHECK(std::get<2>(v[2]) == "three");
+		std::get<0>(v[0]) = 10;
+		CHECK(std::get<0>(v.front()) == 10);
+		v[1] = std::make_tuple(20, 20.5, std::string("twenty"));
+		CHECK(std::get<2>(v[1]) == "twenty");
+		auto row = v.back();
+		std::get<1>(row) = 7.0;
+		CHECK(std::get<1>(v[2]) == 7.0);
+		CHECK_THROWS_AS(v.at(3), std::out_of_range);
+		v.pop_back();
+		CHECK(v.size() == 2);
+	}
+
+	SECTION("columns")
+	{
+		soa_vector<std::uint8_t, std::uint64_t, float> v;
+		for (int i = 0; i < 1000; ++i)
+			v.emplace_back(static_cast<std::uint8_t>(i), static_cast<std::uint64_t>(i) * 3, 0.5f);
+		const auto bytes = v.column<0>();
+		const auto quads = v.column<1>();
+		const auto floats = v.column<2>();
+		CHECK(bytes.size() == 1000);
+		CHECK(reinterpret_cast<std::uintptr_t>(bytes.data()) % 64 == 0);
+		CHECK(reinterpret_cast<std::uintptr_t>(quads.data()) % 64 == 0);
+		CHECK(reinterpret_cast<std::uintptr_t>(floats.data()) % 64 == 0);
+		CHECK(std::accumulate(quads.begin(), quads.end(), std::uint64_t {}) == 3 * 999 * 1000 / 2);
+		CHECK(std::accumulate(floats.begin(), floats.end(), 0.0) == 500.0);
+		CHECK(quads[10] == 30);
+		for (auto& f : v.column<2>())
+			f = 2.0f;
+		CHECK(std::get<2>(v[999]) == 2.0f);
+		const auto& cv = v;
+		CHECK(cv.column<0>()[255] == 255);
+	}
+
+	SECTION("iteration")
+	{
+		soa_vector<int, std::string> v;
+		for (int i = 0; i < 10; ++i)
+			v.push_back(i, std::to_string(i));
+		int sum = 0;
+		for (auto row : v)
+		{
+			sum += std::get<0>(row);
+			std::get<1>(row) += "!";
+		}
+		CHECK(sum == 45);
+		CHECK(std::get<1>(v[3]) == "3!");
+		const auto& cv = v;
+		std::string all;
+		for (auto it = cv.begin(); it != cv.end(); ++it)
+			all += std::get<1>(*it);
+		CHECK(all.size() == 20);
+		CHECK(v.end() - v.begin() == 10);
+		CHECK(std::get<0>(v.begin()[4]) == 4);
+		soa_vector<int, std::string>::const_iterator ci = v.begin();
+		CHECK(ci == v.cbegin());
+	}
+
+	SECTION("resize and reserve")
+	{
+		CountingResource resource;
+		{
+			soa_vector<int, std::string> v { Yupei::memory_resource_ptr { &resource } };
+			v.resize(5);
+			CHECK(v.size() == 5);
+			CHECK(std::get<0>(v[4]) == 0);
+			CHECK(std::get<1>(v[4]).empty());
+			v.resize(8, 7, "seven");
+			CHECK(std::get<1>(v[7]) == "seven");
+			CHECK(std::get<0>(v[5]) == 7);
+			v.resize(2);
+			CHECK(v.size() == 2);
+			v.reserve(100);
+			CHECK(v.capacity() == 100);
+			const auto allocations = resource.allocations;
+			for (int i = 0; i < 98; ++i)
+				v.push_back(i, "x");
+			CHECK(resource.allocations == allocations);
+			v.resize(3);
+			v.shrink_to_fit();
+			CHECK(v.capacity() == 3);
+			CHECK(std::get<0>(v[2]) == 0);
+			CHECK(std::get<1>(v[2]) == "x");
+			v.clear();
+			v.shrink_to_fit();
+			CHECK(v.capacity() == 0);
+			CHECK(resource.live == 0);
+		}
+		CHECK(resource.live == 0);
+	}
+
+	SECTION("emplace_back aliasing")
+	{
+		soa_vector<std::string, int> v;
+		v.emplace_back("a string long enough to live on the heap", 1);
+		for (int i = 0; i < 40; ++i)
+			v.emplace_back(std::get<0>(v[0]), std::get<1>(v.back()) + 1);
+		CHECK(std::get<0>(v.back()) == std::get<0>(v.front()));
+		CHECK(std::get<1>(v.back()) == 41);
+
+		v.resize(100, std::get<0>(v[0]), std::get<1>(v[0]));
+		CHECK(v.size() == 100);
+		CHECK(std::get<0>(v[99]) == "a string long enough to live on the heap");
+		CHECK(std::get<1>(v[99]) == 1);
+	}
+
+	SECTION("copy and move")
+	{
+		CountingResource resource;
+		{
+			soa_vector<int, std::string> a { Yupei::memory_resource_ptr { &resource } };
+			for (int i = 0; i < 20; ++i)
+				a.push_back(i, std::to_string(i));
+			soa_vector<int, std::string> b = a;
+			CHECK(b.size() == 20);
+			CHECK(std::get<1>(b[19]) == "19");
+			CHECK(b.resource() == a.resource());
+			const auto p = &std::get<1>(a[5]);
+			soa_vector<int, std::string> c = std::move(a);
+			CHECK(a.empty());
+			CHECK(&std::get<1>(c[5]) == p);
+			a = c;
+			CHECK(std::get<0>(a[7]) == 7);
+			c = std::move(b);
+			swap(a, c);
+			CHECK(a.size() == 20);
+		}
+		CHECK(resource.live == 0);
+	}
+
+	SECTION("strong guarantee on growth")
+	{
+		soa_vector<std::string, ThrowingCopy> v;
+		v.reserve(4);
+		for (int i = 0; i < 4; ++i)
+			v.emplace_back(std::to_string(i) + " is a string long enough to live on the heap", ThrowingCopy(std::to_string(i).c_str()));
+		ThrowingCopy::copiesLeft = 2;
+		CHECK_THROWS_AS(v.emplace_back("x", "4"), std::runtime_error);
+		ThrowingCopy::copiesLeft = 1000;
+		CHECK(v.size() == 4);
+		CHECK(v.capacity() == 4);
+		for (int i = 0; i < 4; ++i)
+		{
+			CHECK(std::get<0>(v[i]) == std::to_string(i) + " is a string long enough to live on the heap");
+			CHECK(std::get<1>(v[i]).value == std::to_string(i));
+		}
+		CHECK(ThrowingCopy::live == 4);
+		v.emplace_back("x", "4");
+		CHECK(v.size() == 5);
+	}
+}
@@ -12,9 +12,77 @@
 #include "../../NotConstructible.h"
 #include "../../Emplaceable.h"
 #include "../../Copyable.h"
+#include "../../Instrumented.h"
 #include <MoveOnly.h>
 #include <catch.hpp>
 #include <Containers/Vector.hpp>
+#include <string>
+#include <list>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+	struct Tracked
+	{
+		static int live;
+		std::string value;
+
+		Tracked(const char* s) : value(s) { ++live; }
+		Tracked(const Tracked& other) : value(other.value) { ++live; }
+		Tracked(Tracked&& other) noexcept : value(std::move(other.value)) { ++live; }
+		Tracked& operator=(const Tracked&) = default;
+		Tracked& operator=(Tracked&&) = default;
+		~Tracked() { --live; }
+	};
+
+	int Tracked::live = 0;
+
+	struct MoveCounter
+	{
+		static int moves;
+		int a, b;
+
+		MoveCounter(int x, int y) : a(x), b(y) {}
+		MoveCounter(MoveCounter&& other) noexcept : a(other.a), b(other.b) { ++moves; }
+		MoveCounter& operator=(MoveCounter&& other) noexcept
+		{
+			a = other.a;
+			b = other.b;
+			++moves;
+			return *this;
+		}
+	};
+
+	int MoveCounter::moves = 0;
+
+	template<typename T>
+	bool Equals(const Yupei::vector<T>& v, std::initializer_list<T> il)
+	{
+		return std::equal(v.begin(), v.end(), il.begin(), il.end());
+	}
+
+	struct Handle
+	{
+		int* p;
+
+		explicit Handle(int v) : p(new int(v)) {}
+		Handle(Handle&& other) noexcept : p(other.p) { other.p = nullptr; }
+		Handle& operator=(Handle&& other) noexcept
+		{
+			std::swap(p, other.p);
+			return *this;
+		}
+		~Handle() { delete p; }
+	};
+}
+
+namespace Yupei
+{
+	template<>
+	struct is_trivially_relocatable<Handle> : std::true_type {};
+}
 
 TEST_CASE("vector")
 {
@@ -73,4 +141,338 @@ TEST_CASE("vector")
 		for (std::size_t j = 0; j < c.size(); ++j)
 			CHECK(c[j] == j);
 	}
+
+	SECTION("relocation traits")
+	{
+		CHECK(Yupei::is_trivially_relocatable_v<int>);
+		CHECK(!Yupei::is_trivially_relocatable_v<std::string>);
+		CHECK(Yupei::is_trivially_relocatable_v<Handle>);
+	}
+
+	SECTION("reserve keeps elements and lifetimes")
+	{
+		{
+			vector<Tracked> v;
+			v.push_back("a");
+			v.push_back("b");
+			v.push_back(Tracked("a long string that does not fit in the small buffer"));
+			CHECK(Tracked::live == 3);
+			v.reserve(1000);
+			CHECK(v.capacity() >= 1000);
+			CHECK(Tracked::live == 3);
+			CHECK(v[0].value == "a");
+			CHECK(v[1].value == "b");
+			CHECK(v[2].value == "a long string that does not fit in the small buffer");
+			const auto cap = v.capacity();
+			v.reserve(1);
+			CHECK(v.capacity() == cap);
+		}
+		CHECK(Tracked::live == 0);
+	}
+
+	SECTION("insert and erase strings")
+	{
+		{
+			vector<Tracked> v;
+			for (int i = 0; i < 20; ++i)
+				v.insert(v.cbegin(), Tracked(std::to_string(i).c_str()));
+			CHECK(Tracked::live == 20);
+			auto it = v.insert(v.cbegin() + 5, Tracked("x"));
+			CHECK(it == v.begin() + 5);
+			CHECK(v[5].value == "x");
+			CHECK(v[4].value == "15");
+			CHECK(v[6].value == "14");
+			it = v.erase(v.cbegin() + 2, v.cbegin() + 6);
+			CHECK(it == v.begin() + 2);
+			CHECK(v.size() == 17);
+			CHECK(Tracked::live == 17);
+			CHECK(v[1].value == "18");
+			CHECK(v[2].value == "14");
+			CHECK(v.back().value == "0");
+			it = v.erase(v.cend() - 1, v.cend());
+			CHECK(it == v.end());
+		}
+		CHECK(Tracked::live == 0);
+	}
+
+	SECTION("insert aliased element")
+	{
+		vector<std::string> v;
+		v.push_back("first");
+		v.push_back("second");
+		while (v.size() < v.capacity())
+			v.push_back("filler");
+		const auto last = v.back();
+		v.insert(v.cbegin(), v.back());
+		CHECK(v.front() == last);
+		v.insert(v.cbegin() + 1, v[2]);
+		CHECK(v[1] == "second");
+		CHECK(v[2] == "first");
+	}
+
+	SECTION("trivially relocatable opt-in")
+	{
+		vector<Handle> v;
+		for (int i = 0; i < 50; ++i)
+			v.push_back(Handle(i));
+		v.insert(v.cbegin() + 3, Handle(100));
+		CHECK(*v[3].p == 100);
+		CHECK(*v[4].p == 3);
+		v.erase(v.cbegin(), v.cbegin() + 3);
+		CHECK(*v[0].p == 100);
+		CHECK(*v.back().p == 49);
+		v.reserve(v.capacity() * 2);
+		CHECK(v.size() == 48);
+		CHECK(*v[1].p == 3);
+	}
+
+	SECTION("move only")
+	{
+		vector<MoveOnly> v;
+		for (int i = 0; i < 10; ++i)
+			v.insert(v.cend(), MoveOnly(i));
+		v.insert(v.cbegin() + 2, MoveOnly(42));
+		CHECK(v[2] == MoveOnly(42));
+		CHECK(v[3] == MoveOnly(2));
+		v.reserve(100);
+		CHECK(v[10] == MoveOnly(9));
+	}
+
+	SECTION("append ranges")
+	{
+		vector<int> v;
+		std::list<int> l;
+		for (int i = 0; i < 1000; ++i)
+			l.push_back(i);
+		v.append(l.begin(), l.end());
+		CHECK(v.size() == 1000);
+		CHECK(v.capacity() == Yupei::vector_growth_1_5x::grow(0, 1000, sizeof(int)));
+		CHECK(v[999] == 999);
+		const int a[] = { 7, 8, 9 };
+		v.append(std::begin(a), std::end(a));
+		CHECK(v.size() == 1003);
+		CHECK(v[1000] == 7);
+		CHECK(v[1002] == 9);
+		std::istringstream in("1 2 3 4");
+		v.append(std::istream_iterator<int>(in), std::istream_iterator<int>());
+		CHECK(v.size() == 1007);
+		CHECK(v[1006] == 4);
+		vector<std::string> s { "a", "b" };
+		s.append(s.begin(), s.end());
+		s.append(s.begin(), s.end());
+		CHECK(s.size() == 8);
+		CHECK(s[6] == "a");
+		CHECK(s[7] == "b");
+	}
+
+	SECTION("insert ranges")
+	{
+		vector<int> v { 1, 2, 3, 4 };
+		const int a[] = { 10, 11, 12 };
+		auto it = v.insert(v.cbegin() + 1, std::begin(a), std::end(a));
+		CHECK(it == v.begin() + 1);
+		CHECK(Equals(v, { 1, 10, 11, 12, 2, 3, 4 }));
+		it = v.insert(v.cend(), { 5, 6 });
+		CHECK(it == v.begin() + 7);
+		CHECK(v.size() == 9);
+		CHECK(v.back() == 6);
+		it = v.insert(v.cbegin(), std::begin(a), std::begin(a));
+		CHECK(it == v.begin());
+		CHECK(v.size() == 9);
+		std::istringstream in("20 21");
+		it = v.insert(v.cbegin() + 2, std::istream_iterator<int>(in), std::istream_iterator<int>());
+		CHECK(Equals(v, { 1, 10, 20, 21, 11, 12, 2, 3, 4, 5, 6 }));
+		{
+			vector<Tracked> t;
+			t.push_back("x");
+			t.push_back("y");
+			std::list<Tracked> l;
+			for (int i = 0; i < 40; ++i)
+				l.push_back(std::to_string(i).c_str());
+			t.insert(t.cbegin() + 1, l.begin(), l.end());
+			CHECK(t.size() == 42);
+			CHECK(t[0].value == "x");
+			CHECK(t[1].value == "0");
+			CHECK(t[40].value == "39");
+			CHECK(t[41].value == "y");
+			t.reserve(100);
+			t.insert(t.cbegin() + 1, l.begin(), std::next(l.begin(), 3));
+			CHECK(t.size() == 45);
+			CHECK(t[3].value == "2");
+			CHECK(t[4].value == "0");
+			CHECK(t[44].value == "y");
+			CHECK(Tracked::live == 85);
+		}
+		CHECK(Tracked::live == 0);
+	}
+
+	SECTION("insert copies")
+	{
+		vector<std::string> v { "a", "b", "c" };
+		auto it = v.insert(v.cbegin() + 1, 3, v[2]);
+		CHECK(it == v.begin() + 1);
+		CHECK(v.size() == 6);
+		CHECK(v[1] == "c");
+		CHECK(v[3] == "c");
+		CHECK(v[4] == "b");
+		v.reserve(20);
+		v.insert(v.cbegin(), 2, v.back());
+		CHECK(v.size() == 8);
+		CHECK(v[0] == "c");
+		CHECK(v[2] == "a");
+		vector<int> n(2, 1);
+		n.insert(n.cbegin() + 1, 5, n[0]);
+		CHECK(Equals(n, { 1, 1, 1, 1, 1, 1, 1 }));
+	}
+
+	SECTION("uninitialized growth")
+	{
+		vector<char> buffer;
+		buffer.resize_uninitialized(16);
+		CHECK(buffer.size() == 16);
+		const auto p = buffer.append_uninitialized(4);
+		CHECK(static_cast<void*>(p) == static_cast<void*>(buffer.data() + 16));
+		CHECK(buffer.size() == 20);
+		for (int i = 0; i < 20; ++i)
+			buffer[i] = static_cast<char>(i);
+		buffer.resize_uninitialized(5);
+		CHECK(buffer.size() == 5);
+		CHECK(buffer[4] == 4);
+		const auto cap = buffer.capacity();
+		buffer.resize_uninitialized(cap);
+		CHECK(buffer.capacity() == cap);
+	}
+
+	SECTION("emplace_back")
+	{
+		vector<MoveCounter> v;
+		v.reserve(4);
+		MoveCounter::moves = 0;
+		auto& r = v.emplace_back(1, 2);
+		CHECK(&r == &v.back());
+		CHECK(r.a == 1);
+		CHECK(r.b == 2);
+		v.emplace_back(3, 4);
+		CHECK(MoveCounter::moves == 0);
+		vector<Emplaceable> e;
+		for (int i = 0; i < 20; ++i)
+			CHECK(e.emplace_back(i, 0.5).get() == i);
+		CHECK(e.size() == 20);
+		CHECK(e[19] == Emplaceable(19, 0.5));
+	}
+
+	SECTION("emplace")
+	{
+		vector<Emplaceable> e;
+		e.emplace_back(1, 1.0);
+		e.emplace_back(3, 3.0);
+		auto it = e.emplace(e.cbegin() + 1, 2, 2.0);
+		CHECK(it == e.begin() + 1);
+		CHECK(e[1] == Emplaceable(2, 2.0));
+		CHECK(e[2] == Emplaceable(3, 3.0));
+		it = e.emplace(e.cend(), 4, 4.0);
+		CHECK(e.back() == Emplaceable(4, 4.0));
+		it = e.emplace(e.cbegin());
+		CHECK(e.front() == Emplaceable());
+		CHECK(e.size() == 5);
+	}
+
+	SECTION("push_back aliased element")
+	{
+		vector<std::string> v;
+		v.push_back("a string long enough to live on the heap");
+		while (v.size() < v.capacity())
+			v.push_back("filler");
+		v.push_back(v.front());
+		CHECK(v.back() == "a string long enough to live on the heap");
+		while (v.size() < v.capacity())
+			v.push_back("filler");
+		v.emplace_back(v[0], 2, 6);
+		CHECK(v.back() == "string");
+	}
+
+	SECTION("growth policies")
+	{
+		struct Large { char bytes[200]; };
+		CHECK(Yupei::vector_growth_1_5x::grow(0, 1, sizeof(int)) == 16);
+		CHECK(Yupei::vector_growth_1_5x::grow(0, 1, sizeof(Large)) == 1);
+		CHECK(Yupei::vector_growth_1_5x::grow(16, 17, sizeof(int)) == 32);
+		CHECK(Yupei::vector_growth_1_5x::grow(16, 100, sizeof(int)) == 112);
+		CHECK(Yupei::vector_growth_2x::grow(10, 11, sizeof(int)) == 20);
+		CHECK(Yupei::vector_growth_2x::grow(0, 1, sizeof(int)) == 16);
+		CHECK(Yupei::vector_growth_exact::grow(10, 11, sizeof(int)) == 11);
+		CHECK(Yupei::vector_growth_page::grow(16, 17, sizeof(int)) == 32);
+		CHECK(Yupei::vector_growth_page::grow(2000, 2001, sizeof(int)) == 3072);
+
+		vector<Large> large;
+		large.push_back(Large {});
+		CHECK(large.capacity() == 1);
+
+		vector<int, Yupei::vector_growth_exact> exact;
+		for (int i = 0; i < 5; ++i)
+			exact.push_back(i);
+		CHECK(exact.capacity() == 5);
+		int sum = 0;
+		for (auto it = exact.begin(); it != exact.end(); ++it)
+			sum += *it;
+		CHECK(sum == 10);
+
+		vector<int, Yupei::vector_growth_2x> doubling;
+		doubling.push_back(0);
+		CHECK(doubling.capacity() == 16);
+		doubling.resize(17);
+		CHECK(doubling.capacity() == 32);
+		doubling.reserve(40);
+		CHECK(doubling.capacity() == 40);
+	}
+
+	SECTION("shrink_to_fit")
+	{
+		vector<std::string> v;
+		for (int i = 0; i < 100; ++i)
+			v.push_back(std::to_string(i));
+		v.erase(v.cbegin() + 3, v.cend());
+		CHECK(v.capacity() > 3);
+		v.shrink_to_fit();
+		CHECK(v.capacity() == 3);
+		CHECK(v.size() == 3);
+		CHECK(v[0] == "0");
+		CHECK(v[2] == "2");
+		v.shrink_to_fit();
+		CHECK(v.capacity() == 3);
+		v.clear();
+		v.shrink_to_fit();
+		CHECK(v.capacity() == 0);
+		CHECK(v.data() == nullptr);
+		v.push_back("again");
+		CHECK(v.front() == "again");
+	}
+
+	SECTION("reallocating insert keeps the vector on exceptions")
+	{
+		{
+			vector<ThrowingCopy> v;
+			v.reserve(4);
+			for (auto s : { "a", "b", "c", "d" })
+				v.emplace_back(s);
+			REQUIRE(v.size() == v.capacity());
+
+			//new element, the front half and one element of the tail succeed
+			ThrowingCopy::copiesLeft = 4;
+			CHECK_THROWS_AS(v.insert(v.cbegin() + 2, ThrowingCopy("x")), std::runtime_error);
+			ThrowingCopy::copiesLeft = 1000;
+			REQUIRE(v.size() == 4);
+			CHECK(v[0].value == "a");
+			CHECK(v[1].value == "b");
+			CHECK(v[2].value == "c");
+			CHECK(v[3].value == "d");
+			CHECK(ThrowingCopy::live == 4);
+
+			v.insert(v.cbegin() + 2, ThrowingCopy("x"));
+			CHECK(v.size() == 5);
+			CHECK(v[2].value == "x");
+			CHECK(v[4].value == "d");
+		}
+		CHECK(ThrowingCopy::live == 0);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+// <Containers/ConcurrentDictionary.hpp>
+
+#include <Containers/ConcurrentDictionary.hpp>
+#include <catch.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("ConcurrentDictionary")
+{
+	using namespace Yupei;
+
+	SECTION("single thread semantics")
+	{
+		concurrent_dictionary<int, std::string> dict(10);
+		CHECK(dict.stripe_count() == 16);
+
+		CHECK(dict.try_emplace(1, "one"));
+		CHECK(!dict.try_emplace(1, "uno"));
+		CHECK(dict.insert({ 2, "two" }));
+		CHECK(!dict.insert_or_assign(2, "dos"));
+		CHECK(dict.insert_or_assign(3, "three"));
+		CHECK(dict.size() == 3);
+
+		std::string value;
+		CHECK(dict.find(1, value));
+		CHECK(value == "one");
+		CHECK(dict.find(2, value));
+		CHECK(value == "dos");
+		CHECK(!dict.find(4, value));
+		CHECK(dict.contains(3));
+
+		CHECK(dict.upsert(4, [](std::string& v) { v += "four"; }));
+		CHECK(!dict.upsert(4, [](std::string& v) { v += "!"; }));
+		CHECK(dict.visit(4, [](const std::string& v) { CHECK(v == "four!"); }));
+
+		CHECK(dict.erase(1));
+		CHECK(!dict.erase(1));
+		CHECK(!dict.contains(1));
+
+		std::size_t visited = 0;
+		dict.for_each([&](const std::pair<int, std::string>&) { ++visited; });
+		CHECK(visited == 3);
+
+		dict.clear();
+		CHECK(dict.size() == 0);
+	}
+
+	SECTION("concurrent upsert and lookup")
+	{
+		constexpr int kThreads = 4;
+		constexpr int kKeys = 1000;
+		constexpr int kRounds = 20;
+		concurrent_dictionary<int, int> dict;
+		dict.reserve(kKeys);
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < kThreads; ++t)
+			threads.emplace_back([&] {
+				for (int round = 0; round < kRounds; ++round)
+					for (int i = 0; i < kKeys; ++i)
+					{
+						dict.upsert(i, [](int& v) { ++v; });
+						int value;
+						dict.find(i, value);
+					}
+			});
+		for (auto& thread : threads)
+			thread.join();
+
+		CHECK(dict.size() == kKeys);
+		bool allCounted = true;
+		dict.for_each([&](const std::pair<int, int>& kv) {
+			allCounted = allCounted && kv.second == kThreads * kRounds;
+		});
+		CHECK(allCounted);
+	}
+}
@@ -0,0 +1,105 @@
+// <Containers/CowDictionary.hpp>
+
+#include <Containers/CowDictionary.hpp>
+#include <MemoryResource/MemoryResource.hpp>
+#include <catch.hpp>
+#include <string>
+#include <utility>
+
+TEST_CASE("CowDictionary")
+{
+	using namespace Yupei;
+
+	SECTION("snapshot is not affected by later writes")
+	{
+		cow_dictionary<int, std::string> dict;
+		for (int i = 0; i < 100; ++i)
+			dict.insert({ i, std::to_string(i) });
+		CHECK(!dict.shared());
+
+		const auto snapshot = dict.snapshot();
+		CHECK(dict.shared());
+		CHECK(&*snapshot == &dict.read());
+
+		dict[0] = "zero";
+		dict.erase(1);
+		dict.insert({ 100, "100" });
+		CHECK(!dict.shared());
+		CHECK(&*snapshot != &dict.read());
+
+		CHECK(snapshot->size() == 100);
+		CHECK(snapshot->at(0) == "0");
+		CHECK(snapshot->at(1) == "1");
+		CHECK(snapshot->find(100) == snapshot->end());
+
+		CHECK(dict.size() == 100);
+		CHECK(dict.at(0) == "zero");
+		CHECK(dict.find(1) == dict.end());
+		CHECK(dict.at(100) == "100");
+	}
+
+	SECTION("writes without snapshots do not copy")
+	{
+		cow_dictionary<int, int> dict;
+		dict.insert({ 1, 1 });
+		const auto address = &dict.read();
+		dict.insert_or_assign(1, 2);
+		dict.try_emplace(2, 3);
+		CHECK(&dict.read() == address);
+		CHECK(dict.at(1) == 2);
+		CHECK(dict.at(2) == 3);
+
+		const auto snapshot = dict.snapshot();
+		CHECK(!dict.erase(42));
+		CHECK(&dict.read() == address);
+	}
+
+	SECTION("copies share until written")
+	{
+		cow_dictionary<int, int> a { { 1, 1 }, { 2, 2 } };
+		cow_dictionary<int, int> b(a);
+		CHECK(&a.read() == &b.read());
+
+		b[1] = 10;
+		CHECK(a.at(1) == 1);
+		CHECK(b.at(1) == 10);
+
+		const auto snapshot = a.snapshot();
+		a.clear();
+		CHECK(a.size() == 0);
+		CHECK(snapshot->size() == 2);
+
+		cow_dictionary<int, int> c(std::move(b));
+		CHECK(c.at(1) == 10);
+	}
+
+	SECTION("clear while shared keeps the resource and max load factor")
+	{
+		monotonic_buffer_resource arena { memory_resource_ptr {} };
+		dictionary<int, int> source(16, {}, {}, memory_resource_ptr { &arena });
+		source.max_load_factor(0.5f);
+		source.insert({ 1, 1 });
+
+		cow_dictionary<int, int> dict(std::move(source));
+		const auto snapshot = dict.snapshot();
+		dict.clear();
+		CHECK(dict.size() == 0);
+		CHECK(snapshot->size() == 1);
+		CHECK(dict.read().get_allocator().resource() == memory_resource_ptr { &arena });
+		CHECK(dict.read().max_load_factor() == 0.5f);
+	}
+
+	SECTION("write while shared copies onto the same resource")
+	{
+		monotonic_buffer_resource arena { memory_resource_ptr {} };
+		dictionary<int, int> source(16, {}, {}, memory_resource_ptr { &arena });
+		source.insert({ 1, 1 });
+
+		cow_dictionary<int, int> dict(std::move(source));
+		const auto snapshot = dict.snapshot();
+		dict.write()[2] = 2;
+		CHECK(dict.size() == 2);
+		CHECK(snapshot->size() == 1);
+		CHECK(dict.read().get_allocator().resource() == memory_resource_ptr { &arena });
+	}
+}
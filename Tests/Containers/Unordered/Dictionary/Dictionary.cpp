@@ -10,9 +10,12 @@
 //<Containers/Dictionary.hpp>
 
 #include <Containers/Dictionary.hpp>
+#include "../../Instrumented.h"
 #include <catch.hpp>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 namespace 
 {
@@ -58,6 +61,15 @@ namespace
 		}
 	};
 
+	struct StringHash
+	{
+		using is_transparent = void;
+
+		std::size_t operator()(std::string_view str) const
+		{
+			return Yupei::hash<>{}(str);
+		}
+	};
 }
 
 TEST_CASE("Dictionary")
@@ -297,4 +309,366 @@ TEST_CASE("Dictionary")
 		CHECK(r.first->first.get() == 3); // key
 		CHECK(r.first->second.get() == 5); // value
 	}
+
+	SECTION("heterogeneous lookup with transparent hasher and key_equal")
+	{
+		dictionary<std::string, int, StringHash, std::equal_to<>> dict;
+		dict.insert({ "one", 1 });
+		dict.insert({ "two", 2 });
+		dict.insert({ "three", 3 });
+
+		CHECK(dict.find(std::string_view("two"))->second == 2);
+		CHECK(dict.find("three")->second == 3);
+		CHECK(dict.find("four") == dict.end());
+		CHECK(dict.at(std::string_view("one")) == 1);
+		CHECK_THROWS_AS(dict.at("four"), std::out_of_range);
+
+		auto r = dict.try_emplace(std::string_view("two"), 20);
+		CHECK(!r.second);
+		CHECK(r.first->second == 2);
+		r = dict.try_emplace(std::string_view("four"), 4);
+		CHECK(r.second);
+		CHECK(r.first->first == "four");
+		CHECK(dict.size() == 4);
+
+		dict["five"] = 5;
+		CHECK(dict.at("five") == 5);
+		CHECK(dict.insert_or_assign(std::string_view("one"), 10).second == false);
+		CHECK(dict.at("one") == 10);
+
+		dictionary<std::string, std::string, StringHash, std::equal_to<>> names;
+		names.insert_or_assign(std::string_view("key"), std::string(64, 'a'));
+		CHECK(names.insert_or_assign(std::string_view("key"), std::string(64, 'b')).second == false);
+		CHECK(names.at("key") == std::string(64, 'b'));
+
+		CHECK(dict.erase(std::string_view("two")));
+		CHECK(!dict.erase("two"));
+		CHECK(dict.size() == 4);
+		CHECK(dict.find(std::string("two")) == dict.end());
+	}
+
+	SECTION("find_batch and contains_batch")
+	{
+		dictionary<int, int> dict;
+		for (int i = 0; i < 1000; ++i)
+			dict.insert({ i * 2, i });
+
+		std::vector<int> keys;
+		for (int i = -5; i < 2005; i += 3)
+			keys.push_back(i);
+
+		std::vector<dictionary<int, int>::iterator> found(keys.size());
+		CHECK(dict.find_batch(keys.begin(), keys.end(), found.begin()) == found.end());
+		std::vector<bool> contained;
+		dict.contains_batch(keys.begin(), keys.end(), std::back_inserter(contained));
+		REQUIRE(contained.size() == keys.size());
+		for (std::size_t i = 0; i < keys.size(); ++i)
+		{
+			CHECK(found[i] == dict.find(keys[i]));
+			CHECK(contained[i] == (dict.find(keys[i]) != dict.end()));
+		}
+	}
+
+	SECTION("precomputed hash entry points")
+	{
+		dictionary<std::string, int, StringHash, std::equal_to<>> dict;
+		const auto hashCode = dict.hash_function()("one");
+
+		auto r = dict.try_emplace_hashed(std::string_view("one"), hashCode, 1);
+		CHECK(r.second);
+		CHECK(dict.stored_hash(r.first) == hashCode);
+		r = dict.try_emplace_hashed(std::string_view("one"), hashCode, 10);
+		CHECK(!r.second);
+		CHECK(r.first->second == 1);
+
+		CHECK(dict.find_hashed(std::string_view("one"), hashCode) == dict.find("one"));
+		CHECK(dict.find_hashed(std::string("one"), hashCode)->second == 1);
+
+		const auto twoHash = dict.hash_function()("two");
+		CHECK(dict.find_hashed(std::string_view("two"), twoHash) == dict.end());
+		CHECK(!dict.erase_hashed(std::string_view("two"), twoHash));
+		CHECK(dict.erase_hashed(std::string_view("one"), hashCode));
+		CHECK(dict.size() == 0);
+	}
+
+	SECTION("reserve, rehash, max_load_factor and shrink_to_fit")
+	{
+		dictionary<int, std::string> dict;
+		dict.reserve(100);
+		const auto buckets = dict.bucket_count();
+		CHECK(buckets >= 100);
+		for (int i = 0; i < 100; ++i)
+			dict.insert({ i, std::to_string(i) });
+		CHECK(dict.bucket_count() == buckets);
+
+		dict.max_load_factor(0.5f);
+		CHECK(dict.max_load_factor() == 0.5f);
+		CHECK(dict.load_factor() <= 0.5f);
+		CHECK(dict.bucket_count() >= 200);
+
+		for (int i = 0; i < 100; i += 2)
+			dict.erase(i);
+		dict.rehash(1000);
+		CHECK(dict.bucket_count() >= 1000);
+		dict.shrink_to_fit();
+		CHECK(dict.bucket_count() < 1000);
+		CHECK(dict.load_factor() <= 0.5f);
+
+		CHECK(dict.size() == 50);
+		for (int i = 1; i < 100; i += 2)
+			CHECK(dict.at(i) == std::to_string(i));
+		CHECK(dict.find(0) == dict.end());
+
+		dict.clear();
+		CHECK(dict.size() == 0);
+		CHECK(dict.begin() == dict.end());
+		dict.insert({ 7, "seven" });
+		CHECK(dict.at(7) == "seven");
+	}
+
+	SECTION("bulk construction from a range")
+	{
+		std::vector<std::pair<int, int>> source;
+		for (int i = 0; i < 10000; ++i)
+			source.push_back({ i % 5000, i });
+
+		dictionary<int, int> dict(source.begin(), source.end());
+		CHECK(dict.size() == 5000);
+		CHECK(dict.load_factor() <= dict.max_load_factor());
+		for (int i = 0; i < 5000; ++i)
+			CHECK(dict.at(i) == i);
+
+		dict.insert(source.begin(), source.end());
+		CHECK(dict.size() == 5000);
+	}
+
+	SECTION("iteration visits every element once")
+	{
+		dictionary<int, int> dict;
+		for (int i = 0; i < 100; ++i)
+			dict.insert({ i, i });
+		for (int i = 0; i < 100; i += 3)
+			dict.erase(i);
+
+		std::size_t visited = 0;
+		int sum = 0;
+		for (const auto& kv : dict)
+		{
+			++visited;
+			sum += kv.second;
+		}
+		CHECK(visited == dict.size());
+		CHECK(sum == 4950 - 1683);
+	}
+
+	SECTION("copy keeps the layout and the free list")
+	{
+		dictionary<int, std::string> dict;
+		for (int i = 0; i < 200; ++i)
+			dict.insert({ i, std::to_string(i) });
+		for (int i = 0; i < 200; i += 2)
+			dict.erase(i);
+
+		dictionary<int, std::string> copy(dict);
+		CHECK(copy.size() == dict.size());
+		CHECK(copy.bucket_count() == dict.bucket_count());
+		for (int i = 1; i < 200; i += 2)
+			CHECK(copy.at(i) == std::to_string(i));
+		CHECK(copy.find(0) == copy.end());
+
+		for (int i = 0; i < 200; i += 2)
+			copy.insert({ i, "copy" });
+		CHECK(copy.size() == 200);
+		CHECK(dict.size() == 100);
+		CHECK(dict.find(0) == dict.end());
+
+		dictionary<int, int> trivial;
+		for (int i = 0; i < 100; ++i)
+			trivial.insert({ i, i * i });
+		trivial.erase(50);
+		const dictionary<int, int> trivialCopy(trivial);
+		CHECK(trivialCopy.size() == 99);
+		for (int i = 0; i < 100; ++i)
+			if (i != 50)
+				CHECK(trivialCopy.at(i) == i * i);
+		CHECK(trivialCopy.find(50) == trivialCopy.end());
+
+		dictionary<int, int> moved(std::move(trivial));
+		const dictionary<int, int> empty(trivial);
+		CHECK(empty.size() == 0);
+	}
+
+	SECTION("swap and assignment")
+	{
+		dictionary<int, std::string> a { { 1, "1" }, { 2, "2" } };
+		dictionary<int, std::string> b;
+		for (int i = 0; i < 100; ++i)
+			b.insert({ i, std::to_string(i) });
+
+		a.swap(b);
+		CHECK(a.size() == 100);
+		CHECK(b.size() == 2);
+		CHECK(a.at(99) == "99");
+		CHECK(b.at(2) == "2");
+
+		b = a;
+		CHECK(b.size() == 100);
+		CHECK(b.at(50) == "50");
+
+		a = std::move(b);
+		CHECK(a.size() == 100);
+		a.insert({ 100, "100" });
+		CHECK(a.at(100) == "100");
+	}
+
+	SECTION("copy keeps the source's resource, assignment keeps the destination's")
+	{
+		CountingResource left, right;
+		{
+			dictionary<int, std::string> a(0, {}, {}, memory_resource_ptr{ &left });
+			for (int i = 0; i < 50; ++i)
+				a.insert({ i, std::to_string(i) + " long enough string" });
+			const auto leftAllocations = left.allocations;
+
+			dictionary<int, std::string> copy { a };
+			CHECK(copy.get_allocator().resource() == memory_resource_ptr{ &left });
+			CHECK(left.allocations == leftAllocations + 2);
+
+			dictionary<int, std::string> b(0, {}, {}, memory_resource_ptr{ &right });
+			b = a;
+			CHECK(b.get_allocator().resource() == memory_resource_ptr{ &right });
+			CHECK(b.size() == 50);
+			CHECK(b.at(7) == "7 long enough string");
+
+			dictionary<int, std::string> c(0, {}, {}, memory_resource_ptr{ &right });
+			c = std::move(copy);
+			CHECK(c.get_allocator().resource() == memory_resource_ptr{ &right });
+			CHECK(c.size() == 50);
+			CHECK(c.at(49) == "49 long enough string");
+			CHECK(copy.size() == 0);
+			c.insert({ 50, "50" });
+			CHECK(c.at(50) == "50");
+
+			b = std::move(c);
+			CHECK(b.size() == 51);
+			CHECK(c.size() == 0);
+		}
+		CHECK(left.live == 0);
+		CHECK(right.live == 0);
+	}
+
+	SECTION("extract and insert node handles")
+	{
+		dictionary<int, std::string> a;
+		for (int i = 0; i < 10; ++i)
+			a.insert({ i, std::to_string(i) });
+
+		auto node = a.extract(3);
+		REQUIRE(!node.empty());
+		CHECK(node.key() == 3);
+		CHECK(node.mapped() == "3");
+		CHECK(a.size() == 9);
+		CHECK(a.find(3) == a.end());
+		CHECK(a.extract(3).empty());
+
+		node.mapped() = "three";
+		dictionary<int, std::string> b;
+		auto result = b.insert(std::move(node));
+		CHECK(result.inserted);
+		CHECK(result.node.empty());
+		CHECK(node.empty());
+		CHECK(result.position->second == "three");
+		CHECK(b.at(3) == "three");
+
+		auto node2 = a.extract(a.find(4));
+		CHECK(node2.key() == 4);
+		b.insert({ 4, "four" });
+		auto result2 = b.insert(std::move(node2));
+		CHECK(!result2.inserted);
+		REQUIRE(!result2.node.empty());
+		CHECK(result2.node.mapped() == "4");
+		CHECK(b.at(4) == "four");
+
+		auto empty = b.insert(dictionary<int, std::string>::node_type {});
+		CHECK(!empty.inserted);
+		CHECK(empty.position == b.end());
+
+		dictionary<std::string, int, StringHash, std::equal_to<>> c { { "key", 1 } };
+		auto node3 = c.extract(std::string_view { "key" });
+		CHECK(node3.mapped() == 1);
+		CHECK(c.size() == 0);
+	}
+
+	SECTION("merge")
+	{
+		dictionary<int, std::string> a { { 1, "a1" }, { 2, "a2" } };
+		dictionary<int, std::string> b;
+		for (int i = 0; i < 50; ++i)
+			b.insert({ i, "b" + std::to_string(i) });
+
+		a.merge(b);
+		CHECK(a.size() == 50);
+		CHECK(a.at(1) == "a1");
+		CHECK(a.at(2) == "a2");
+		CHECK(a.at(49) == "b49");
+		CHECK(b.size() == 2);
+		CHECK(b.at(1) == "b1");
+		CHECK(b.at(2) == "b2");
+
+		a.merge(a);
+		CHECK(a.size() == 50);
+
+		b.insert({ 100, "b100" });
+		CHECK(b.find(100) != b.end());
+		a.merge(std::move(b));
+		CHECK(a.at(100) == "b100");
+	}
+
+	SECTION("stats")
+	{
+		dictionary<int, int> dict;
+		auto stats = dict.stats();
+		CHECK(stats.size == 0);
+		CHECK(stats.max_chain_length == 0);
+		CHECK(stats.average_probe_length == 0.);
+
+		for (int i = 0; i < 100; ++i)
+			dict.insert({ i, i });
+		for (int i = 0; i < 10; ++i)
+			dict.erase(i);
+		stats = dict.stats();
+		CHECK(stats.size == 90);
+		CHECK(stats.bucket_count == dict.bucket_count());
+		CHECK(stats.free_count == 10);
+		CHECK(stats.tombstone_bytes > 0);
+		CHECK(stats.bytes_allocated > stats.tombstone_bytes);
+		CHECK(stats.load_factor == Approx(dict.load_factor()));
+		std::size_t buckets = 0, elements = 0;
+		for (std::size_t i = 0; i < stats.chain_length_histogram.size(); ++i)
+		{
+			buckets += stats.chain_length_histogram[i];
+			elements += i * stats.chain_length_histogram[i];
+		}
+		CHECK(buckets == stats.bucket_count);
+		CHECK(stats.chain_length_histogram[0] == stats.empty_buckets);
+		if (stats.max_chain_length < stats.chain_length_histogram.size() - 1)
+			CHECK(elements == stats.size);
+		CHECK(stats.average_probe_length >= 1.);
+		CHECK(stats.average_chain_length >= 1.);
+
+		struct BadHash
+		{
+			std::size_t operator()(int) const noexcept
+			{
+				return 0;
+			}
+		};
+		dictionary<int, int, BadHash> bad;
+		for (int i = 0; i < 20; ++i)
+			bad.insert({ i, i });
+		stats = bad.stats();
+		CHECK(stats.max_chain_length == 20);
+		CHECK(stats.average_probe_length == Approx(10.5));
+		CHECK(stats.chain_length_histogram.back() == 1);
+	}
 }
@@ -0,0 +1,164 @@
+// <Containers/FrozenDictionary.hpp>
+
+#include <Containers/FrozenDictionary.hpp>
+#include "../../Instrumented.h"
+#include <catch.hpp>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	struct StringHash
+	{
+		using is_transparent = void;
+
+		std::size_t operator()(std::string_view str) const
+		{
+			return Yupei::hash<>{}(str);
+		}
+	};
+
+	struct CollidingHash
+	{
+		std::size_t operator()(int value) const noexcept
+		{
+			return static_cast<std::size_t>(value % 4);
+		}
+	};
+
+	struct OffsetHash
+	{
+		std::size_t offset = 0;
+
+		std::size_t operator()(int value) const noexcept
+		{
+			return Yupei::hash<>{}(value + static_cast<int>(offset));
+		}
+	};
+}
+
+TEST_CASE("FrozenDictionary")
+{
+	using namespace Yupei;
+
+	SECTION("build from dictionary")
+	{
+		dictionary<int, std::string> dict;
+		for (int i = 0; i < 1000; ++i)
+			dict.insert({ i * 7, std::to_string(i) });
+
+		const frozen_dictionary<int, std::string> frozen(dict);
+		CHECK(frozen.size() == 1000);
+		for (int i = 0; i < 1000; ++i)
+		{
+			REQUIRE(frozen.find(i * 7) != frozen.end());
+			CHECK(frozen.at(i * 7) == std::to_string(i));
+		}
+		CHECK(frozen.find(1) == frozen.end());
+		CHECK(!frozen.contains(-7));
+		CHECK_THROWS_AS(frozen.at(3), std::out_of_range);
+
+		std::size_t count = 0;
+		for (const auto& kv : frozen)
+		{
+			CHECK(dict.at(kv.first) == kv.second);
+			++count;
+		}
+		CHECK(count == dict.size());
+	}
+
+	SECTION("build from range, duplicates keep the first value")
+	{
+		std::vector<std::pair<std::string, int>> source { { "a", 1 }, { "b", 2 }, { "a", 3 }, { "c", 4 } };
+		const frozen_dictionary<std::string, int, StringHash, std::equal_to<>> frozen(source.begin(), source.end());
+		CHECK(frozen.size() == 3);
+		CHECK(frozen.at("a") == 1);
+		CHECK(frozen.at(std::string_view("b")) == 2);
+		CHECK(frozen.find("c")->second == 4);
+		CHECK(!frozen.contains("d"));
+	}
+
+	SECTION("empty, single element, copy and move")
+	{
+		const frozen_dictionary<int, int> empty(dictionary<int, int>{});
+		CHECK(empty.empty());
+		CHECK(empty.find(0) == empty.end());
+
+		frozen_dictionary<int, int> single { { 42, 1 } };
+		CHECK(single.at(42) == 1);
+		CHECK(!single.contains(41));
+
+		auto copy = single;
+		CHECK(copy.at(42) == 1);
+		const auto moved = std::move(copy);
+		CHECK(moved.at(42) == 1);
+		CHECK(copy.empty());
+	}
+
+	SECTION("keys with identical hashes")
+	{
+		dictionary<int, int, CollidingHash> dict;
+		for (int i = 0; i < 100; ++i)
+			dict.insert({ i, i * 2 });
+
+		const frozen_dictionary<int, int, CollidingHash> frozen(dict);
+		CHECK(frozen.size() == 100);
+		for (int i = 0; i < 100; ++i)
+			CHECK(frozen.at(i) == i * 2);
+		CHECK(!frozen.contains(100));
+		CHECK(!frozen.contains(-1));
+
+		const auto copy = frozen;
+		for (int i = 0; i < 100; ++i)
+			CHECK(copy.at(i) == i * 2);
+	}
+
+	SECTION("swap exchanges the hash functions")
+	{
+		frozen_dictionary<int, int, OffsetHash> first({ { 1, 10 }, { 2, 20 }, { 3, 30 } }, OffsetHash{ 1 });
+		frozen_dictionary<int, int, OffsetHash> second({ { 4, 40 }, { 5, 50 } }, OffsetHash{ 1000 });
+		first.swap(second);
+		CHECK(first.hash_function().offset == 1000);
+		CHECK(second.hash_function().offset == 1);
+		CHECK(first.at(4) == 40);
+		CHECK(first.at(5) == 50);
+		CHECK(second.at(1) == 10);
+		CHECK(second.at(3) == 30);
+		CHECK(!first.contains(1));
+
+		first = second;
+		CHECK(first.hash_function().offset == 1);
+		CHECK(first.at(2) == 20);
+	}
+
+	SECTION("assignment keeps each side's resource")
+	{
+		CountingResource mine, theirs;
+		{
+			frozen_dictionary<int, int> frozen({ { 1, 1 } }, {}, {}, memory_resource_ptr{ &mine });
+			const frozen_dictionary<int, int> other({ { 2, 2 }, { 3, 3 } }, {}, {}, memory_resource_ptr{ &theirs });
+			const auto theirAllocations = theirs.allocations;
+
+			frozen = other;
+			CHECK(theirs.allocations == theirAllocations);
+			CHECK(frozen.at(2) == 2);
+			CHECK(frozen.get_allocator().resource() == memory_resource_ptr{ &mine });
+
+			auto copy = other;
+			CHECK(copy.get_allocator().resource() == memory_resource_ptr{ &theirs });
+
+			frozen = std::move(copy);
+			CHECK(theirs.allocations == theirAllocations + 2);
+			CHECK(frozen.at(3) == 3);
+			CHECK(copy.empty());
+
+			frozen_dictionary<int, int> moved(std::move(frozen), memory_resource_ptr{ &mine });
+			CHECK(moved.at(2) == 2);
+			CHECK(frozen.empty());
+		}
+		CHECK(mine.live == 0);
+		CHECK(theirs.live == 0);
+	}
+}
@@ -0,0 +1,180 @@
+// <Containers/HashSet.hpp>
+
+#include <Containers/HashSet.hpp>
+#include "../../Instrumented.h"
+#include <catch.hpp>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iterator>
+
+TEST_CASE("HashSet")
+{
+	using namespace Yupei;
+
+	SECTION("basic operations")
+	{
+		hash_set<std::string> set;
+		CHECK(set.empty());
+		CHECK(set.begin() == set.end());
+		CHECK(!set.contains("1"));
+		CHECK(set.insert("1").second);
+		CHECK(!set.insert("1").second);
+		CHECK(set.emplace(3, 'x').second);
+		CHECK(set.size() == 2);
+		CHECK(set.contains("xxx"));
+		CHECK(set.count("1") == 1);
+		CHECK(*set.find("1") == "1");
+		CHECK(set.find("2") == set.end());
+
+		for (int i = 0; i < 100; ++i)
+			set.insert(std::to_string(i));
+		CHECK(set.size() == 101);
+		CHECK(set.erase("xxx"));
+		CHECK(!set.erase("xxx"));
+		CHECK(set.size() == 100);
+
+		auto it = set.begin();
+		std::size_t n = 0;
+		while (it != set.end())
+		{
+			if (it->size() == 1)
+				it = set.erase(it);
+			else
+				++it;
+			++n;
+		}
+		CHECK(n == 100);
+		CHECK(set.size() == 90);
+		CHECK(std::distance(set.begin(), set.end()) == 90);
+
+		set.clear();
+		CHECK(set.empty());
+		CHECK(set.insert("a").second);
+	}
+
+	SECTION("insert_range")
+	{
+		std::vector<int> values;
+		for (int i = 0; i < 1000; ++i)
+			values.push_back(i % 300);
+		hash_set<int> set;
+		set.insert_range(values.begin(), values.end());
+		CHECK(set.size() == 300);
+		for (int i = 0; i < 300; ++i)
+			CHECK(set.contains(i));
+		CHECK(!set.contains(300));
+
+		std::istringstream input { "1 2 3 2 1" };
+		hash_set<int> set2;
+		set2.insert_range(std::istream_iterator<int>{ input }, std::istream_iterator<int>{});
+		CHECK(set2.size() == 3);
+
+		hash_set<int> set3 { 1, 2, 3 };
+		CHECK(set2 == set3);
+	}
+
+	SECTION("copy and move")
+	{
+		hash_set<std::string> set;
+		for (int i = 0; i < 50; ++i)
+			set.insert(std::to_string(i));
+		set.erase("7");
+		auto copy = set;
+		CHECK(copy == set);
+		copy.insert("7");
+		CHECK(copy != set);
+
+		auto moved = std::move(copy);
+		CHECK(moved.size() == 50);
+		CHECK(copy.empty());
+		CHECK(!copy.contains("7"));
+		CHECK(copy.insert("7").second);
+
+		copy = moved;
+		CHECK(copy == moved);
+		swap(copy, set);
+		CHECK(set.size() == 50);
+		CHECK(copy.size() == 49);
+	}
+
+	SECTION("set algebra")
+	{
+		hash_set<int> small { 1, 2, 3, 100 };
+		hash_set<int> large;
+		for (int i = 0; i < 50; ++i)
+			large.insert(i);
+
+		const auto u = set_union(small, large);
+		CHECK(u.size() == 51);
+		CHECK(u.contains(100));
+		CHECK(set_union(large, small) == u);
+
+		const auto i = set_intersection(small, large);
+		CHECK(i == (hash_set<int>{ 1, 2, 3 }));
+		CHECK(set_intersection(large, small) == i);
+
+		CHECK(set_difference(small, large) == hash_set<int>{ 100 });
+		const auto d = set_difference(large, small);
+		CHECK(d.size() == 47);
+		CHECK(!d.contains(1));
+		CHECK(d.contains(0));
+
+		CHECK(i.is_subset_of(small));
+		CHECK(i.is_subset_of(large));
+		CHECK(!small.is_subset_of(large));
+
+		auto s = small;
+		s.union_with(large);
+		CHECK(s == u);
+		s = small;
+		s.intersect_with(large);
+		CHECK(s == i);
+		s = large;
+		s.intersect_with(small);
+		CHECK(s == i);
+		s = large;
+		s.except_with(small);
+		CHECK(s == d);
+		s.except_with(s);
+		CHECK(s.empty());
+
+		s = small;
+		s.union_with(hash_set<int>{ large });
+		CHECK(s == u);
+	}
+
+	SECTION("union_with and assignment keep this set's resource")
+	{
+		CountingResource mine, theirs;
+		{
+			hash_set<int> s({ 1, 2 }, memory_resource_ptr{ &mine });
+			hash_set<int> other(memory_resource_ptr{ &theirs });
+			for (int i = 0; i < 100; ++i)
+				other.insert(i);
+			const auto theirAllocations = theirs.allocations;
+
+			s.union_with(other);
+			CHECK(s.size() == 100);
+			CHECK(other.size() == 100);
+			CHECK(theirs.allocations == theirAllocations);
+
+			hash_set<int> more(memory_resource_ptr{ &theirs });
+			for (int i = 100; i < 300; ++i)
+				more.insert(i);
+			const auto moreAllocations = theirs.allocations;
+			s.union_with(std::move(more));
+			CHECK(s.size() == 300);
+			CHECK(theirs.allocations == moreAllocations);
+
+			hash_set<int> copy(memory_resource_ptr{ &mine });
+			copy = other;
+			CHECK(copy == other);
+			copy = std::move(other);
+			CHECK(copy.size() == 100);
+			CHECK(theirs.allocations == moreAllocations);
+		}
+		CHECK(mine.live == 0);
+		CHECK(theirs.live == 0);
+	}
+}
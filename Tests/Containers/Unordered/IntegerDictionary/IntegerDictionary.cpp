@@ -0,0 +1,150 @@
+// <Containers/IntegerDictionary.hpp>
+
+#include <Containers/IntegerDictionary.hpp>
+#include "../../Instrumented.h"
+#include <catch.hpp>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+TEST_CASE("IntegerDictionary")
+{
+	using namespace Yupei;
+
+	SECTION("basic operations")
+	{
+		integer_dictionary<std::uint64_t, std::string> dict;
+		CHECK(dict.empty());
+		CHECK(dict.capacity() == 0);
+		CHECK(dict.find(1) == dict.end());
+		CHECK(!dict.erase(1));
+
+		CHECK(dict.insert({ 1, "1" }).second);
+		CHECK(!dict.insert({ 1, "one" }).second);
+		CHECK(dict.try_emplace(2, "2").second);
+		CHECK(!dict.insert_or_assign(2, "two").second);
+		CHECK(dict.insert_or_assign(3, "3").second);
+		dict[4] = "4";
+		CHECK(dict.size() == 4);
+		CHECK((dict.capacity() & (dict.capacity() - 1)) == 0);
+
+		CHECK(dict.at(1) == "1");
+		CHECK(dict.at(2) == "two");
+		CHECK(dict.find(3)->second == "3");
+		CHECK(dict.find(4)->first == 4);
+		CHECK(dict.contains(4));
+		CHECK_THROWS_AS(dict.at(5), std::out_of_range);
+
+		CHECK(dict.erase(1));
+		CHECK(!dict.contains(1));
+		CHECK(dict.size() == 3);
+
+		std::uint64_t sum = 0;
+		for (auto kv : dict)
+		{
+			sum += kv.first;
+			kv.second += "!";
+		}
+		CHECK(sum == 9);
+		CHECK(dict.at(4) == "4!");
+
+		dict.clear();
+		CHECK(dict.empty());
+		CHECK(dict.begin() == dict.end());
+	}
+
+	SECTION("matches std::unordered_map under random operations")
+	{
+		integer_dictionary<std::uint32_t, int> dict;
+		std::unordered_map<std::uint32_t, int> reference;
+		std::uint32_t state = 12345;
+		for (int step = 0; step < 20000; ++step)
+		{
+			state = state * 1664525u + 1013904223u;
+			const auto key = (state >> 8) % 2000;
+			if ((state & 3) == 0)
+				CHECK(dict.erase(key) == (reference.erase(key) == 1));
+			else
+			{
+				dict[key] += step;
+				reference[key] += step;
+			}
+		}
+		CHECK(dict.size() == reference.size());
+		CHECK(dict.load_factor() <= dict.max_load_factor());
+		bool same = true;
+		for (const auto& kv : reference)
+			same = same && dict.contains(kv.first) && dict.at(kv.first) == kv.second;
+		CHECK(same);
+	}
+
+	SECTION("empty key sentinel")
+	{
+		using Sentinel = std::integral_constant<std::int64_t, -1>;
+		integer_dictionary<std::int64_t, int, Sentinel> dict;
+		for (std::int64_t i = 0; i < 1000; ++i)
+			dict.try_emplace(i, static_cast<int>(i) * 2);
+		for (std::int64_t i = 0; i < 1000; i += 2)
+			dict.erase(i);
+		CHECK(dict.size() == 500);
+		for (std::int64_t i = 1; i < 1000; i += 2)
+			CHECK(dict.at(i) == i * 2);
+		CHECK(!dict.contains(-1));
+		CHECK_THROWS_AS(dict.try_emplace(-1, 0), std::invalid_argument);
+	}
+
+	SECTION("copy, move and reserve")
+	{
+		integer_dictionary<int, std::string> a { { 1, "1" }, { 2, "2" } };
+		auto b = a;
+		b[1] = "one";
+		CHECK(a.at(1) == "1");
+		CHECK(b.at(1) == "one");
+
+		auto c = std::move(b);
+		CHECK(c.at(1) == "one");
+		CHECK(b.empty());
+
+		c.reserve(1000);
+		const auto capacity = c.capacity();
+		for (int i = 0; i < 1000; ++i)
+			c.try_emplace(i, std::to_string(i));
+		CHECK(c.capacity() == capacity);
+		CHECK(c.at(999) == "999");
+
+		a = c;
+		CHECK(a.size() == 1000);
+	}
+
+	SECTION("copy keeps the source's resource, assignment keeps the destination's")
+	{
+		CountingResource left, right;
+		{
+			integer_dictionary<int, std::string> a(memory_resource_ptr{ &left });
+			for (int i = 0; i < 100; ++i)
+				a.try_emplace(i, std::to_string(i) + " long enough string");
+
+			auto copy = a;
+			CHECK(copy.at(42) == "42 long enough string");
+
+			integer_dictionary<int, std::string> b(memory_resource_ptr{ &right });
+			b = a;
+			CHECK(b.size() == 100);
+			b = std::move(copy);
+			CHECK(b.size() == 100);
+			CHECK(copy.empty());
+			CHECK(b.at(99) == "99 long enough string");
+			b.try_emplace(100, "100");
+			CHECK(b.at(100) == "100");
+		}
+		CHECK(left.live == 0);
+		CHECK(right.live == 0);
+	}
+
+	SECTION("auto_dictionary selects by key type")
+	{
+		CHECK((std::is_same<auto_dictionary<int, int>, integer_dictionary<int, int>>::value));
+		CHECK((std::is_same<auto_dictionary<std::string, int>, dictionary<std::string, int>>::value));
+	}
+}
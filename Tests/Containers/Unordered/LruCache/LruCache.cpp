@@ -0,0 +1,253 @@
+// <Containers/LruCache.hpp>
+
+#include <Containers/LruCache.hpp>
+#include <MemoryResource/MemoryResource.hpp>
+#include <catch.hpp>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	struct StringBytes
+	{
+		std::size_t operator()(int, const std::string& value) const noexcept
+		{
+			return value.size();
+		}
+	};
+
+	//Moving steals the string, so a throwing move would leave the source broken.
+	struct StealingValue
+	{
+		static int transfersLeft;
+		std::string value;
+
+		StealingValue(const char* s) : value(s) {}
+		StealingValue(const StealingValue& other) : value(other.value)
+		{
+			if (transfersLeft-- <= 0)
+				throw std::runtime_error("copy");
+		}
+		StealingValue(StealingValue&& other)
+		{
+			if (transfersLeft-- <= 0)
+				throw std::runtime_error("move");
+			value = std::move(other.value);
+		}
+		StealingValue& operator=(const StealingValue&) = default;
+		StealingValue& operator=(StealingValue&&) = default;
+	};
+
+	int StealingValue::transfersLeft = 1000;
+
+	struct StealingValueBytes
+	{
+		std::size_t operator()(int, const StealingValue& value) const noexcept
+		{
+			return value.value.size();
+		}
+	};
+
+	class FailingResource : public Yupei::memory_resource
+	{
+	public:
+		std::size_t allocations = 0;
+		std::size_t failAt = 0;
+		std::size_t live = 0;
+
+	protected:
+		void* do_allocate(size_type bytes, size_type alignment) override
+		{
+			if (++allocations == failAt)
+				throw std::bad_alloc {};
+			++live;
+			return Yupei::new_delete_resource()->allocate(bytes, alignment);
+		}
+
+		void do_deallocate(void* p, size_type bytes, size_type alignment) noexcept override
+		{
+			--live;
+			Yupei::new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+
+		bool do_is_equal(const memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+	};
+}
+
+TEST_CASE("LruCache")
+{
+	using namespace Yupei;
+
+	SECTION("lru_cache evicts the least recently used")
+	{
+		lru_cache<int, std::string> cache(3);
+		CHECK(cache.put(1, "1"));
+		CHECK(cache.put(2, "2"));
+		CHECK(cache.put(3, "3"));
+		CHECK(cache.size() == 3);
+
+		REQUIRE(cache.get(1) != nullptr);
+		CHECK(*cache.get(1) == "1");
+		CHECK(cache.put(4, "4"));
+		CHECK(cache.size() == 3);
+		CHECK(!cache.contains(2));
+		CHECK(cache.contains(1));
+
+		CHECK(!cache.put(3, "three"));
+		CHECK(cache.put(5, "5"));
+		CHECK(!cache.contains(1));
+		CHECK(*cache.peek(3) == "three");
+		CHECK(cache.contains(4));
+
+		CHECK(cache.erase(4));
+		CHECK(!cache.erase(4));
+		CHECK(cache.size() == 2);
+		CHECK(cache.get(4) == nullptr);
+
+		cache.clear();
+		CHECK(cache.empty());
+		CHECK(cache.put(6, "6"));
+		CHECK(*cache.get(6) == "6");
+	}
+
+	SECTION("lru_cache with many keys")
+	{
+		lru_cache<int, int> cache(100);
+		for (int i = 0; i < 10000; ++i)
+		{
+			cache.put(i, i * 2);
+			cache.get(i / 2);
+		}
+		CHECK(cache.size() == 100);
+		CHECK(*cache.peek(9999) == 19998);
+		CHECK(cache.peek(0) == nullptr);
+	}
+
+	SECTION("lru_cache capacity in bytes")
+	{
+		lru_cache<int, std::string, hash<>, std::equal_to<int>, StringBytes> cache(10);
+		cache.put(1, "aaaa");
+		cache.put(2, "bbbb");
+		CHECK(cache.weight() == 8);
+		cache.put(3, "cccc");
+		CHECK(cache.weight() == 8);
+		CHECK(!cache.contains(1));
+
+		cache.put(2, "bbbbbbbb");
+		CHECK(cache.weight() == 8);
+		CHECK(cache.size() == 1);
+		CHECK(!cache.contains(3));
+
+		for (int i = 0; i < 100; ++i)
+			cache.put(i, "x");
+		CHECK(cache.size() == 10);
+		CHECK(cache.weight() == 10);
+
+		cache.put(1000, std::string(20, 'y'));
+		CHECK(cache.size() == 1);
+	}
+
+	SECTION("failed growth leaves the cache intact")
+	{
+		FailingResource resource;
+		{
+			lru_cache<int, std::string, hash<>, std::equal_to<int>, StringBytes> cache(1000, {}, {}, {}, Yupei::memory_resource_ptr { &resource });
+			int inserted = 0;
+			for (std::size_t failAt = resource.allocations + 2;; ++inserted)
+			{
+				resource.failAt = failAt;
+				try
+				{
+					cache.put(inserted, "x");
+				}
+				catch (const std::bad_alloc&)
+				{
+					break;
+				}
+			}
+			CHECK(cache.size() == static_cast<std::size_t>(inserted));
+			for (int i = 0; i < inserted; ++i)
+				CHECK(cache.contains(i));
+
+			resource.failAt = 0;
+			for (int i = inserted; i < inserted + 100; ++i)
+				cache.put(i, "x");
+			CHECK(cache.size() == static_cast<std::size_t>(inserted + 100));
+		}
+		CHECK(resource.live == 0);
+	}
+
+	SECTION("growth copies values whose move may throw")
+	{
+		//a weigher keeps the table from reserving all entries up front
+		lru_cache<int, StealingValue, hash<>, std::equal_to<int>, StealingValueBytes> cache(100000);
+		int inserted = 0;
+		for (; inserted < 1000; ++inserted)
+		{
+			//enough for small tables, so the throw comes halfway through a later growth
+			StealingValue::transfersLeft = 6;
+			try
+			{
+				cache.put(inserted, "a string long enough to live on the heap");
+			}
+			catch (const std::runtime_error&)
+			{
+				break;
+			}
+		}
+		StealingValue::transfersLeft = 1000;
+		REQUIRE(inserted > 0);
+		REQUIRE(inserted < 1000);
+		CHECK(cache.size() == static_cast<std::size_t>(inserted));
+		for (int i = 0; i < inserted; ++i)
+		{
+			REQUIRE(cache.peek(i) != nullptr);
+			CHECK(cache.peek(i)->value == "a string long enough to live on the heap");
+		}
+	}
+
+	SECTION("clock_cache gives referenced entries a second chance")
+	{
+		clock_cache<int, std::string> cache(3);
+		CHECK(cache.put(1, "1"));
+		CHECK(cache.put(2, "2"));
+		CHECK(cache.put(3, "3"));
+
+		CHECK(*cache.get(1) == "1");
+		CHECK(cache.put(4, "4"));
+		CHECK(cache.size() == 3);
+		CHECK(cache.contains(1));
+		CHECK(!cache.contains(2));
+
+		CHECK(!cache.put(3, "three"));
+		CHECK(*cache.peek(3) == "three");
+		CHECK(cache.erase(1));
+		CHECK(cache.size() == 2);
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			cache.put(i, std::to_string(i));
+			cache.get(i / 3);
+		}
+		CHECK(cache.size() == 3);
+		CHECK(*cache.peek(999) == "999");
+
+		cache.clear();
+		CHECK(cache.empty());
+	}
+
+	SECTION("clock_cache capacity in bytes")
+	{
+		clock_cache<int, std::string, hash<>, std::equal_to<int>, StringBytes> cache(10);
+		for (int i = 0; i < 100; ++i)
+			cache.put(i, "xy");
+		CHECK(cache.size() == 5);
+		CHECK(cache.weight() == 10);
+		cache.put(99, std::string(10, 'z'));
+		CHECK(cache.size() == 1);
+	}
+}
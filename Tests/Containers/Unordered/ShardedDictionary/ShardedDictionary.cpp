@@ -0,0 +1,83 @@
+// <Containers/ShardedDictionary.hpp>
+
+#include <Containers/ShardedDictionary.hpp>
+#include <catch.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("ShardedDictionary")
+{
+	using namespace Yupei;
+
+	SECTION("handles, merge and partitions")
+	{
+		sharded_dictionary<int, int, 8> dict(2);
+		CHECK(dict.partition_count() == 8);
+		CHECK(dict.handle_count() == 2);
+
+		CHECK(dict.handle(0).try_emplace(1, 10));
+		CHECK(!dict.handle(0).try_emplace(1, 11));
+		CHECK(dict.handle(0).upsert(2, [](int& v) { v += 2; }));
+		CHECK(dict.handle(1).insert_or_assign(1, 5));
+		CHECK(!dict.handle(1).insert_or_assign(1, 6));
+		CHECK(dict.handle(1).upsert(3, [](int& v) { v += 3; }));
+		CHECK(dict.handle(0).size() == 2);
+		CHECK(dict.size() == 0);
+
+		dict.merge_with([](int& existing, int&& incoming) { existing += incoming; });
+		CHECK(dict.size() == 3);
+		CHECK(dict.handle(0).size() == 0);
+		CHECK(dict.handle(1).size() == 0);
+		CHECK(dict.at(1) == 16);
+		CHECK(dict.at(2) == 2);
+		CHECK(dict.at(3) == 3);
+		CHECK(!dict.contains(4));
+
+		for (int key = 1; key <= 3; ++key)
+			CHECK(dict.partition(dict.partition_of(key)).find(key) != dict.partition(dict.partition_of(key)).end());
+
+		dict.handle(1).try_emplace(1, 100);
+		dict.handle(1).try_emplace(4, 4);
+		dict.merge_with([](int& existing, int&& incoming) { existing += incoming; });
+		CHECK(dict.size() == 4);
+		CHECK(dict.at(1) == 116);
+		CHECK(dict.at(4) == 4);
+	}
+
+	SECTION("parallel aggregation")
+	{
+		constexpr int kThreads = 4;
+		constexpr int kKeys = 500;
+		sharded_dictionary<std::string, int, 16> dict(kThreads);
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < kThreads; ++t)
+			threads.emplace_back([&dict, t] {
+				auto& handle = dict.handle(t);
+				for (int i = 0; i < kKeys; ++i)
+					handle.upsert(std::to_string(i), [](int& v) { ++v; });
+			});
+		for (auto& thread : threads)
+			thread.join();
+
+		dict.merge_with([](int& existing, int&& incoming) { existing += incoming; });
+		CHECK(dict.size() == kKeys);
+		for (int i = 0; i < kKeys; ++i)
+			CHECK(dict.at(std::to_string(i)) == kThreads);
+
+		std::atomic<std::size_t> visited { 0 };
+		std::atomic<bool> partitioned { true };
+		dict.parallel_for_each([&](std::size_t p, const dictionary<std::string, int>& partition) {
+			for (const auto& kv : partition)
+			{
+				++visited;
+				if (dict.partition_of(kv.first) != p)
+					partitioned = false;
+			}
+		});
+		CHECK(visited == kKeys);
+		CHECK(partitioned);
+	}
+}
@@ -0,0 +1,145 @@
+// <Containers/SmallDictionary.hpp>
+
+#include <Containers/SmallDictionary.hpp>
+#include "../../Instrumented.h"
+#include <catch.hpp>
+#include <string>
+#include <utility>
+
+TEST_CASE("SmallDictionary")
+{
+	using namespace Yupei;
+
+	SECTION("inline operations")
+	{
+		small_dictionary<int, std::string, 4> dict;
+		CHECK(dict.empty());
+		CHECK(dict.is_inline());
+		CHECK(dict.begin() == dict.end());
+
+		CHECK(dict.insert({ 1, "1" }).second);
+		CHECK(!dict.insert({ 1, "one" }).second);
+		CHECK(dict.try_emplace(2, "2").second);
+		CHECK(!dict.insert_or_assign(2, "two").second);
+		dict[3] = "3";
+		CHECK(dict.size() == 3);
+		CHECK(dict.is_inline());
+
+		CHECK(dict.at(1) == "1");
+		CHECK(dict.at(2) == "two");
+		CHECK(dict.find(3)->second == "3");
+		CHECK(dict.find(4) == dict.end());
+		CHECK_THROWS_AS(dict.at(4), std::out_of_range);
+
+		CHECK(dict.erase(1));
+		CHECK(!dict.erase(1));
+		CHECK(dict.size() == 2);
+		CHECK(dict.contains(2));
+		CHECK(dict.contains(3));
+
+		int sum = 0;
+		for (const auto& kv : dict)
+			sum += kv.first;
+		CHECK(sum == 5);
+	}
+
+	SECTION("spill to dictionary")
+	{
+		small_dictionary<int, std::string, 4> dict;
+		for (int i = 0; i < 4; ++i)
+			dict.insert({ i, std::to_string(i) });
+		CHECK(dict.is_inline());
+
+		const auto result = dict.insert({ 4, "4" });
+		CHECK(result.second);
+		CHECK(result.first->second == "4");
+		CHECK(!dict.is_inline());
+
+		for (int i = 5; i < 100; ++i)
+			dict[i] = std::to_string(i);
+		CHECK(dict.size() == 100);
+		for (int i = 0; i < 100; ++i)
+			CHECK(dict.at(i) == std::to_string(i));
+
+		std::size_t visited = 0;
+		for (auto& kv : dict)
+		{
+			kv.second += "!";
+			++visited;
+		}
+		CHECK(visited == 100);
+		CHECK(dict.at(42) == "42!");
+
+		CHECK(dict.erase(42));
+		CHECK(!dict.contains(42));
+		CHECK(!dict.insert_or_assign(1, "uno").second);
+		CHECK(dict.at(1) == "uno");
+
+		dict.clear();
+		CHECK(dict.is_inline());
+		CHECK(dict.empty());
+	}
+
+	SECTION("copy and move")
+	{
+		small_dictionary<int, std::string, 2> small { { 1, "1" } };
+		small_dictionary<int, std::string, 2> large { { 1, "1" }, { 2, "2" }, { 3, "3" } };
+		CHECK(small.is_inline());
+		CHECK(!large.is_inline());
+
+		auto smallCopy = small;
+		auto largeCopy = large;
+		CHECK(smallCopy.at(1) == "1");
+		CHECK(largeCopy.at(3) == "3");
+		largeCopy[3] = "three";
+		CHECK(large.at(3) == "3");
+
+		auto moved = std::move(largeCopy);
+		CHECK(moved.at(3) == "three");
+		CHECK(largeCopy.empty());
+
+		moved = small;
+		CHECK(moved.is_inline());
+		CHECK(moved.size() == 1);
+
+		smallCopy.swap(large);
+		CHECK(smallCopy.size() == 3);
+		CHECK(large.size() == 1);
+
+		const auto& constRef = smallCopy;
+		small_dictionary<int, std::string, 2>::const_iterator it = constRef.find(2);
+		CHECK(it->second == "2");
+	}
+
+	SECTION("assignment and swap keep each side's resource")
+	{
+		using Dict = small_dictionary<int, std::string, 2>;
+		CountingResource left, right;
+		{
+			Dict a({ { 1, "1" }, { 2, "2" }, { 3, "3" } }, {}, {}, memory_resource_ptr{ &left });
+			Dict b({ { 4, "4" }, { 5, "5" }, { 6, "6" }, { 7, "7" } }, {}, {}, memory_resource_ptr{ &right });
+			REQUIRE(!a.is_inline());
+			REQUIRE(!b.is_inline());
+
+			auto copy = a;
+			CHECK(copy.at(3) == "3");
+
+			a.swap(b);
+			CHECK(a.size() == 4);
+			CHECK(b.size() == 3);
+			CHECK(a.at(7) == "7");
+			CHECK(b.at(1) == "1");
+
+			Dict c(memory_resource_ptr{ &right });
+			c = b;
+			CHECK(c.size() == 3);
+			c = std::move(a);
+			CHECK(c.size() == 4);
+			CHECK(a.empty());
+			c.insert({ 8, "8" });
+			CHECK(c.at(8) == "8");
+		}
+		CHECK(left.live == 0);
+		CHECK(right.live == 0);
+	}
+}
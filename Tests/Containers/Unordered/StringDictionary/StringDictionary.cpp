@@ -0,0 +1,118 @@
+// <Containers/StringDictionary.hpp>
+
+#include <Containers/StringDictionary.hpp>
+#include "../../Instrumented.h"
+#include <catch.hpp>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+TEST_CASE("StringDictionary")
+{
+	using namespace Yupei;
+
+	SECTION("basic operations")
+	{
+		string_dictionary<int> dict;
+		CHECK(dict.empty());
+
+		std::string key = "a fairly long key";
+		CHECK(dict.try_emplace(key, 1).second);
+		key[0] = 'b';
+		CHECK(dict.contains("a fairly long key"));
+		CHECK(!dict.contains(key));
+
+		CHECK(!dict.try_emplace("a fairly long key", 2).second);
+		CHECK(dict.at("a fairly long key") == 1);
+		CHECK(!dict.insert_or_assign("a fairly long key", 3).second);
+		CHECK(dict.at("a fairly long key") == 3);
+
+		dict["short"] = 4;
+		dict[""] = 5;
+		CHECK(dict.size() == 3);
+		CHECK(dict.at("short") == 4);
+		CHECK(dict.at("") == 5);
+		CHECK_THROWS_AS(dict.at("missing"), std::out_of_range);
+		CHECK(dict.find("shor") == dict.end());
+		CHECK(dict.find(std::string_view("short\0", 6)) == dict.end());
+
+		CHECK(dict.erase("short"));
+		CHECK(!dict.erase("short"));
+		CHECK(dict.size() == 2);
+
+		dict.clear();
+		CHECK(dict.empty());
+		CHECK(!dict.contains(""));
+	}
+
+	SECTION("same prefix")
+	{
+		string_dictionary<int> dict;
+		for (int i = 0; i < 1000; ++i)
+			dict.try_emplace("common_prefix_" + std::to_string(i), i);
+		CHECK(dict.size() == 1000);
+		for (int i = 0; i < 1000; ++i)
+			CHECK(dict.at("common_prefix_" + std::to_string(i)) == i);
+		CHECK(!dict.contains("common_prefix_"));
+		CHECK(!dict.contains("common_p"));
+
+		int sum = 0;
+		for (auto&& kv : dict)
+		{
+			std::string_view key = kv.first;
+			CHECK(key.substr(0, 14) == "common_prefix_");
+			CHECK(std::stoi(std::string(key.substr(14))) == kv.second);
+			sum += kv.second;
+		}
+		CHECK(sum == 999 * 1000 / 2);
+	}
+
+	SECTION("copy and move")
+	{
+		string_dictionary<std::string> dict{ { "one", "1" }, { "a much longer key", "2" } };
+		auto copy = dict;
+		dict.clear();
+		CHECK(copy.size() == 2);
+		CHECK(copy.at("one") == "1");
+		CHECK(copy.at("a much longer key") == "2");
+
+		auto moved = std::move(copy);
+		CHECK(moved.at("a much longer key") == "2");
+		CHECK(copy.empty());
+		copy["x"] = "y";
+		CHECK(copy.at("x") == "y");
+
+		dict = moved;
+		moved.clear();
+		CHECK(dict.size() == 2);
+		CHECK(dict.at("one") == "1");
+	}
+
+	SECTION("assignment keeps the destination's resource")
+	{
+		CountingResource left, right;
+		{
+			string_dictionary<std::string> a(memory_resource_ptr{ &left });
+			for (int i = 0; i < 50; ++i)
+				a.try_emplace(std::to_string(i) + " long enough key", std::to_string(i));
+
+			string_dictionary<std::string> b(memory_resource_ptr{ &right });
+			b = a;
+			CHECK(b.size() == 50);
+			CHECK(b.at("7 long enough key") == "7");
+
+			string_dictionary<std::string> c(memory_resource_ptr{ &right });
+			c = std::move(a);
+			CHECK(c.size() == 50);
+			CHECK(a.empty());
+			CHECK(c.at("49 long enough key") == "49");
+			a["x"] = "y";
+			CHECK(a.at("x") == "y");
+
+			c.swap(b);
+			CHECK(c.at("7 long enough key") == "7");
+		}
+		CHECK(left.live == 0);
+		CHECK(right.live == 0);
+	}
+}